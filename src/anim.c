@@ -0,0 +1,152 @@
+#include "anim.h"
+
+const uint8_t anim_breath[256] = {
+    128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+    176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+    176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+    128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+     79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+     37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+     10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+      0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+     10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+     37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+     79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+};
+
+const uint8_t anim_gamma[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// r = 255 * p / 100, g = 255 * (100 - p) / 100, b = 0
+const anim_rgb_t anim_battery_ramp[101] = {
+    {  0, 255, 0},
+    {  2, 252, 0},
+    {  5, 249, 0},
+    {  7, 247, 0},
+    { 10, 244, 0},
+    { 12, 242, 0},
+    { 15, 239, 0},
+    { 17, 237, 0},
+    { 20, 234, 0},
+    { 22, 232, 0},
+    { 25, 229, 0},
+    { 28, 226, 0},
+    { 30, 224, 0},
+    { 33, 221, 0},
+    { 35, 219, 0},
+    { 38, 216, 0},
+    { 40, 214, 0},
+    { 43, 211, 0},
+    { 45, 209, 0},
+    { 48, 206, 0},
+    { 51, 204, 0},
+    { 53, 201, 0},
+    { 56, 198, 0},
+    { 58, 196, 0},
+    { 61, 193, 0},
+    { 63, 191, 0},
+    { 66, 188, 0},
+    { 68, 186, 0},
+    { 71, 183, 0},
+    { 73, 181, 0},
+    { 76, 178, 0},
+    { 79, 175, 0},
+    { 81, 173, 0},
+    { 84, 170, 0},
+    { 86, 168, 0},
+    { 89, 165, 0},
+    { 91, 163, 0},
+    { 94, 160, 0},
+    { 96, 158, 0},
+    { 99, 155, 0},
+    {102, 153, 0},
+    {104, 150, 0},
+    {107, 147, 0},
+    {109, 145, 0},
+    {112, 142, 0},
+    {114, 140, 0},
+    {117, 137, 0},
+    {119, 135, 0},
+    {122, 132, 0},
+    {124, 130, 0},
+    {127, 127, 0},
+    {130, 124, 0},
+    {132, 122, 0},
+    {135, 119, 0},
+    {137, 117, 0},
+    {140, 114, 0},
+    {142, 112, 0},
+    {145, 109, 0},
+    {147, 107, 0},
+    {150, 104, 0},
+    {153, 102, 0},
+    {155,  99, 0},
+    {158,  96, 0},
+    {160,  94, 0},
+    {163,  91, 0},
+    {165,  89, 0},
+    {168,  86, 0},
+    {170,  84, 0},
+    {173,  81, 0},
+    {175,  79, 0},
+    {178,  76, 0},
+    {181,  73, 0},
+    {183,  71, 0},
+    {186,  68, 0},
+    {188,  66, 0},
+    {191,  63, 0},
+    {193,  61, 0},
+    {196,  58, 0},
+    {198,  56, 0},
+    {201,  53, 0},
+    {204,  51, 0},
+    {206,  48, 0},
+    {209,  45, 0},
+    {211,  43, 0},
+    {214,  40, 0},
+    {216,  38, 0},
+    {219,  35, 0},
+    {221,  33, 0},
+    {224,  30, 0},
+    {226,  28, 0},
+    {229,  25, 0},
+    {232,  22, 0},
+    {234,  20, 0},
+    {237,  17, 0},
+    {239,  15, 0},
+    {242,  12, 0},
+    {244,  10, 0},
+    {247,   7, 0},
+    {249,   5, 0},
+    {252,   2, 0},
+    {255,   0, 0},
+};
+
+void anim_phase_init(anim_phase_t *p, uint32_t period_ms, uint32_t now_ms)
+{
+    if (period_ms < 2) period_ms = 2;
+    p->phase = 0;
+    p->step_per_ms = (uint32_t)((1ull << 32) / period_ms);
+    p->last_ms = now_ms;
+}
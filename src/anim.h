@@ -0,0 +1,61 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <stdint.h>
+
+// ==============================
+//  Shared animation tables
+// ==============================
+//
+// Const lookup tables for the LED bar and OLED battery icon, so per-frame
+// animation is table lookups and integer adds instead of float trig (we
+// build with -O0, where every libm call shows up). Phases are 32-bit
+// accumulators: the top 8 bits index a 256-entry table, and wrap-around is
+// the period.
+//
+
+// One period of (sin(2*pi*i/256) + 1) / 2, scaled to 0..255
+extern const uint8_t anim_breath[256];
+
+// Perceptual brightness: 255 * (i/255)^2.2
+extern const uint8_t anim_gamma[256];
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} anim_rgb_t;
+
+// Battery colour for 0-100%. Red tracks charge and green its absence, to
+// match the strip's (swapped) wiring: green at 0%, red at 100%.
+extern const anim_rgb_t anim_battery_ramp[101];
+
+typedef struct {
+    uint32_t phase;
+    uint32_t step_per_ms;   // 2^32 / period_ms
+    uint32_t last_ms;
+} anim_phase_t;
+
+// Start a phase at 0 with the given period
+void anim_phase_init(anim_phase_t *p, uint32_t period_ms, uint32_t now_ms);
+
+// Advance to now_ms and return the 8-bit table index
+static inline uint8_t anim_phase_advance(anim_phase_t *p, uint32_t now_ms)
+{
+    p->phase += (now_ms - p->last_ms) * p->step_per_ms;
+    p->last_ms = now_ms;
+    return (uint8_t)(p->phase >> 24);
+}
+
+// Scale an 8-bit channel by an 8-bit level (255 = unchanged), no division
+static inline uint8_t anim_scale8(uint8_t value, uint8_t level)
+{
+    return (uint8_t)(((uint16_t)value * (uint16_t)(level + 1)) >> 8);
+}
+
+static inline const anim_rgb_t *anim_battery_color(uint8_t percent)
+{
+    return &anim_battery_ramp[percent > 100 ? 100 : percent];
+}
+
+#endif // ANIM_H
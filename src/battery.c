@@ -0,0 +1,113 @@
+#include "battery.h"
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+
+#include "events.h"
+#include "log.h"
+#include "max17048.h"
+
+static battery_state_t s_state;
+static uint32_t s_next_ms;          // fallback read due
+static bool s_alerts_ok;            // config_alerts() has succeeded
+
+static uint8_t battery_clamp_percent(float soc)
+{
+    if (soc < 0.0f) return 0;
+    if (soc > 100.0f) return 100;
+    return (uint8_t)(soc + 0.5f); // round to nearest
+}
+
+static bool battery_config_alerts(void)
+{
+    s_alerts_ok = max17048_config_alerts(BATTERY_LOW_PERCENT) == 0;
+    if (!s_alerts_ok) {
+        LOG_W("MAX17048 alert setup failed; polling every %u s", BATTERY_FALLBACK_MS / 1000u);
+    }
+    return s_alerts_ok;
+}
+
+// Acknowledge a pending alert before reading, so a change landing in
+// between raises a new one rather than being lost
+static void battery_ack_alert(void)
+{
+    uint16_t status = 0;
+    if (max17048_read_status(&status) != 0) return;
+
+    if (status & MAX17048_STATUS_RI) {
+        // The gauge reset (brown-out or cell swap) and lost its alert config
+        LOG_W("MAX17048 reset; reconfiguring alerts");
+        battery_config_alerts();
+        return;
+    }
+    if (status & MAX17048_STATUS_HD) {
+        LOG_W("Battery below %u%%", BATTERY_LOW_PERCENT);
+    }
+    max17048_clear_alerts();
+}
+
+// Without the ALRT line there is no way to tell, so every poll checks
+static inline bool battery_alert_pending(bool alert)
+{
+#if BATTERY_ALRT_FITTED
+    return alert || !gpio_get(BATTERY_ALRT_PIN);
+#else
+    (void)alert;
+    return true;
+#endif
+}
+
+static bool battery_read(uint32_t now_ms)
+{
+    max17048_reading_t r;
+    if (max17048_read(&r) != 0) {
+        s_next_ms = now_ms + BATTERY_RETRY_MS;
+        return false;
+    }
+    s_next_ms = now_ms + BATTERY_FALLBACK_MS;
+
+    uint8_t percent = battery_clamp_percent(r.soc);
+    bool changed = !s_state.valid || percent != s_state.percent || r.soc != s_state.soc;
+    s_state.voltage = r.voltage;
+    s_state.soc = r.soc;
+    s_state.percent = percent;
+    s_state.low = percent <= BATTERY_LOW_PERCENT;
+    s_state.valid = true;
+    return changed;
+}
+
+bool battery_init(void)
+{
+    // Restarts the fuel-gauge estimate (datasheet quick-start)
+    if (quickstart() != 0) {
+        LOG_E("MAX17048 quickstart failed");
+    }
+
+#if BATTERY_ALRT_FITTED
+    gpio_init(BATTERY_ALRT_PIN);
+    gpio_set_dir(BATTERY_ALRT_PIN, GPIO_IN);
+    gpio_pull_up(BATTERY_ALRT_PIN);
+    events_bind_gpio(BATTERY_ALRT_PIN, GPIO_IRQ_EDGE_FALL, EVENT_BATTERY);
+#endif
+
+    battery_config_alerts();
+    return battery_read(to_ms_since_boot(get_absolute_time()));
+}
+
+bool battery_service(uint32_t events, uint32_t now_ms)
+{
+    bool alert = (events & EVENT_BATTERY) != 0;
+    if (!alert && (int32_t)(now_ms - s_next_ms) < 0) return false;
+
+    if (!s_alerts_ok) {
+        battery_config_alerts();
+    } else if (battery_alert_pending(alert)) {
+        battery_ack_alert();
+    }
+    return battery_read(now_ms);
+}
+
+const battery_state_t *battery_get(void)
+{
+    return &s_state;
+}
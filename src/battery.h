@@ -0,0 +1,64 @@
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Battery (MAX17048 fuel gauge, core 0)
+// ==============================
+//
+// The gauge can tell us when something changed instead of being polled: it
+// pulls ALRT low on every 1 % SOC step and when SOC falls below
+// BATTERY_LOW_PERCENT, which posts EVENT_BATTERY. Only then (or every
+// BATTERY_FALLBACK_MS, in case an edge was missed) does battery_service()
+// clear the alert and read voltage and SOC in one burst. Everything else
+// reads the cached battery_get().
+//
+// The current PCB (pcb/pcb/) leaves the MAX17048 ALRT pad on J5
+// unconnected, so by default nothing is bound to the pin and the gauge is
+// read every BATTERY_FALLBACK_MS. Build with BATTERY_ALRT_FITTED=1 once a
+// wire runs from ALRT to BATTERY_ALRT_PIN.
+//
+
+#ifndef BATTERY_ALRT_FITTED
+#define BATTERY_ALRT_FITTED  0
+#endif
+
+// ALRT is open-drain, active low
+#ifndef BATTERY_ALRT_PIN
+#define BATTERY_ALRT_PIN     12
+#endif
+
+// Empty alert threshold (the gauge supports 1-32 %)
+#ifndef BATTERY_LOW_PERCENT
+#define BATTERY_LOW_PERCENT  10
+#endif
+
+// Read anyway this often without an alert, and retry this soon after a
+// failed read
+#define BATTERY_FALLBACK_MS  60000
+#define BATTERY_RETRY_MS     1000
+
+typedef struct {
+    float   voltage;   // cell voltage (V)
+    float   soc;       // state of charge (%)
+    uint8_t percent;   // soc rounded/clamped to 0-100
+    bool    low;       // at or below BATTERY_LOW_PERCENT
+    bool    valid;     // at least one read has succeeded
+} battery_state_t;
+
+// Quick-start the gauge, set up its alerts (and the ALRT pin, if fitted),
+// take a first reading. Returns false if the gauge didn't answer (the
+// fallback keeps retrying).
+bool battery_init(void);
+
+// Call every pass with the events from events_wait(). Touches the bus only
+// on an alert or when the fallback is due; returns true if the cached
+// state changed.
+bool battery_service(uint32_t events, uint32_t now_ms);
+
+// Cached state (no bus traffic)
+const battery_state_t *battery_get(void);
+
+#endif // BATTERY_H
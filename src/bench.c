@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+
+#include "calorie_model.h"
+#include "config.h"
+#include "events.h"
+#include "i2c_bus.h"
+#include "imu.h"
+#include "oled.h"
+#include "prof.h"
+#include "step_detect.h"
+#include "ws2812.h"
+
+// ==============================
+//  Benchmark firmware (env:proton_bench)
+// ==============================
+//
+// Replaces main.c: runs fixed workloads through the real drivers and prints
+// one JSON object per result line, so runs before and after a change can be
+// diffed by a script. Lines starting with '#' are progress chatter.
+//
+// Everything runs on core 0 with nothing else going on, so the numbers are
+// the drivers' own cost, not contention with the UI core.
+//
+
+#if !PROF_ENABLE
+#error "bench.c times everything with prof_now(); build with PROF_ENABLE=1"
+#endif
+
+// Same board wiring as main.c / ui.c (IMU_INT1_PIN is in imu.h)
+#define LED_PIN             8
+#define LED_FREQ_HZ         800000
+
+#define IMU_I2C_ADDR        0x6A
+#define IMU_REG_WHO_AM_I    0x0F
+#define FG_I2C_ADDR         0x36
+#define FG_REG_VCELL        0x02
+#define OLED_I2C_ADDR       0x3C
+#define OLED_CMD_NOP        0xE3
+
+// Iterations per workload
+#define BENCH_OLED_FRAMES   50
+#define BENCH_GLYPH_REPS    200
+#define BENCH_WS2812_FRAMES 200
+#define BENCH_I2C_READS     200
+#define BENCH_DETECT_BLOCKS 200
+#define BENCH_MODEL_RUNS    1000
+
+// imu_update() jitter run; override with -DBENCH_JITTER_S=60 for a quick pass
+#ifndef BENCH_JITTER_S
+#define BENCH_JITTER_S      600
+#endif
+
+// Give a terminal this long to attach before the first line goes out
+#define BENCH_USB_WAIT_MS   5000
+
+typedef struct {
+    uint32_t n;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint64_t sumsq;
+} bench_stats_t;
+
+static void bench_stats_reset(bench_stats_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->min = UINT32_MAX;
+}
+
+static void bench_stats_add(bench_stats_t *s, uint32_t v)
+{
+    s->n++;
+    s->sum += v;
+    s->sumsq += (uint64_t)v * v;
+    if (v < s->min) s->min = v;
+    if (v > s->max) s->max = v;
+}
+
+// One result line; `div` converts the raw samples to `unit`
+static void bench_report(const char *name, const char *unit, const bench_stats_t *s, float div)
+{
+    if (s->n == 0) {
+        printf("{\"bench\":\"%s\",\"unit\":\"%s\",\"n\":0}\n", name, unit);
+        return;
+    }
+    float mean = (float)s->sum / (float)s->n;
+    float var = (float)s->sumsq / (float)s->n - mean * mean;
+    float sd = var > 0.0f ? sqrtf(var) : 0.0f;
+    printf("{\"bench\":\"%s\",\"unit\":\"%s\",\"n\":%lu,\"min\":%.2f,\"mean\":%.2f,\"max\":%.2f,\"sd\":%.2f}\n",
+           name, unit, s->n, s->min / div, mean / div, s->max / div, sd / div);
+}
+
+static inline float bench_ticks_per_us(void)
+{
+    return (float)prof_ticks_per_us();
+}
+
+// ==============================
+//  Workloads
+// ==============================
+
+static void bench_oled(void)
+{
+    bench_stats_t push, glyph;
+    bench_stats_reset(&push);
+    bench_stats_reset(&glyph);
+
+    if (!oled_init()) {
+        printf("{\"bench\":\"oled\",\"error\":\"init failed\"}\n");
+        return;
+    }
+
+    // Alternate all-on / all-off so every byte differs: a true full frame
+    for (int i = 0; i < BENCH_OLED_FRAMES; i++) {
+        oled_fill_rect(0, 0, OLED_WIDTH, OLED_HEIGHT, (uint8_t)(i & 1));
+        uint32_t t = prof_now();
+        oled_display();
+        bench_stats_add(&push, prof_now() - t);
+    }
+    bench_report("oled_full_frame", "us", &push, bench_ticks_per_us());
+
+    // Draw cost only (no push); one 21-glyph line per pass
+    static const char line[] = "0123456789ABCDEFGHIJK";
+    const uint32_t glyphs = sizeof(line) - 1;
+    for (int i = 0; i < BENCH_GLYPH_REPS; i++) {
+        uint32_t t = prof_now();
+        oled_print(0, 8, line);
+        bench_stats_add(&glyph, (prof_now() - t) / glyphs);
+    }
+    bench_report("oled_glyph", "cycles", &glyph, 1.0f);
+    oled_clear();
+}
+
+static void bench_ws2812(void)
+{
+    bench_stats_t frame, cpu;
+    bench_stats_reset(&frame);
+    bench_stats_reset(&cpu);
+
+    ws2812_init(LED_PIN, LED_FREQ_HZ);
+    ws2812_flush();
+
+    // Back-to-back changed frames: flush returns once the previous one has
+    // gone out and latched, so the spacing is the real frame time
+    uint32_t last = prof_now();
+    for (int i = 0; i < BENCH_WS2812_FRAMES; i++) {
+        ws2812_fill(rgb_to_grb((uint8_t)(i & 1 ? 8 : 0), 0, 0));
+        ws2812_flush();
+        uint32_t now = prof_now();
+        bench_stats_add(&frame, now - last);
+        last = now;
+
+        // CPU side of a show() that has to wait gets measured separately
+        ws2812_set(0, rgb_to_grb(0, (uint8_t)i, 0));
+        uint32_t t = prof_now();
+        ws2812_show();
+        bench_stats_add(&cpu, prof_now() - t);
+    }
+    bench_report("ws2812_frame", "us", &frame, bench_ticks_per_us());
+    bench_report("ws2812_show_cpu", "cycles", &cpu, 1.0f);
+
+    ws2812_fill(rgb_to_grb(0, 0, 0));
+    ws2812_flush();
+}
+
+static void bench_i2c(void)
+{
+    static const char *const names[I2C_DEV_COUNT] = {"imu", "fg", "oled"};
+    bench_stats_t lat[I2C_DEV_COUNT];
+    uint32_t fails[I2C_DEV_COUNT] = {0};
+
+    for (int d = 0; d < I2C_DEV_COUNT; d++) {
+        bench_stats_reset(&lat[d]);
+    }
+
+    for (int i = 0; i < BENCH_I2C_READS; i++) {
+        uint8_t rx[2];
+        uint8_t nop = OLED_CMD_NOP;
+        uint32_t t;
+        int rc;
+
+        t = prof_now();
+        rc = i2c_bus_xfer(I2C_DEV_IMU, IMU_I2C_ADDR, IMU_REG_WHO_AM_I, NULL, 0, rx, 1);
+        if (rc == 0) bench_stats_add(&lat[I2C_DEV_IMU], prof_now() - t); else fails[I2C_DEV_IMU]++;
+
+        t = prof_now();
+        rc = i2c_bus_xfer(I2C_DEV_FUEL_GAUGE, FG_I2C_ADDR, FG_REG_VCELL, NULL, 0, rx, 2);
+        if (rc == 0) bench_stats_add(&lat[I2C_DEV_FUEL_GAUGE], prof_now() - t); else fails[I2C_DEV_FUEL_GAUGE]++;
+
+        // The panel is write-only: time a one-byte command instead
+        t = prof_now();
+        rc = i2c_bus_xfer(I2C_DEV_OLED, OLED_I2C_ADDR, 0x00, &nop, 1, NULL, 0);
+        if (rc == 0) bench_stats_add(&lat[I2C_DEV_OLED], prof_now() - t); else fails[I2C_DEV_OLED]++;
+    }
+
+    for (int d = 0; d < I2C_DEV_COUNT; d++) {
+        char name[24];
+        snprintf(name, sizeof(name), "i2c_%s", names[d]);
+        bench_report(name, "us", &lat[d], bench_ticks_per_us());
+        if (fails[d]) {
+            printf("{\"bench\":\"%s\",\"failures\":%lu}\n", name, fails[d]);
+        }
+    }
+}
+
+// Synthetic walk (1.8 steps/s, +-0.35 g on top of gravity) through a
+// detector of its own, in FIFO-sized blocks at 104 Hz with the tuning from
+// the flash config. Only step_detect_block() is timed: no telemetry, no
+// history, no IMU driver.
+static void bench_step_detector(void)
+{
+    bench_stats_t per_sample;
+    bench_stats_reset(&per_sample);
+
+    const config_t *cfg = config_get();
+    static step_detector_t det;
+    step_detect_init(&det, 104);
+    step_detect_set_params(&det, &(step_detect_params_t){
+        .threshold_mg = cfg->v[CONFIG_STEP_THRESHOLD_MG],
+        .min_interval_ms = cfg->v[CONFIG_STEP_MIN_INTERVAL_MS],
+        .block_min_peak_mg = cfg->v[CONFIG_STEP_BLOCK_MIN_PEAK_MG],
+        .block_min_interval_ms = cfg->v[CONFIG_STEP_BLOCK_MIN_INTERVAL_MS],
+    });
+
+    enum { BLOCK = STEP_DETECT_MAX_BLOCK };
+    int16_t xyz[BLOCK * 3];
+    step_event_t events[BLOCK];
+    uint32_t t_ms = 0;
+    uint32_t k = 0;
+    uint32_t steps = 0;
+
+    for (int b = 0; b < BENCH_DETECT_BLOCKS; b++) {
+        for (int i = 0; i < BLOCK; i++, k++) {
+            float ph = 2.0f * 3.14159265f * 1.8f * (float)k / 104.0f;
+            float a = 1.0f + 0.35f * sinf(ph);
+            xyz[3 * i + 0] = (int16_t)(0.15f * sinf(0.5f * ph) * 16384.0f);
+            xyz[3 * i + 1] = (int16_t)(0.10f * 16384.0f);
+            xyz[3 * i + 2] = (int16_t)(a * 16384.0f);
+        }
+        uint32_t t = prof_now();
+        size_t n = step_detect_block(&det, xyz, BLOCK, t_ms, events);
+        bench_stats_add(&per_sample, (prof_now() - t) / BLOCK);
+        for (size_t e = 0; e < n; e++) {
+            steps += events[e].count;
+        }
+        t_ms += (BLOCK * 1000u) / 104u;
+    }
+    bench_report("step_detect_per_sample", "cycles", &per_sample, 1.0f);
+    printf("{\"bench\":\"step_detect_steps\",\"steps\":%lu,\"expected\":%lu}\n",
+           steps, (unsigned long)((k * 18u) / 1040u));
+}
+
+// One learned-model inference per closed minute in main.c; also checks the
+// integer kernel against the exporter's reference outputs
+static void bench_calorie_model(void)
+{
+    bench_stats_t infer;
+    bench_stats_reset(&infer);
+
+    volatile int32_t sink = 0;
+    for (uint32_t r = 0; r < BENCH_MODEL_RUNS; r++) {
+        int32_t in[CALORIE_MODEL_IN_COUNT];
+        calorie_model_features(in, 2000u + r * 17u, 20u + r % 200u, 730u);
+        uint32_t t = prof_now();
+        sink += calorie_model_infer_x16(in);
+        bench_stats_add(&infer, prof_now() - t);
+    }
+    (void)sink;
+    bench_report("calorie_model_infer", "cycles", &infer, 1.0f);
+    printf("{\"bench\":\"calorie_model_self_test\",\"pass\":%d}\n", calorie_model_self_test() ? 1 : 0);
+}
+
+// imu_update() driven by INT1 the way main.c does it: interval between
+// service passes (per power mode) and the time each pass takes
+static void bench_imu_jitter(void)
+{
+    bench_stats_t interval[IMU_POWER_MODE_COUNT];
+    bench_stats_t duration;
+    for (int m = 0; m < IMU_POWER_MODE_COUNT; m++) {
+        bench_stats_reset(&interval[m]);
+    }
+    bench_stats_reset(&duration);
+
+    if (!imu_init()) {
+        printf("{\"bench\":\"imu_update\",\"error\":\"init failed\"}\n");
+        return;
+    }
+    gpio_init(IMU_INT1_PIN);
+    gpio_set_dir(IMU_INT1_PIN, GPIO_IN);
+    gpio_pull_down(IMU_INT1_PIN);
+    events_bind_gpio(IMU_INT1_PIN, GPIO_IRQ_EDGE_RISE, EVENT_IMU);
+
+    printf("# imu_update jitter for %d s\n", BENCH_JITTER_S);
+    uint32_t start_ms = to_ms_since_boot(get_absolute_time());
+    uint32_t last_us = 0;
+    bool have_last = false;
+    uint32_t last_note_ms = start_ms;
+
+    while (true) {
+        uint32_t events = events_wait();
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        if ((now_ms - start_ms) >= BENCH_JITTER_S * 1000u) break;
+        if (!(events & EVENT_IMU)) continue;
+
+        imu_power_mode_t mode = imu_get_power_mode();
+        uint32_t now_us = time_us_32();
+        if (have_last) {
+            bench_stats_add(&interval[mode], now_us - last_us);
+        }
+        last_us = now_us;
+        have_last = true;
+
+        uint32_t t = prof_now();
+        imu_update(now_ms);
+        bench_stats_add(&duration, prof_now() - t);
+
+        if ((now_ms - last_note_ms) >= 60000u) {
+            last_note_ms = now_ms;
+            printf("# %lu s\n", (now_ms - start_ms) / 1000u);
+        }
+    }
+
+    bench_report("imu_interval_active", "us", &interval[IMU_POWER_ACTIVE], 1.0f);
+    bench_report("imu_interval_low", "us", &interval[IMU_POWER_LOW], 1.0f);
+    bench_report("imu_update", "us", &duration, bench_ticks_per_us());
+    printf("{\"bench\":\"imu_fifo_overruns\",\"count\":%lu}\n", imu_get_fifo_overruns());
+}
+
+int main(void) {
+    stdio_init_all();
+    for (uint32_t waited = 0; !stdio_usb_connected() && waited < BENCH_USB_WAIT_MS; waited += 10) {
+        sleep_ms(10);
+    }
+
+    prof_init();
+    i2c_bus_init();
+    events_init(100);
+    config_init();   // imu.c takes its idle time and step goal from here
+
+#ifdef __OPTIMIZE__
+    const int optimized = 1;
+#else
+    const int optimized = 0;
+#endif
+    printf("{\"bench\":\"build\",\"optimized\":%d,\"clk_sys_hz\":%lu,\"ticks_per_us\":%lu}\n",
+           optimized, clock_get_hz(clk_sys), prof_ticks_per_us());
+
+    bench_oled();
+    bench_ws2812();
+    bench_i2c();
+    bench_step_detector();
+    bench_calorie_model();
+    bench_imu_jitter();
+
+    printf("{\"bench\":\"done\"}\n");
+    while (true) {
+        sleep_ms(1000);
+    }
+}
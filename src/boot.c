@@ -0,0 +1,78 @@
+#include "boot.h"
+
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+
+#include "log.h"
+
+// Scratch 0-3 are ours; the SDK's watchdog_reboot() and the boot ROM use 4-7
+#define BOOT_SCRATCH_MAGIC     0
+#define BOOT_SCRATCH_STEPS     1
+#define BOOT_SCRATCH_CALORIES  2
+#define BOOT_SCRATCH_CHECK     3
+
+#define BOOT_MAGIC             0x50415431u   // "PAT1"
+
+static boot_mode_t s_mode = BOOT_COLD;
+
+static inline uint32_t boot_check(uint32_t steps, uint32_t calories)
+{
+    return BOOT_MAGIC ^ steps ^ (calories * 0x9E3779B1u);
+}
+
+boot_mode_t boot_init(void)
+{
+    s_mode = (watchdog_hw->scratch[BOOT_SCRATCH_MAGIC] == BOOT_MAGIC) ? BOOT_WARM : BOOT_COLD;
+    if (s_mode == BOOT_COLD) {
+        // Power-on contents are undefined; start from a clean, valid zero
+        boot_save(0, 0);
+        LOG_I("Cold boot");
+    } else {
+        LOG_I("Warm boot (%s)", watchdog_caused_reboot() ? "watchdog" : "reset");
+    }
+    return s_mode;
+}
+
+boot_mode_t boot_get_mode(void)
+{
+    return s_mode;
+}
+
+bool boot_restore(uint32_t *steps, uint32_t *calories)
+{
+    if (s_mode != BOOT_WARM) return false;
+    uint32_t s = watchdog_hw->scratch[BOOT_SCRATCH_STEPS];
+    uint32_t c = watchdog_hw->scratch[BOOT_SCRATCH_CALORIES];
+    if (watchdog_hw->scratch[BOOT_SCRATCH_CHECK] != boot_check(s, c)) return false;
+    *steps = s;
+    *calories = c;
+    return true;
+}
+
+void boot_save(uint32_t steps, uint32_t calories)
+{
+    // Invalidate first so a reset between the writes can't pair new steps
+    // with old calories
+    watchdog_hw->scratch[BOOT_SCRATCH_CHECK] = 0;
+    watchdog_hw->scratch[BOOT_SCRATCH_STEPS] = steps;
+    watchdog_hw->scratch[BOOT_SCRATCH_CALORIES] = calories;
+    watchdog_hw->scratch[BOOT_SCRATCH_CHECK] = boot_check(steps, calories);
+    watchdog_hw->scratch[BOOT_SCRATCH_MAGIC] = BOOT_MAGIC;
+}
+
+void boot_watchdog_start(void)
+{
+    if (BOOT_WATCHDOG_MS == 0) return;
+    watchdog_enable(BOOT_WATCHDOG_MS, true);   // paused while a debugger halts us
+}
+
+void boot_watchdog_feed(void)
+{
+    if (BOOT_WATCHDOG_MS == 0) return;
+    watchdog_update();
+}
+
+void boot_watchdog_pause(void)
+{
+    hw_clear_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_ENABLE_BITS);
+}
@@ -0,0 +1,54 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Boot mode and warm-reset recovery
+// ==============================
+//
+// The watchdog scratch registers survive a watchdog or software reset but
+// not a power cycle. While running, core 0 keeps a magic word and the
+// current totals there (boot_save()), so the next boot can tell a warm
+// reset (peripherals still powered and configured) from a cold one, and
+// pick up the exact counts instead of the last flash log record.
+//
+// Warm boots skip the startup animation; polling device readiness instead
+// of fixed power-up delays makes the drivers fast on both paths.
+//
+// The hardware watchdog is armed once init is done and fed every main-loop
+// pass; a hang then comes back as a warm boot with the counts intact.
+//
+
+typedef enum {
+    BOOT_COLD,   // power-on: nothing carried over
+    BOOT_WARM,   // watchdog or software reset with the board powered
+} boot_mode_t;
+
+// Main-loop watchdog timeout (0 = don't arm it)
+#ifndef BOOT_WATCHDOG_MS
+#define BOOT_WATCHDOG_MS  2000
+#endif
+
+// Call first thing in main(): classifies this boot
+boot_mode_t boot_init(void);
+
+// Mode found by boot_init() (safe from either core afterwards)
+boot_mode_t boot_get_mode(void);
+
+// Totals saved by the previous run, if this is a warm boot and they're intact
+bool boot_restore(uint32_t *steps, uint32_t *calories);
+
+// Stash the current totals for a warm reset (a few register writes)
+void boot_save(uint32_t steps, uint32_t calories);
+
+// Arm the watchdog / feed it from the main loop
+void boot_watchdog_start(void);
+void boot_watchdog_feed(void);
+
+// Stop the watchdog while the clocks are stopped (dormant); restart it
+// with boot_watchdog_start()
+void boot_watchdog_pause(void);
+
+#endif // BOOT_H
@@ -0,0 +1,193 @@
+#include "buttons.h"
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+#include "events.h"
+
+#define BUTTON_QUEUE_LEN  8   // power of two
+
+typedef struct {
+    uint8_t    pin;
+    bool       pressed;          // debounced level
+    bool       second_press;     // this press completed a double press
+    bool       long_sent;        // this press was reported as long
+    bool       single_pending;   // released, waiting out the double-press window
+    uint32_t   edge_ms;          // first edge since the level was last trusted
+    uint32_t   press_ms;
+    alarm_id_t debounce_alarm;
+    alarm_id_t gesture_alarm;    // long press while held, double window once released
+} button_t;
+
+static button_t s_buttons[BUTTON_COUNT] = {
+    [BUTTON_MODE]  = { .pin = BUTTON_MODE_PIN },
+    [BUTTON_START] = { .pin = BUTTON_START_PIN },
+};
+
+// Filled from the GPIO and timer interrupts, drained by the main loop.
+// Both interrupts run on core 0 at the default priority, so they never
+// preempt each other; only the reader needs to mask them.
+static button_event_t s_queue[BUTTON_QUEUE_LEN];
+static volatile uint32_t s_head;
+static volatile uint32_t s_tail;
+static volatile uint32_t s_drops;
+
+static uint32_t buttons_now_ms(void)
+{
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void buttons_push(const button_t *b, uint32_t t_ms, button_gesture_t gesture)
+{
+    if (s_head - s_tail >= BUTTON_QUEUE_LEN) {
+        s_drops = s_drops + 1;
+        return;
+    }
+    s_queue[s_head & (BUTTON_QUEUE_LEN - 1)] = (button_event_t){
+        .t_ms = t_ms,
+        .button = (uint8_t)(b - s_buttons),
+        .gesture = (uint8_t)gesture,
+    };
+    s_head = s_head + 1;
+    events_post(EVENT_BUTTON);
+}
+
+// ==============================
+//  Gesture timing
+// ==============================
+
+static void buttons_cancel(alarm_id_t *id)
+{
+    if (*id > 0) cancel_alarm(*id);
+    *id = 0;
+}
+
+static int64_t buttons_gesture_cb(alarm_id_t id, void *user_data)
+{
+    (void)id;
+    button_t *b = (button_t *)user_data;
+    b->gesture_alarm = 0;
+
+    if (b->single_pending) {
+        // No second press in time
+        b->single_pending = false;
+        buttons_push(b, b->press_ms, BUTTON_PRESS);
+    } else if (b->pressed && !b->second_press) {
+        b->long_sent = true;
+        buttons_push(b, b->press_ms, BUTTON_LONG_PRESS);
+    }
+    return 0;
+}
+
+static void buttons_on_press(button_t *b, uint32_t t_ms)
+{
+    buttons_cancel(&b->gesture_alarm);
+    b->long_sent = false;
+    if (b->single_pending) {
+        b->single_pending = false;
+        b->second_press = true;
+        buttons_push(b, b->press_ms, BUTTON_DOUBLE_PRESS);
+        return;
+    }
+    b->second_press = false;
+    b->press_ms = t_ms;
+    b->gesture_alarm = add_alarm_in_ms(BUTTON_LONG_PRESS_MS, buttons_gesture_cb, b, true);
+}
+
+static void buttons_on_release(button_t *b)
+{
+    buttons_cancel(&b->gesture_alarm);
+    if (b->long_sent || b->second_press) return;
+    if (!(BUTTON_DOUBLE_PRESS_MASK & (1u << (b - s_buttons)))) {
+        buttons_push(b, b->press_ms, BUTTON_PRESS);
+        return;
+    }
+
+    b->single_pending = true;
+    b->gesture_alarm = add_alarm_in_ms(BUTTON_DOUBLE_PRESS_MS, buttons_gesture_cb, b, true);
+}
+
+// ==============================
+//  Debounce
+// ==============================
+
+static int64_t buttons_debounce_cb(alarm_id_t id, void *user_data)
+{
+    (void)id;
+    button_t *b = (button_t *)user_data;
+    b->debounce_alarm = 0;
+
+    bool pressed = !gpio_get(b->pin);
+    if (pressed == b->pressed) return 0;   // a glitch that settled back
+    b->pressed = pressed;
+    if (pressed) {
+        buttons_on_press(b, b->edge_ms);
+    } else {
+        buttons_on_release(b);
+    }
+    return 0;
+}
+
+static void buttons_gpio_cb(uint32_t gpio, uint32_t edges)
+{
+    (void)edges;
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        button_t *b = &s_buttons[i];
+        if (b->pin != gpio) continue;
+
+        // Every bounce pushes the check back; the press keeps its first edge
+        if (b->debounce_alarm > 0) {
+            cancel_alarm(b->debounce_alarm);
+        } else {
+            b->edge_ms = buttons_now_ms();
+        }
+        b->debounce_alarm = add_alarm_in_ms(BUTTON_DEBOUNCE_MS, buttons_debounce_cb, b, true);
+        return;
+    }
+}
+
+// ==============================
+//  Public API
+// ==============================
+
+void buttons_init(void)
+{
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        button_t *b = &s_buttons[i];
+        gpio_init(b->pin);
+        gpio_set_dir(b->pin, GPIO_IN);
+        gpio_pull_up(b->pin);
+        // Held at boot: not a press until it has been released
+        b->pressed = !gpio_get(b->pin);
+        b->long_sent = b->pressed;
+        events_bind_gpio_handler(b->pin, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, buttons_gpio_cb);
+    }
+}
+
+void buttons_resync(void)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        const button_t *b = &s_buttons[i];
+        if (!gpio_get(b->pin) != b->pressed) buttons_gpio_cb(b->pin, 0);
+    }
+    restore_interrupts(irq);
+}
+
+bool buttons_read(button_event_t *out)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    bool any = s_tail != s_head;
+    if (any) {
+        *out = s_queue[s_tail & (BUTTON_QUEUE_LEN - 1)];
+        s_tail = s_tail + 1;
+    }
+    restore_interrupts(irq);
+    return any;
+}
+
+uint32_t buttons_get_drops(void)
+{
+    return s_drops;
+}
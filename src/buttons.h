@@ -0,0 +1,75 @@
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Buttons (core 0)
+// ==============================
+//
+// Interrupt driven: a GPIO edge timestamps the press and (re)arms a
+// BUTTON_DEBOUNCE_MS alarm, and the level is only trusted once the alarm
+// fires without another edge in between. Further alarms time long presses
+// and the double-press window. Finished gestures go into a small queue and
+// post EVENT_BUTTON, so the main loop never samples the pins and a press
+// is caught however long the loop was busy.
+//
+// A long press is reported as soon as the button has been held for
+// BUTTON_LONG_PRESS_MS (and nothing is reported on its release). Otherwise
+// a press is reported on release, unless the button is in
+// BUTTON_DOUBLE_PRESS_MASK: then it waits out the double-press window, and
+// a second press in time is reported as a double press instead. Only opt a
+// button in once something handles its double press, or a quick second
+// press is lost and every single press lags by the window.
+//
+
+// Active-low buttons with internal pull-ups
+#ifndef BUTTON_MODE_PIN
+#define BUTTON_MODE_PIN   26   // steps / calories
+#endif
+#ifndef BUTTON_START_PIN
+#define BUTTON_START_PIN  21   // start / pause / resume workout
+#endif
+
+#define BUTTON_DEBOUNCE_MS      20
+#define BUTTON_LONG_PRESS_MS    800
+#define BUTTON_DOUBLE_PRESS_MS  300
+
+typedef enum {
+    BUTTON_MODE,
+    BUTTON_START,
+    BUTTON_COUNT
+} button_id_t;
+
+// Buttons that report double presses, as (1u << button_id_t) bits. Neither
+// control uses one yet, so both report presses at once.
+#ifndef BUTTON_DOUBLE_PRESS_MASK
+#define BUTTON_DOUBLE_PRESS_MASK  0u
+#endif
+
+typedef enum {
+    BUTTON_PRESS,
+    BUTTON_LONG_PRESS,
+    BUTTON_DOUBLE_PRESS,
+} button_gesture_t;
+
+typedef struct {
+    uint32_t t_ms;     // first edge of the (first) press
+    uint8_t  button;   // button_id_t
+    uint8_t  gesture;  // button_gesture_t
+} button_event_t;
+
+// Set up the pins and their interrupts (core 0, after events_init())
+void buttons_init(void);
+
+// Take the oldest queued event; false when the queue is empty
+bool buttons_read(button_event_t *out);
+
+// Catch up on edges missed while the clocks were stopped (dormant)
+void buttons_resync(void);
+
+// Events lost to a full queue since boot
+uint32_t buttons_get_drops(void);
+
+#endif // BUTTONS_H
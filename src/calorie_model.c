@@ -0,0 +1,157 @@
+#include "calorie_model.h"
+
+#include "calorie_model_weights.h"
+#include "history.h"
+
+_Static_assert(CALORIE_MODEL_INPUTS == CALORIE_MODEL_IN_COUNT,
+               "calorie_model_weights.h doesn't match calorie_model_input_t; re-run the exporter");
+
+#define CALORIE_MODEL_DAY_S  86400u
+
+// Day tracker state
+static uint32_t s_stride_mm;
+static uint32_t s_minute;            // current history minute
+static uint32_t s_day;
+static uint32_t s_active_min;        // active minutes closed today
+static uint32_t s_today_x16;
+
+static inline int16_t calorie_model_sat16(int64_t v)
+{
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+// ==============================
+//  Inference
+// ==============================
+
+void calorie_model_features(int32_t in[CALORIE_MODEL_IN_COUNT], uint32_t steps,
+                            uint32_t active_min, uint32_t stride_mm)
+{
+    if (active_min == 0) active_min = 1;   // the model never saw zero-minute days
+    uint32_t distance_m = (uint32_t)(((uint64_t)steps * stride_mm + 500u) / 1000u);
+    in[CALORIE_MODEL_IN_STEPS] = (int32_t)steps;
+    in[CALORIE_MODEL_IN_DURATION_MIN] = (int32_t)active_min;
+    in[CALORIE_MODEL_IN_DISTANCE_M] = (int32_t)distance_m;
+    in[CALORIE_MODEL_IN_SPM_X10] = (int32_t)((steps * 10u + active_min / 2u) / active_min);
+    // km/h x100 = m / min * 60 / 1000 * 100 = m * 6 / min
+    in[CALORIE_MODEL_IN_SPEED_X100] = (int32_t)((distance_m * 6u + active_min / 2u) / active_min);
+}
+
+int32_t calorie_model_infer_x16(const int32_t in[CALORIE_MODEL_IN_COUNT])
+{
+    int16_t z[CALORIE_MODEL_INPUTS];
+    for (int i = 0; i < CALORIE_MODEL_INPUTS; i++) {
+        // Outside the range it was trained on the model only extrapolates
+        int32_t v = in[i];
+        if (v < calorie_model_in_min[i]) v = calorie_model_in_min[i];
+        if (v > calorie_model_in_max[i]) v = calorie_model_in_max[i];
+        int64_t d = (int64_t)v - calorie_model_in_mean[i];
+        z[i] = calorie_model_sat16((d * calorie_model_in_mul[i]) >> 16);
+    }
+
+    int32_t acc_out = CALORIE_MODEL_B2;
+    for (int j = 0; j < CALORIE_MODEL_HIDDEN; j++) {
+        int32_t acc = calorie_model_b1[j];
+        for (int i = 0; i < CALORIE_MODEL_INPUTS; i++) {
+            acc += (int32_t)calorie_model_w1[j][i] * z[i];
+        }
+        if (acc <= 0) continue;   // ReLU
+        int16_t h = calorie_model_sat16(((int64_t)acc * CALORIE_MODEL_M1) >> CALORIE_MODEL_MUL_SHIFT);
+        acc_out += (int32_t)calorie_model_w2[j] * h;
+    }
+    return (int32_t)(((int64_t)acc_out * CALORIE_MODEL_M2) >> CALORIE_MODEL_MUL_SHIFT) + CALORIE_MODEL_OUT_BIAS;
+}
+
+static int32_t calorie_model_check_x16(uint32_t spm, uint32_t active_min)
+{
+    int32_t in[CALORIE_MODEL_IN_COUNT];
+    calorie_model_features(in, spm * active_min, active_min, CALORIE_MODEL_CHECK_STRIDE_MM);
+    return calorie_model_infer_x16(in);
+}
+
+bool calorie_model_self_test(void)
+{
+    for (int k = 0; k < CALORIE_MODEL_TEST_VECTORS; k++) {
+        if (calorie_model_infer_x16(calorie_model_test_in[k]) != calorie_model_test_out[k]) return false;
+    }
+
+    // The day so far only ever grows: more active minutes at a cadence, or
+    // a faster cadence for the same minutes, must not give fewer calories
+    for (int c = 0; c < CALORIE_MODEL_CHECK_CADENCES; c++) {
+        uint32_t spm = calorie_model_check_spm[c];
+        int32_t prev = INT32_MIN;
+        for (uint32_t m = 1; m <= CALORIE_MODEL_CHECK_MAX_MIN; m++) {
+            int32_t out = calorie_model_check_x16(spm, m);
+            if (out < prev) return false;
+            if (c > 0 && out < calorie_model_check_x16(calorie_model_check_spm[c - 1], m)) return false;
+            prev = out;
+        }
+    }
+    return true;
+}
+
+// ==============================
+//  Day tracker
+// ==============================
+
+void calorie_model_init(uint32_t stride_mm, uint32_t now_s)
+{
+    s_stride_mm = stride_mm;
+    s_minute = now_s / 60u;
+    s_day = now_s / CALORIE_MODEL_DAY_S;
+    s_active_min = 0;
+    s_today_x16 = 0;
+}
+
+void calorie_model_set_stride(uint32_t stride_mm)
+{
+    s_stride_mm = stride_mm;
+}
+
+bool calorie_model_update(uint32_t now_s)
+{
+    uint32_t minute = now_s / 60u;
+    if (minute == s_minute) return false;
+
+    // Classify the minutes that closed since the last call, still in the
+    // minute ring (older ones are gone; count them as inactive)
+    uint32_t closed = minute - s_minute;
+    uint32_t ago_max = closed < HISTORY_MINUTES ? closed : HISTORY_MINUTES - 1u;
+    s_minute = minute;
+
+    uint32_t day = now_s / CALORIE_MODEL_DAY_S;
+    if (day != s_day) {
+        s_day = day;
+        s_active_min = 0;
+        ago_max = 0;   // those minutes belonged to yesterday
+    }
+    // The ring only moves when steps are added; bring it up to now so that
+    // ago 1 is the minute that just closed, not the one before it
+    history_advance(now_s);
+    for (uint32_t ago = ago_max; ago >= 1u; ago--) {
+        if (history_bucket(HISTORY_TIER_MINUTE, (uint8_t)ago) >= CALORIE_MODEL_ACTIVE_STEPS) s_active_min++;
+    }
+
+    uint32_t steps = history_steps_today();
+    if (steps == 0) {
+        s_today_x16 = 0;
+        return true;
+    }
+    int32_t in[CALORIE_MODEL_IN_COUNT];
+    calorie_model_features(in, steps, s_active_min, s_stride_mm);
+    int32_t out = calorie_model_infer_x16(in);
+    s_today_x16 = out > 0 ? (uint32_t)out : 0;
+    return true;
+}
+
+uint32_t calorie_model_today(void)
+{
+    return (s_today_x16 + 8u) >> CALORIE_MODEL_OUT_FRAC;
+}
+
+uint32_t calorie_model_active_minutes(void)
+{
+    return s_active_min;
+}
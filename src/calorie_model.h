@@ -0,0 +1,63 @@
+#ifndef CALORIE_MODEL_H
+#define CALORIE_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Learned calorie model
+// ==============================
+//
+// Integer inference for the model from calorie_model/model.ipynb, exported
+// by tools/export_calorie_model.py into calorie_model_weights.h: a 5-16-1
+// MLP with int8 weights and Q12 int16 activations, all integer math, no
+// heap. The notebook's features describe a day of activity, so the
+// tracker below rebuilds them for the day so far from the per-minute step
+// history and re-runs the model as each minute closes.
+//
+// Inputs are clamped to the range the model was trained on. This is an
+// estimate to compare against the calorie engine (calories.h), not what the
+// display shows. Until the notebook's forest and data are available to the
+// exporter, the committed weights are a stand-in distilled from a MET
+// teacher; calorie_model_weights.h says which one it holds.
+//
+
+// Model inputs, in the exporter's FEATURES order and device units
+typedef enum {
+    CALORIE_MODEL_IN_STEPS,          // steps
+    CALORIE_MODEL_IN_DURATION_MIN,   // active minutes
+    CALORIE_MODEL_IN_DISTANCE_M,     // metres
+    CALORIE_MODEL_IN_SPM_X10,        // steps per active minute, x10
+    CALORIE_MODEL_IN_SPEED_X100,     // km/h over the active minutes, x100
+    CALORIE_MODEL_IN_COUNT
+} calorie_model_input_t;
+
+// A minute with at least this many steps counts as active
+#define CALORIE_MODEL_ACTIVE_STEPS   20
+
+// Build the inputs for a stretch of activity
+void calorie_model_features(int32_t in[CALORIE_MODEL_IN_COUNT], uint32_t steps,
+                            uint32_t active_min, uint32_t stride_mm);
+
+// Run the model: calories for the activity, x16
+int32_t calorie_model_infer_x16(const int32_t in[CALORIE_MODEL_IN_COUNT]);
+
+// Run the exporter's reference vectors, then its monotonicity sweep; true
+// if every output matches exactly and none of the sweep goes backwards
+bool calorie_model_self_test(void);
+
+// Day tracker (core 0). Times are in history seconds (see history.h).
+void calorie_model_init(uint32_t stride_mm, uint32_t now_s);
+
+// New stride (profile edit); takes effect from the next estimate
+void calorie_model_set_stride(uint32_t stride_mm);
+
+// Call every pass; does work only when a minute has closed. Returns true
+// when calorie_model_today() has a new value.
+bool calorie_model_update(uint32_t now_s);
+
+// Latest estimate for today, kcal, and the active minutes behind it
+uint32_t calorie_model_today(void);
+uint32_t calorie_model_active_minutes(void);
+
+#endif // CALORIE_MODEL_H
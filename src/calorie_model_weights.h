@@ -0,0 +1,76 @@
+#ifndef CALORIE_MODEL_WEIGHTS_H
+#define CALORIE_MODEL_WEIGHTS_H
+
+// Generated by tools/export_calorie_model.py; do not edit.
+//
+// STAND-IN, not the notebook's model: MET speed-band teacher, 160 lb, 0.732 m stride
+// 1200 samples (240 held out), 16 hidden units, 400 epochs, seed 1
+// held-out MAE vs teacher: float 53.88 kcal, quantised 54.20 kcal (teacher mean 456 kcal)
+// quantised MAE up to 30 active min: 17.41 kcal (134 samples)
+
+#include <stdint.h>
+
+#define CALORIE_MODEL_INPUTS     5
+#define CALORIE_MODEL_HIDDEN     16
+#define CALORIE_MODEL_Z_FRAC     12
+#define CALORIE_MODEL_MUL_SHIFT  24
+#define CALORIE_MODEL_OUT_FRAC   4
+
+// Training range, in device units: the device clamps its inputs to it
+static const int32_t calorie_model_in_min[CALORIE_MODEL_INPUTS] = { 24, 1, 12, 203, 62 };
+static const int32_t calorie_model_in_max[CALORIE_MODEL_INPUTS] = { 100458, 596, 94329, 1698, 957 };
+
+// Input normalisation: z = ((raw - mean) * mul) >> 16, Q12
+static const int32_t calorie_model_in_mean[CALORIE_MODEL_INPUTS] = { 9192, 97, 6965, 958, 434 };
+static const int32_t calorie_model_in_mul[CALORIE_MODEL_INPUTS] = { 16864, 1870301, 20895, 605053, 1080739 };
+
+// Hidden layer: ReLU(w1 . z + b1) * m1 >> MUL_SHIFT, Q12
+static const int8_t calorie_model_w1[CALORIE_MODEL_HIDDEN][CALORIE_MODEL_INPUTS] = {
+    { 2, 4, 1, 96, 29 },
+    { 0, 3, 0, 0, 65 },
+    { 3, 0, 17, 0, 23 },
+    { 3, 0, 0, 0, 1 },
+    { 1, 2, 0, 0, 72 },
+    { 0, 2, 0, 48, 26 },
+    { 0, 83, 56, 0, 0 },
+    { 0, 0, 0, 76, 0 },
+    { 1, 0, 0, 0, 0 },
+    { 0, 0, 103, 113, 87 },
+    { 1, 0, 38, 121, 91 },
+    { 0, 87, 127, 0, 0 },
+    { 4, 0, 29, 43, 42 },
+    { 3, 1, 0, 59, 0 },
+    { 0, 0, 109, 11, 98 },
+    { 0, 0, 17, 50, 0 },
+};
+static const int32_t calorie_model_b1[CALORIE_MODEL_HIDDEN] = { -761344, -381346, -716079, -99374, -430713, -462392, 357390, -523542, -126750, -1147733, -1527939, 524005, -1459309, -480767, -165533, -733690 };
+#define CALORIE_MODEL_M1         106190
+
+// Output: (w2 . h + b2) * m2 >> MUL_SHIFT + out_bias, kcal x16
+static const int8_t calorie_model_w2[CALORIE_MODEL_HIDDEN] = { 0, 0, 10, 0, 0, 0, 37, 0, 29, 49, 127, 41, 85, 1, 26, 18 };
+#define CALORIE_MODEL_B2         -288397
+#define CALORIE_MODEL_M2         415641
+#define CALORIE_MODEL_OUT_BIAS   7294
+
+// Reference vectors: device inputs and the exact expected output
+#define CALORIE_MODEL_TEST_VECTORS 8
+static const int32_t calorie_model_test_in[CALORIE_MODEL_TEST_VECTORS][CALORIE_MODEL_INPUTS] = {
+    { 7965, 47, 7147, 1682, 906 },
+    { 35290, 442, 24884, 799, 338 },
+    { 3557, 31, 2730, 1135, 523 },
+    { 6941, 208, 4047, 334, 117 },
+    { 2307, 28, 1693, 825, 363 },
+    { 2461, 17, 1843, 1453, 653 },
+    { 301, 5, 191, 606, 231 },
+    { 1172, 7, 1053, 1609, 868 },
+};
+static const int32_t calorie_model_test_out[CALORIE_MODEL_TEST_VECTORS] = { 9163, 23524, 2087, 7824, 1621, 1594, 391, 2380 };
+
+// Monotonicity sweep: each cadence (steps per active minute) over 1..MAX_MIN
+// active minutes at this stride
+#define CALORIE_MODEL_CHECK_CADENCES  5
+#define CALORIE_MODEL_CHECK_MAX_MIN   600
+#define CALORIE_MODEL_CHECK_STRIDE_MM 732
+static const uint16_t calorie_model_check_spm[CALORIE_MODEL_CHECK_CADENCES] = { 30, 60, 90, 120, 150 };
+
+#endif // CALORIE_MODEL_WEIGHTS_H
@@ -0,0 +1,209 @@
+#include "calories.h"
+
+#include <math.h>
+#include <string.h>
+
+// Consecutive steps further apart than this aren't walking: cadence restarts
+#define CALORIES_GAP_MS          2000u
+
+// Walking and running MET by speed (Compendium of Physical Activities,
+// level ground): each band runs from its speed up to the next one's
+#define CALORIES_MPH_TO_MM_S(mph_x10)  ((uint32_t)((mph_x10) * 44704u / 1000u))
+
+typedef struct {
+    uint32_t speed_mm_s;
+    uint16_t met_x10;
+} calories_met_band_t;
+
+static const calories_met_band_t s_met_bands[] = {
+    { 0,                          20 },   // strolling, < 2 mph
+    { CALORIES_MPH_TO_MM_S(20),   28 },
+    { CALORIES_MPH_TO_MM_S(25),   30 },
+    { CALORIES_MPH_TO_MM_S(28),   35 },   // 2.8-3.2 mph, moderate
+    { CALORIES_MPH_TO_MM_S(35),   43 },   // brisk
+    { CALORIES_MPH_TO_MM_S(40),   50 },
+    { CALORIES_MPH_TO_MM_S(45),   70 },   // very brisk
+    { CALORIES_MPH_TO_MM_S(50),   83 },   // race walking / jogging
+    { CALORIES_MPH_TO_MM_S(60),   98 },   // running
+};
+
+#define CALORIES_MET_BANDS  (sizeof(s_met_bands) / sizeof(s_met_bands[0]))
+
+// Steps per mile by height, as in steps_to_calories.h
+static const uint16_t s_steps_per_mile[] = {
+    [HEIGHT_TALL] = 2000, [HEIGHT_MEDIUM] = 2200, [HEIGHT_SHORT] = 2400,
+};
+
+// ==============================
+//  Profile resolution (once per profile)
+// ==============================
+
+// Weight bracket for interpolation: weight_lbs[*idx] <= weight <= weight_lbs[*idx + 1]
+static uint16_t calories_weight_bracket(uint16_t weight, uint8_t *idx)
+{
+    if (weight < weight_lbs[0]) weight = weight_lbs[0];
+    if (weight > weight_lbs[NUM_WEIGHT_CATEGORIES - 1]) weight = weight_lbs[NUM_WEIGHT_CATEGORIES - 1];
+
+    uint8_t i = 0;
+    while (i < NUM_WEIGHT_CATEGORIES - 2 && weight >= weight_lbs[i + 1]) i++;
+    *idx = i;
+    return weight;
+}
+
+// c1 + (c2 - c1) * (weight - w1) / (w2 - w1), keeping CALORIES_Q fraction bits
+static uint32_t calories_lerp_weight(uint32_t c1, uint32_t c2, uint16_t weight, uint8_t idx)
+{
+    uint32_t w1 = weight_lbs[idx];
+    uint32_t w2 = weight_lbs[idx + 1];
+    int64_t span = ((int64_t)c2 - (int64_t)c1) << CALORIES_Q;
+    return (uint32_t)(((int64_t)c1 << CALORIES_Q) + span * (int64_t)(weight - w1) / (int64_t)(w2 - w1));
+}
+
+static const uint8_t *calories_per_1000_table(height_category_t height)
+{
+    switch (height) {
+        case HEIGHT_TALL:   return cal_per_1000_tall;
+        case HEIGHT_SHORT:  return cal_per_1000_short;
+        case HEIGHT_MEDIUM:
+        default:            return cal_per_1000_medium;
+    }
+}
+
+// Calories per 1,000 steps for a weight/height, with CALORIES_Q fraction bits
+static uint32_t calories_per_1000_q(uint16_t weight, uint8_t idx, height_category_t height)
+{
+    const uint8_t *t = calories_per_1000_table(height);
+    return calories_lerp_weight(t[idx], t[idx + 1], weight, idx);
+}
+
+// First step of table segment seg (segment 0 starts at zero steps)
+static inline uint32_t calories_seg_start(uint8_t seg)
+{
+    return seg ? step_counts[seg - 1] : 0;
+}
+
+void calories_init(calories_t *c, const calories_profile_t *profile)
+{
+    memset(c, 0, sizeof(*c));
+    c->mode = profile->mode;
+
+    uint8_t idx;
+    uint16_t weight = calories_weight_bracket(profile->weight_lbs, &idx);
+    uint32_t per_1000 = calories_per_1000_q(weight, idx, profile->height);
+    c->per_step_q = (per_1000 + 500u) / 1000u;
+
+    // MET mode: kcal/min = MET * 3.5 ml/kg/min * kg / 200
+    float kg = (float)weight * 0.45359237f;
+    c->kcal_per_met_ms = kg * 3.5f / 200.0f / 60000.0f;
+    uint16_t spm = (profile->height <= HEIGHT_SHORT) ? s_steps_per_mile[profile->height]
+                                                      : s_steps_per_mile[HEIGHT_MEDIUM];
+    c->stride_m = 1609.344f / (float)spm;
+
+    if (c->mode != CALORIES_MODE_TABLE) return;
+
+    // The big table is for medium height; other heights scale it by the
+    // ratio of their per-1,000 rows at this weight
+    uint32_t per_1000_medium = calories_per_1000_q(weight, idx, HEIGHT_MEDIUM);
+    for (uint8_t r = 0; r < NUM_STEP_ROWS; r++) {
+        uint32_t row = calories_lerp_weight(cal_table_medium_steps[r][idx],
+                                            cal_table_medium_steps[r][idx + 1], weight, idx);
+        c->row_q[r + 1] = (uint32_t)(((uint64_t)row * per_1000 + per_1000_medium / 2) / per_1000_medium);
+    }
+    for (uint8_t s = 0; s < NUM_STEP_ROWS; s++) {
+        uint32_t len = step_counts[s] - calories_seg_start(s);
+        uint32_t rise = (c->row_q[s + 1] > c->row_q[s]) ? c->row_q[s + 1] - c->row_q[s] : 0;
+        c->slope_q[s] = (rise + len / 2) / len;
+    }
+    // Past the last row, keep the last row's slope
+    c->slope_q[NUM_STEP_ROWS] = c->slope_q[NUM_STEP_ROWS - 1];
+}
+
+// ==============================
+//  Per step event
+// ==============================
+
+uint32_t calories_update(calories_t *c, uint32_t steps)
+{
+    if (steps == c->steps) return calories_get(c);
+    if (steps < c->steps) {
+        // Counter was reset (new workout)
+        c->steps = 0;
+        c->calories_q = 0;
+        c->seg = 0;
+        c->last_step_ms = 0;
+        c->interval_ms = 0;
+    }
+
+    if (c->mode == CALORIES_MODE_TABLE) {
+        // Crossing into later rows lands exactly on each row's value
+        while (c->seg < NUM_STEP_ROWS && steps >= step_counts[c->seg]) {
+            c->seg++;
+            c->steps = calories_seg_start(c->seg);
+            c->calories_q = c->row_q[c->seg];
+        }
+        c->calories_q += (uint64_t)(steps - c->steps) * c->slope_q[c->seg];
+    } else {
+        c->calories_q += (uint64_t)(steps - c->steps) * c->per_step_q;
+    }
+    c->steps = steps;
+    return calories_get(c);
+}
+
+// ==============================
+//  MET mode
+// ==============================
+
+// Stride scaled by the fourth root of the step peak (Weinberg)
+static float calories_stride_m(const calories_t *c)
+{
+    if (c->peak_mg == 0) return c->stride_m;
+    float k = sqrtf(sqrtf((float)c->peak_mg / (float)CALORIES_REF_PEAK_MG));
+    if (k < 0.8f) k = 0.8f;
+    if (k > 1.25f) k = 1.25f;
+    return c->stride_m * k;
+}
+
+static uint16_t calories_met_for_speed(uint32_t speed_mm_s)
+{
+    uint32_t b = CALORIES_MET_BANDS - 1u;
+    while (b > 0 && speed_mm_s < s_met_bands[b].speed_mm_s) b--;
+    return s_met_bands[b].met_x10;
+}
+
+uint32_t calories_step(calories_t *c, const step_event_t *e)
+{
+    if (c->mode != CALORIES_MODE_MET) return calories_update(c, c->steps + e->count);
+    if (e->count == 0) return calories_get(c);
+
+    uint32_t interval = c->last_step_ms ? (e->t_ms - c->last_step_ms) / e->count : 0;
+    c->last_step_ms = e->t_ms ? e->t_ms : 1u;   // 0 means "no previous step"
+    c->steps += e->count;
+
+    if (e->peak_mg) {
+        int32_t peak = c->peak_mg ? c->peak_mg + ((int32_t)e->peak_mg - c->peak_mg) / 4 : e->peak_mg;
+        c->peak_mg = (uint16_t)peak;
+    }
+
+    if (interval == 0 || interval > CALORIES_GAP_MS) {
+        // No cadence to go on yet
+        c->interval_ms = 0;
+        c->met_x10 = 0;
+        c->calories_q += (uint64_t)e->count * c->per_step_q;
+        return calories_get(c);
+    }
+    c->interval_ms = c->interval_ms ? (uint32_t)((int32_t)c->interval_ms + ((int32_t)interval - (int32_t)c->interval_ms) / 4)
+                                    : interval;
+
+    uint32_t speed_mm_s = (uint32_t)(calories_stride_m(c) * 1e6f / (float)c->interval_ms);
+    c->met_x10 = calories_met_for_speed(speed_mm_s);
+    float kcal = (float)c->met_x10 * 0.1f * c->kcal_per_met_ms * (float)c->interval_ms * (float)e->count;
+    c->calories_q += (uint64_t)(kcal * (float)(1u << CALORIES_Q) + 0.5f);
+    return calories_get(c);
+}
+
+void calories_restore(calories_t *c, uint32_t steps, uint32_t calories)
+{
+    calories_update(c, 0);
+    calories_update(c, steps);   // finds the table segment
+    c->calories_q = (uint64_t)calories << CALORIES_Q;
+}
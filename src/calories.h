@@ -0,0 +1,117 @@
+#ifndef CALORIES_H
+#define CALORIES_H
+
+#include <stdint.h>
+
+#include "step_detect.h"
+#include "steps_to_calories.h"
+
+// ==============================
+//  Calorie engine
+// ==============================
+//
+// Resolves the user profile against the tables in steps_to_calories.h once,
+// in calories_init(), into fixed-point calories per step. After that,
+// calories_update() only does work when the step count moves, and then
+// only for the new steps. It does no table search or interpolation.
+//
+// Modes:
+//   CALORIES_MODE_PER_1000 - per-1,000-step row for the height, interpolated
+//                            by weight; a straight line through zero
+//   CALORIES_MODE_TABLE    - the full 20x10 steps x weight table (measured
+//                            for medium height, scaled for the others),
+//                            interpolated in both directions
+//   CALORIES_MODE_MET      - each step costs its duration at the MET of the
+//                            current walking speed (default)
+//
+// MET mode is fed from the step event stream (calories_step()). It keeps a
+// rolling step interval (cadence) and a rolling step peak (intensity), O(1)
+// state updated per event. Speed is cadence times stride, where stride is
+// the height's steps-per-mile stride scaled by (peak / CALORIES_REF_PEAK_MG)^(1/4)
+// (Weinberg's stride model). Speed picks a band from the walking/running
+// MET table. A step costs MET * 3.5 ml O2/kg/min * weight over its
+// interval; at 3 mph that agrees with the per-1,000 tables. A step with
+// no cadence yet (first after a pause, or pedometer batches) is charged
+// at the per-1,000 rate.
+//
+
+typedef enum {
+    CALORIES_MODE_PER_1000,
+    CALORIES_MODE_TABLE,
+    CALORIES_MODE_MET,
+} calories_mode_t;
+
+#ifndef CALORIES_DEFAULT_MODE
+#define CALORIES_DEFAULT_MODE  CALORIES_MODE_MET
+#endif
+
+// Typical walking step peak for the stride model, mg
+#ifndef CALORIES_REF_PEAK_MG
+#define CALORIES_REF_PEAK_MG   400
+#endif
+
+// Calories carry 16 fractional bits internally
+#define CALORIES_Q             16
+
+typedef struct {
+    uint16_t          weight_lbs;
+    height_category_t height;
+    calories_mode_t   mode;
+} calories_profile_t;
+
+typedef struct {
+    calories_mode_t mode;
+    uint32_t per_step_q;                 // CALORIES_MODE_PER_1000 (and the table's tail)
+
+    // CALORIES_MODE_TABLE: calories at each table row for this profile,
+    // and per step up to the next row. Segment 0 runs from zero steps.
+    uint32_t row_q[NUM_STEP_ROWS + 1];
+    uint32_t slope_q[NUM_STEP_ROWS + 1];
+    uint8_t  seg;                        // segment holding `steps`
+
+    // CALORIES_MODE_MET
+    float    kcal_per_met_ms;            // weight * 3.5 / 200 per minute, per ms
+    float    stride_m;                   // at CALORIES_REF_PEAK_MG
+    uint32_t last_step_ms;
+    uint32_t interval_ms;                // rolling step interval, 0 = no cadence
+    uint16_t peak_mg;                    // rolling step peak, 0 = unknown
+    uint16_t met_x10;                    // MET of the last step
+
+    uint32_t steps;                      // count the cached value is for
+    uint64_t calories_q;
+} calories_t;
+
+// Resolve a profile; the count starts at zero steps
+void calories_init(calories_t *c, const calories_profile_t *profile);
+
+// Calories for `steps` (from the same counter as the previous call; a
+// smaller value is taken as a reset). Steps since the previous call are
+// added at the cached rate (the per-1,000 rate in MET mode).
+uint32_t calories_update(calories_t *c, uint32_t steps);
+
+// Add one step event; events must arrive in time order. Count-based modes
+// only use its count. Returns the new total.
+uint32_t calories_step(calories_t *c, const step_event_t *e);
+
+// Carry over a total from before a reset (e.g. the persistent log)
+void calories_restore(calories_t *c, uint32_t steps, uint32_t calories);
+
+// Rolling cadence in steps per minute (0 when not walking) and the MET of
+// the latest step, x10 (MET mode only)
+static inline uint32_t calories_cadence_spm(const calories_t *c)
+{
+    return c->interval_ms ? 60000u / c->interval_ms : 0;
+}
+
+static inline uint16_t calories_met_x10(const calories_t *c)
+{
+    return c->met_x10;
+}
+
+// Current total
+static inline uint32_t calories_get(const calories_t *c)
+{
+    return (uint32_t)(c->calories_q >> CALORIES_Q);
+}
+
+#endif // CALORIES_H
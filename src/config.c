@@ -0,0 +1,238 @@
+#include "config.h"
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "calories.h"
+#include "crc.h"
+#include "flash_log.h"
+#include "log.h"
+#include "step_detect.h"
+#include "telemetry.h"
+#include <string.h>
+
+// ==============================
+//  Fields
+// ==============================
+
+typedef struct {
+    uint16_t def;
+    uint16_t min;
+    uint16_t max;
+} config_range_t;
+
+static const config_range_t s_ranges[CONFIG_FIELD_COUNT] = {
+    [CONFIG_WEIGHT_LBS]                 = { USER_WEIGHT_LBS, 80, 400 },
+    [CONFIG_HEIGHT]                     = { USER_HEIGHT_CATEGORY, HEIGHT_TALL, HEIGHT_SHORT },
+    [CONFIG_CALORIES_MODE]              = { CALORIES_DEFAULT_MODE, CALORIES_MODE_PER_1000, CALORIES_MODE_MET },
+    [CONFIG_STEP_THRESHOLD_MG]          = { (uint16_t)(STEP_THRESHOLD_G * 1000.0f + 0.5f), 50, 2000 },
+    [CONFIG_STEP_MIN_INTERVAL_MS]       = { STEP_MIN_INTERVAL_MS, 100, 2000 },
+    [CONFIG_STEP_BLOCK_MIN_PEAK_MG]     = { STEP_BLOCK_MIN_PEAK_MG, 5, 1000 },
+    [CONFIG_STEP_BLOCK_MIN_INTERVAL_MS] = { STEP_BLOCK_MIN_INTERVAL_MS, 100, 1000 },
+    [CONFIG_STEP_GOAL_PER_HOUR]         = { 250, 1, 10000 },
+    [CONFIG_IDLE_TO_LOW_S]              = { 120, 10, 3600 },
+    [CONFIG_DISPLAY_REFRESH_MS]         = { 250, 50, 5000 },
+    [CONFIG_STEP_FLASH_MS]              = { 180, 0, 1000 },
+    [CONFIG_DISPLAY_SLEEP_S]            = { 15, 0, 3600 },
+    [CONFIG_POWER_SLEEP_S]              = { 600, 0, 43200 },
+};
+
+// ==============================
+//  Flash layout
+// ==============================
+//
+// Two sectors just below the activity log. Each holds at most one record
+// at its start; saves go to the sector not holding the newest one.
+
+#define CONFIG_SLOTS         2
+#define CONFIG_OFFSET        (PICO_FLASH_SIZE_BYTES - FLASH_LOG_REGION_SIZE - CONFIG_SLOTS * FLASH_SECTOR_SIZE)
+#define CONFIG_MAGIC         0x47464350u   // "PCFG"
+#define CONFIG_SAFE_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;          // increments per save; the highest is newest
+    uint16_t version;      // CONFIG_VERSION
+    uint16_t count;        // CONFIG_FIELD_COUNT
+    config_t values;
+    uint16_t crc;          // CRC-16 over everything above
+} config_record_t;
+
+_Static_assert(sizeof(config_record_t) <= FLASH_PAGE_SIZE, "config record must fit one page");
+_Static_assert(CONFIG_FIELD_COUNT <= TELEMETRY_CONFIG_MAX_FIELDS, "CONFIG frame can't carry every field");
+
+static config_t s_config = {0};
+static config_t s_saved;             // what flash holds (or the defaults)
+static uint32_t s_seq = 0;           // newest record's sequence number
+static int32_t  s_slot = -1;         // sector holding it, -1 = none
+static bool     s_loaded = false;
+
+// Page staged for programming, from RAM
+static uint8_t  s_page[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+
+static inline uint32_t config_slot_offset(uint32_t slot)
+{
+    return CONFIG_OFFSET + slot * FLASH_SECTOR_SIZE;
+}
+
+static inline const config_record_t *config_slot_record(uint32_t slot)
+{
+    return (const config_record_t *)(uintptr_t)(XIP_BASE + config_slot_offset(slot));
+}
+
+static bool config_record_valid(const config_record_t *r)
+{
+    return r->magic == CONFIG_MAGIC && r->version == CONFIG_VERSION &&
+           r->count == CONFIG_FIELD_COUNT &&
+           r->crc == crc16_ccitt(CRC16_INIT, r, offsetof(config_record_t, crc));
+}
+
+static uint16_t config_clamp(config_field_t f, uint32_t value)
+{
+    if (value < s_ranges[f].min) return s_ranges[f].min;
+    if (value > s_ranges[f].max) return s_ranges[f].max;
+    return (uint16_t)value;
+}
+
+// ==============================
+//  Public API
+// ==============================
+
+void config_reset_defaults(void)
+{
+    for (int f = 0; f < CONFIG_FIELD_COUNT; f++) {
+        s_config.v[f] = s_ranges[f].def;
+    }
+}
+
+bool config_init(void)
+{
+    config_reset_defaults();
+    s_slot = -1;
+    for (uint32_t slot = 0; slot < CONFIG_SLOTS; slot++) {
+        const config_record_t *r = config_slot_record(slot);
+        if (!config_record_valid(r)) continue;
+        if (s_slot < 0 || (int32_t)(r->seq - s_seq) > 0) {
+            s_slot = (int32_t)slot;
+            s_seq = r->seq;
+        }
+    }
+
+    s_loaded = s_slot >= 0;
+    if (s_loaded) {
+        // Clamp anyway: ranges may have tightened since it was written
+        const config_record_t *r = config_slot_record((uint32_t)s_slot);
+        for (int f = 0; f < CONFIG_FIELD_COUNT; f++) {
+            s_config.v[f] = config_clamp((config_field_t)f, r->values.v[f]);
+        }
+        LOG_I("Config v%u loaded (save #%lu)", CONFIG_VERSION, s_seq);
+    } else {
+        LOG_I("Config: using build defaults");
+    }
+    s_saved = s_config;
+    return s_loaded;
+}
+
+const config_t *config_get(void)
+{
+    return &s_config;
+}
+
+config_status_t config_set(config_field_t f, uint32_t value)
+{
+    if ((unsigned)f >= CONFIG_FIELD_COUNT) return CONFIG_ERR_FIELD;
+    s_config.v[f] = config_clamp(f, value);
+    return (s_config.v[f] == value) ? CONFIG_OK : CONFIG_ERR_RANGE;
+}
+
+bool config_dirty(void)
+{
+    return memcmp(&s_config, &s_saved, sizeof(s_config)) != 0;
+}
+
+static void __not_in_flash_func(config_do_write)(void *param)
+{
+    uint32_t offset = *(const uint32_t *)param;
+    flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    flash_range_program(offset, s_page, FLASH_PAGE_SIZE);
+}
+
+config_status_t config_save(void)
+{
+    uint32_t slot = (s_slot < 0) ? 0 : (uint32_t)(s_slot + 1) % CONFIG_SLOTS;
+    config_record_t r = {
+        .magic = CONFIG_MAGIC,
+        .seq = s_seq + 1,
+        .version = CONFIG_VERSION,
+        .count = CONFIG_FIELD_COUNT,
+        .values = s_config,
+    };
+    r.crc = crc16_ccitt(CRC16_INIT, &r, offsetof(config_record_t, crc));
+    memset(s_page, 0xFF, sizeof(s_page));
+    memcpy(s_page, &r, sizeof(r));
+
+    uint32_t offset = config_slot_offset(slot);
+    int rc = flash_safe_execute(config_do_write, &offset, CONFIG_SAFE_TIMEOUT_MS);
+    if (rc != PICO_OK || !config_record_valid(config_slot_record(slot))) {
+        LOG_E("Config save failed (%d)", rc);
+        return CONFIG_ERR_FLASH;
+    }
+    s_slot = (int32_t)slot;
+    s_seq = r.seq;
+    s_saved = s_config;
+    s_loaded = true;
+    LOG_I("Config saved (#%lu)", s_seq);
+    return CONFIG_OK;
+}
+
+// ==============================
+//  Telemetry commands
+// ==============================
+
+void config_send(config_status_t status)
+{
+    telemetry_config_t t = {
+        .status = (uint8_t)status,
+        .flags = (uint8_t)((s_loaded ? TELEMETRY_CONFIG_FROM_FLASH : 0) |
+                           (config_dirty() ? TELEMETRY_CONFIG_DIRTY : 0)),
+        .version = CONFIG_VERSION,
+        .count = CONFIG_FIELD_COUNT,
+    };
+    memcpy(t.values, s_config.v, sizeof(s_config.v));
+    telemetry_send_config(&t);
+}
+
+bool config_handle_command(uint8_t type, const uint8_t *payload, size_t len)
+{
+    config_t before = s_config;
+    config_status_t status = CONFIG_OK;
+
+    switch (type) {
+        case TELEMETRY_CMD_CONFIG_GET:
+            break;
+        case TELEMETRY_CMD_CONFIG_SET:
+            // [field u8][value u16], any number of them
+            if (len == 0 || len % 3 != 0) {
+                status = CONFIG_ERR_COMMAND;
+                break;
+            }
+            for (size_t i = 0; i < len; i += 3) {
+                uint16_t value = (uint16_t)(payload[i + 1] | (payload[i + 2] << 8));
+                config_status_t s = config_set((config_field_t)payload[i], value);
+                if (s != CONFIG_OK) status = s;
+            }
+            break;
+        case TELEMETRY_CMD_CONFIG_SAVE:
+            status = config_save();
+            break;
+        case TELEMETRY_CMD_CONFIG_DEFAULTS:
+            config_reset_defaults();
+            break;
+        default:
+            status = CONFIG_ERR_COMMAND;
+            break;
+    }
+
+    config_send(status);
+    return memcmp(&before, &s_config, sizeof(before)) != 0;
+}
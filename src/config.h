@@ -0,0 +1,101 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==============================
+//  Runtime configuration (flash-backed)
+// ==============================
+//
+// User profile and tuning that used to be compile-time #defines. One
+// versioned, CRC-checked record lives in flash, just below the activity
+// log, in two sectors used alternately so a power cut mid-save leaves
+// the previous copy intact. config_init() loads it once at boot. With no
+// valid record, or one from another CONFIG_VERSION, the build defaults
+// below are used.
+//
+// Every field is a uint16_t, identified over telemetry by its
+// config_field_t index (TELEMETRY_CMD_CONFIG_*, tools/telemetry_decode.py).
+// Values are clamped to each field's range. Nothing in a hot path reads
+// this struct per sample: derived constants (detector thresholds and filter
+// coefficients, calorie rates) are worked out by the owning module when it
+// is handed the new values (apply_config() in main.c).
+//
+
+// Bump when fields are added, removed or reordered
+#define CONFIG_VERSION  3
+
+// Build defaults
+#ifndef USER_WEIGHT_LBS
+#define USER_WEIGHT_LBS       160
+#endif
+#ifndef USER_HEIGHT_CATEGORY
+#define USER_HEIGHT_CATEGORY  HEIGHT_MEDIUM
+#endif
+
+typedef enum {
+    CONFIG_WEIGHT_LBS,
+    CONFIG_HEIGHT,                  // height_category_t
+    CONFIG_CALORIES_MODE,           // calories_mode_t
+    CONFIG_STEP_THRESHOLD_MG,       // threshold detectors
+    CONFIG_STEP_MIN_INTERVAL_MS,
+    CONFIG_STEP_BLOCK_MIN_PEAK_MG,  // block detector
+    CONFIG_STEP_BLOCK_MIN_INTERVAL_MS,
+    CONFIG_STEP_GOAL_PER_HOUR,
+    CONFIG_IDLE_TO_LOW_S,           // no steps for this long: IMU to low power
+    CONFIG_DISPLAY_REFRESH_MS,
+    CONFIG_STEP_FLASH_MS,           // OLED border flash per step
+    CONFIG_DISPLAY_SLEEP_S,         // no wake for this long: OLED off (0 = never)
+    CONFIG_POWER_SLEEP_S,           // activity level 0 this long: MCU sleeps (0 = never)
+    CONFIG_FIELD_COUNT
+} config_field_t;
+
+typedef struct {
+    uint16_t v[CONFIG_FIELD_COUNT];
+} config_t;
+
+// Result of the last telemetry command, echoed in the CONFIG frame
+typedef enum {
+    CONFIG_OK,
+    CONFIG_ERR_FIELD,     // no such field
+    CONFIG_ERR_RANGE,     // value clamped to the field's range
+    CONFIG_ERR_FLASH,     // save failed
+    CONFIG_ERR_COMMAND,   // unknown or malformed command
+} config_status_t;
+
+// Core 0, once at boot before anything reads the values. Returns true if
+// they came from flash.
+bool config_init(void);
+
+// Current values. Readable from either core: fields are single aligned
+// halfwords.
+const config_t *config_get(void);
+
+static inline uint16_t config_value(config_field_t f)
+{
+    return config_get()->v[f];
+}
+
+// Change one field in RAM (clamped to its range)
+config_status_t config_set(config_field_t f, uint32_t value);
+
+// Back to the build defaults (RAM only)
+void config_reset_defaults(void);
+
+// Write the current values to flash (core 0; parks core 1 briefly)
+config_status_t config_save(void);
+
+// True if the RAM values differ from the last saved/loaded ones
+bool config_dirty(void);
+
+// Handle a TELEMETRY_CMD_CONFIG_* command from the host (core 0) and
+// reply with a CONFIG frame. Returns true if any value changed, so the
+// caller re-applies them.
+bool config_handle_command(uint8_t type, const uint8_t *payload, size_t len);
+
+// Send the current values as a TELEMETRY_FRAME_CONFIG
+void config_send(config_status_t status);
+
+#endif // CONFIG_H
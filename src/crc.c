@@ -0,0 +1,18 @@
+#include "crc.h"
+
+// Nibble-at-a-time table: 32 bytes of flash instead of 512
+static const uint16_t s_crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t crc16_ccitt(uint16_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len--) {
+        uint8_t b = *p++;
+        crc = (uint16_t)((crc << 4) ^ s_crc16_nibble[(crc >> 12) ^ (b >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ s_crc16_nibble[(crc >> 12) ^ (b & 0x0F)]);
+    }
+    return crc;
+}
@@ -0,0 +1,12 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no xorout).
+// Pass the previous result as `crc` to continue over several buffers.
+#define CRC16_INIT  0xFFFFu
+uint16_t crc16_ccitt(uint16_t crc, const void *data, size_t len);
+
+#endif // CRC_H
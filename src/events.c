@@ -0,0 +1,96 @@
+#include "events.h"
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+#define EVENTS_MAX_GPIO  48
+
+static volatile uint32_t s_pending = 0;
+static uint32_t s_gpio_event[EVENTS_MAX_GPIO];
+static events_gpio_handler_t s_gpio_handler[EVENTS_MAX_GPIO];
+static struct repeating_timer s_tick_timer;
+static uint32_t s_tick_ms = 0;            // 0: timer not running
+
+static bool events_tick_cb(struct repeating_timer *t)
+{
+    (void)t;
+    events_post(EVENT_TICK);
+    return true; // keep repeating
+}
+
+static void events_gpio_cb(uint gpio, uint32_t event_mask)
+{
+    if (gpio >= EVENTS_MAX_GPIO) return;
+    if (s_gpio_handler[gpio]) {
+        s_gpio_handler[gpio](gpio, event_mask);
+    } else if (s_gpio_event[gpio]) {
+        events_post(s_gpio_event[gpio]);
+    }
+}
+
+void events_init(uint32_t tick_ms)
+{
+    s_pending = 0;
+    events_set_tick(tick_ms);
+}
+
+void events_set_tick(uint32_t tick_ms)
+{
+    if (tick_ms == s_tick_ms) return;
+    if (s_tick_ms > 0) {
+        cancel_repeating_timer(&s_tick_timer);
+    }
+    s_tick_ms = tick_ms;
+    if (tick_ms > 0) {
+        add_repeating_timer_ms(-(int32_t)tick_ms, events_tick_cb, NULL, &s_tick_timer);
+    }
+}
+
+void events_post(uint32_t events)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    s_pending |= events;
+    restore_interrupts(irq);
+}
+
+void events_bind_gpio(uint32_t gpio, uint32_t edge_mask, uint32_t event)
+{
+    if (gpio >= EVENTS_MAX_GPIO) return;
+    s_gpio_event[gpio] = event;
+    gpio_set_irq_enabled_with_callback(gpio, edge_mask, true, events_gpio_cb);
+}
+
+void events_bind_gpio_handler(uint32_t gpio, uint32_t edge_mask, events_gpio_handler_t handler)
+{
+    if (gpio >= EVENTS_MAX_GPIO) return;
+    s_gpio_handler[gpio] = handler;
+    gpio_set_irq_enabled_with_callback(gpio, edge_mask, true, events_gpio_cb);
+}
+
+uint32_t events_poll(void)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    uint32_t ev = s_pending;
+    s_pending = 0;
+    restore_interrupts(irq);
+    return ev;
+}
+
+uint32_t events_wait(void)
+{
+    for (;;) {
+        // Check with interrupts masked so an event posted between the check
+        // and the WFI can't be missed: a pending IRQ still wakes WFI, and
+        // the handler runs as soon as interrupts are restored.
+        uint32_t irq = save_and_disable_interrupts();
+        uint32_t ev = s_pending;
+        if (ev) {
+            s_pending = 0;
+            restore_interrupts(irq);
+            return ev;
+        }
+        __wfi();
+        restore_interrupts(irq);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Event-driven main loop support
+// ==============================
+//
+// Interrupt handlers post events as bits in a pending mask; the main loop
+// sleeps in events_wait() until at least one bit is set. Posting is safe
+// from interrupt context on the core that calls events_wait().
+//
+
+#define EVENT_IMU     (1u << 0)   // IMU INT1 (FIFO watermark / data-ready)
+#define EVENT_BUTTON  (1u << 1)   // Debounced button event queued (buttons.h)
+#define EVENT_TICK    (1u << 2)   // Periodic UI/housekeeping tick
+#define EVENT_BATTERY (1u << 3)   // Fuel-gauge ALRT (SOC change / low)
+
+// Start the periodic EVENT_TICK timer (tick_ms = 0 disables it).
+void events_init(uint32_t tick_ms);
+
+// Change the EVENT_TICK period (0 stops it), counting from now. A no-op if
+// it is already tick_ms.
+void events_set_tick(uint32_t tick_ms);
+
+// Post one or more events (bitwise OR of EVENT_*).
+void events_post(uint32_t events);
+
+// Post `event` whenever `gpio` sees one of the edges in `edge_mask`
+// (GPIO_IRQ_EDGE_RISE / GPIO_IRQ_EDGE_FALL).
+void events_bind_gpio(uint32_t gpio, uint32_t edge_mask, uint32_t event);
+
+// Call `handler` from the GPIO interrupt instead, with the edges seen, for
+// drivers that need more than an event bit (timestamps, debouncing). The
+// handler can post events itself.
+typedef void (*events_gpio_handler_t)(uint32_t gpio, uint32_t edges);
+void events_bind_gpio_handler(uint32_t gpio, uint32_t edge_mask, events_gpio_handler_t handler);
+
+// Return and clear the pending events without sleeping (0 if none).
+uint32_t events_poll(void);
+
+// Sleep (WFI) until at least one event is pending, then return and clear
+// the pending mask.
+uint32_t events_wait(void);
+
+#endif // EVENTS_H
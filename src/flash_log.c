@@ -0,0 +1,367 @@
+#include "flash_log.h"
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "crc.h"
+#include "log.h"
+#include <stddef.h>
+#include <string.h>
+
+// ==============================
+//  Layout
+// ==============================
+//
+// The last FLASH_LOG_REGION_SIZE bytes of flash, well clear of the image.
+// Segment = one erase sector = 16 pages of 16 records; slot 0 of page 0 is
+// the segment header.
+
+#define FLASH_LOG_OFFSET         (PICO_FLASH_SIZE_BYTES - FLASH_LOG_REGION_SIZE)
+#define FLASH_LOG_SEGMENT_SIZE   FLASH_SECTOR_SIZE
+#define FLASH_LOG_SEGMENTS       (FLASH_LOG_REGION_SIZE / FLASH_LOG_SEGMENT_SIZE)
+#define FLASH_LOG_PAGES          (FLASH_LOG_SEGMENT_SIZE / FLASH_PAGE_SIZE)
+#define FLASH_LOG_SLOT_SIZE      16u
+#define FLASH_LOG_SLOTS          (FLASH_PAGE_SIZE / FLASH_LOG_SLOT_SIZE)
+
+#define FLASH_LOG_MAGIC          0x474F4C53u   // "SLOG"
+#define FLASH_LOG_VERSION        1
+#define FLASH_LOG_KIND_SAMPLE    0x01
+
+#define FLASH_LOG_SAFE_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;          // increments per segment; the highest is newest
+    uint16_t version;
+    uint16_t reserved;
+    uint16_t reserved2;
+    uint16_t crc;          // CRC-16 over the 14 bytes above
+} flash_log_header_t;
+
+typedef struct {
+    uint32_t time_s;
+    uint32_t steps;
+    uint16_t calories;
+    uint8_t  battery;
+    uint8_t  kind;
+    uint16_t reserved;
+    uint16_t crc;          // CRC-16 over the 14 bytes above
+} flash_log_record_t;
+
+_Static_assert(sizeof(flash_log_header_t) == FLASH_LOG_SLOT_SIZE, "header must fill one slot");
+_Static_assert(sizeof(flash_log_record_t) == FLASH_LOG_SLOT_SIZE, "record must fill one slot");
+
+// ==============================
+//  State
+// ==============================
+
+static uint32_t s_segment = 0;       // segment being written
+static uint32_t s_seq = 0;           // its sequence number
+static uint32_t s_page = 0;          // page being filled within it
+static bool     s_need_erase = true; // segment must be erased before its first page
+
+// Staged copy of the page being filled: programmed whole, and re-programmed
+// in place as it fills (NOR only ever clears bits, so unchanged slots stay put)
+static uint8_t  s_stage[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+static uint32_t s_stage_slots = 0;   // slots in use, header included
+static bool     s_stage_dirty = false;
+
+static flash_log_entry_t s_last;
+static bool     s_have_last = false;
+static uint32_t s_time_base_s = 0;
+static uint32_t s_drops = 0;         // records lost to a page that wouldn't go out
+
+// ==============================
+//  Helpers
+// ==============================
+
+static inline uint32_t flash_log_page_offset(uint32_t segment, uint32_t page)
+{
+    return FLASH_LOG_OFFSET + segment * FLASH_LOG_SEGMENT_SIZE + page * FLASH_PAGE_SIZE;
+}
+
+static inline const uint8_t *flash_log_xip(uint32_t offset)
+{
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + offset);
+}
+
+static bool flash_log_slot_erased(const uint8_t *slot)
+{
+    for (uint32_t i = 0; i < FLASH_LOG_SLOT_SIZE; i++) {
+        if (slot[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+static bool flash_log_header_valid(const flash_log_header_t *h)
+{
+    return h->magic == FLASH_LOG_MAGIC && h->version == FLASH_LOG_VERSION &&
+           h->crc == crc16_ccitt(CRC16_INIT, h, offsetof(flash_log_header_t, crc));
+}
+
+static bool flash_log_record_valid(const flash_log_record_t *r)
+{
+    return r->kind == FLASH_LOG_KIND_SAMPLE &&
+           r->crc == crc16_ccitt(CRC16_INIT, r, offsetof(flash_log_record_t, crc));
+}
+
+static void flash_log_record_to_entry(const flash_log_record_t *r, flash_log_entry_t *e)
+{
+    e->time_s = r->time_s;
+    e->steps = r->steps;
+    e->calories = r->calories;
+    e->battery = r->battery;
+}
+
+// Start staging page 0 of a fresh segment (header in slot 0)
+static void flash_log_start_segment(uint32_t segment, uint32_t seq)
+{
+    s_segment = segment;
+    s_seq = seq;
+    s_page = 0;
+    s_need_erase = true;
+
+    memset(s_stage, 0xFF, sizeof(s_stage));
+    flash_log_header_t h = {
+        .magic = FLASH_LOG_MAGIC,
+        .seq = seq,
+        .version = FLASH_LOG_VERSION,
+        .reserved = 0,
+        .reserved2 = 0,
+    };
+    h.crc = crc16_ccitt(CRC16_INIT, &h, offsetof(flash_log_header_t, crc));
+    memcpy(s_stage, &h, sizeof(h));
+    s_stage_slots = 1;
+    s_stage_dirty = false;   // an empty segment isn't worth an erase yet
+}
+
+// After a full page went out: move to the next page or segment
+static void flash_log_next_page(void)
+{
+    if (s_page + 1 < FLASH_LOG_PAGES) {
+        s_page++;
+        memset(s_stage, 0xFF, sizeof(s_stage));
+        s_stage_slots = 0;
+        return;
+    }
+    flash_log_start_segment((s_segment + 1) % FLASH_LOG_SEGMENTS, s_seq + 1);
+}
+
+// A page that doesn't verify can't be mended in place (NOR only clears
+// bits): give up on it, and the records staged in it, rather than retry it
+// forever. A bad page 0 takes the segment header with it, so that moves on
+// to the next segment.
+static void flash_log_skip_page(void)
+{
+    if (s_page == 0) {
+        flash_log_start_segment((s_segment + 1) % FLASH_LOG_SEGMENTS, s_seq + 1);
+    } else {
+        flash_log_next_page();
+        s_stage_dirty = false;
+    }
+}
+
+// ==============================
+//  Flash access (runs from RAM, core 1 parked)
+// ==============================
+
+typedef struct {
+    uint32_t page_offset;
+    bool     erase;
+} flash_log_op_t;
+
+static void __not_in_flash_func(flash_log_do_write)(void *param)
+{
+    const flash_log_op_t *op = (const flash_log_op_t *)param;
+    if (op->erase) {
+        flash_range_erase(op->page_offset & ~(FLASH_SECTOR_SIZE - 1u), FLASH_SECTOR_SIZE);
+    }
+    flash_range_program(op->page_offset, s_stage, FLASH_PAGE_SIZE);
+}
+
+static bool flash_log_write_stage(void)
+{
+    flash_log_op_t op = {
+        .page_offset = flash_log_page_offset(s_segment, s_page),
+        .erase = s_need_erase,
+    };
+    int rc = flash_safe_execute(flash_log_do_write, &op, FLASH_LOG_SAFE_TIMEOUT_MS);
+    if (rc != PICO_OK) {
+        LOG_W("flash_log: write deferred (%d)", rc);
+        return false;
+    }
+    if (memcmp(flash_log_xip(op.page_offset), s_stage, FLASH_PAGE_SIZE) != 0) {
+        LOG_E("flash_log: verify failed at 0x%08lx; page skipped", op.page_offset);
+        flash_log_skip_page();
+        return false;
+    }
+    s_need_erase = false;
+    s_stage_dirty = false;
+    return true;
+}
+
+// ==============================
+//  Public API
+// ==============================
+
+bool flash_log_init(void)
+{
+    // 1) Newest segment, from the headers alone
+    int32_t newest = -1;
+    uint32_t newest_seq = 0;
+    for (uint32_t seg = 0; seg < FLASH_LOG_SEGMENTS; seg++) {
+        const flash_log_header_t *h =
+            (const flash_log_header_t *)flash_log_xip(flash_log_page_offset(seg, 0));
+        if (!flash_log_header_valid(h)) continue;
+        if (newest < 0 || (int32_t)(h->seq - newest_seq) > 0) {
+            newest = (int32_t)seg;
+            newest_seq = h->seq;
+        }
+    }
+
+    s_have_last = false;
+    s_time_base_s = 0;
+    if (newest < 0) {
+        // Empty (or foreign) region: start over at segment 0
+        flash_log_start_segment(0, 1);
+        return false;
+    }
+
+    // 2) Last used page of that segment (page 0 always holds the header)
+    uint32_t page = 0;
+    while (page + 1 < FLASH_LOG_PAGES &&
+           !flash_log_slot_erased(flash_log_xip(flash_log_page_offset((uint32_t)newest, page + 1)))) {
+        page++;
+    }
+
+    // 3) Pick up its records; the newest valid one is the last entry
+    s_segment = (uint32_t)newest;
+    s_seq = newest_seq;
+    s_page = page;
+    s_need_erase = false;
+    memcpy(s_stage, flash_log_xip(flash_log_page_offset(s_segment, page)), FLASH_PAGE_SIZE);
+    s_stage_slots = 0;
+    for (uint32_t slot = 0; slot < FLASH_LOG_SLOTS; slot++) {
+        const uint8_t *p = &s_stage[slot * FLASH_LOG_SLOT_SIZE];
+        if (flash_log_slot_erased(p)) break;
+        s_stage_slots = slot + 1;
+        const flash_log_record_t *r = (const flash_log_record_t *)p;
+        if (!(page == 0 && slot == 0) && flash_log_record_valid(r)) {
+            flash_log_record_to_entry(r, &s_last);
+            s_have_last = true;
+        }
+    }
+    s_stage_dirty = false;
+    if (s_stage_slots == FLASH_LOG_SLOTS) {
+        flash_log_next_page();
+    }
+
+    if (!s_have_last && (s_page > 0 || s_segment != 0)) {
+        // Current page had nothing usable; fall back to the previous page's tail
+        uint32_t seg = s_segment, pg = s_page;
+        if (pg == 0) {
+            seg = (seg + FLASH_LOG_SEGMENTS - 1) % FLASH_LOG_SEGMENTS;
+            pg = FLASH_LOG_PAGES;
+        }
+        const uint8_t *prev = flash_log_xip(flash_log_page_offset(seg, pg - 1));
+        for (int32_t slot = FLASH_LOG_SLOTS - 1; slot >= 0 && !s_have_last; slot--) {
+            const flash_log_record_t *r = (const flash_log_record_t *)&prev[slot * FLASH_LOG_SLOT_SIZE];
+            if (flash_log_record_valid(r)) {
+                flash_log_record_to_entry(r, &s_last);
+                s_have_last = true;
+            }
+        }
+    }
+
+    if (s_have_last) {
+        s_time_base_s = s_last.time_s + 1;
+    }
+    return s_have_last;
+}
+
+bool flash_log_last(flash_log_entry_t *out)
+{
+    if (!s_have_last) return false;
+    if (out) *out = s_last;
+    return true;
+}
+
+uint32_t flash_log_time_s(uint32_t now_ms)
+{
+    return s_time_base_s + now_ms / 1000u;
+}
+
+void flash_log_for_each(flash_log_visitor_t visit, void *ctx)
+{
+    // Round-robin, so the segment after the current one is the oldest. Its
+    // sequence number must match that position: anything else is left over
+    // from an earlier pass (e.g. the next segment, not erased yet).
+    for (uint32_t n = 1; n <= FLASH_LOG_SEGMENTS; n++) {
+        uint32_t seg = (s_segment + n) % FLASH_LOG_SEGMENTS;
+        const flash_log_header_t *h =
+            (const flash_log_header_t *)flash_log_xip(flash_log_page_offset(seg, 0));
+        if (!flash_log_header_valid(h) || h->seq != s_seq - FLASH_LOG_SEGMENTS + n) continue;
+
+        for (uint32_t page = 0; page < FLASH_LOG_PAGES; page++) {
+            const uint8_t *p = flash_log_xip(flash_log_page_offset(seg, page));
+            for (uint32_t slot = (page == 0) ? 1 : 0; slot < FLASH_LOG_SLOTS; slot++) {
+                const flash_log_record_t *r = (const flash_log_record_t *)&p[slot * FLASH_LOG_SLOT_SIZE];
+                if (!flash_log_record_valid(r)) continue;
+                flash_log_entry_t e;
+                flash_log_record_to_entry(r, &e);
+                visit(&e, ctx);
+            }
+        }
+    }
+}
+
+void flash_log_append(const flash_log_entry_t *entry)
+{
+    if (s_stage_slots >= FLASH_LOG_SLOTS) {
+        // The previous full page hasn't made it out yet. Its slots may
+        // already be programmed (a partial flush, or a write that failed
+        // verify), so nothing in it can be rewritten: drop this record.
+        s_drops++;
+        LOG_W("flash_log: page not written yet, record dropped (%lu)", s_drops);
+        return;
+    }
+
+    flash_log_record_t r = {
+        .time_s = entry->time_s,
+        .steps = entry->steps,
+        .calories = entry->calories,
+        .battery = entry->battery,
+        .kind = FLASH_LOG_KIND_SAMPLE,
+        .reserved = 0,
+    };
+    r.crc = crc16_ccitt(CRC16_INIT, &r, offsetof(flash_log_record_t, crc));
+    memcpy(&s_stage[s_stage_slots * FLASH_LOG_SLOT_SIZE], &r, sizeof(r));
+    s_stage_slots++;
+    s_stage_dirty = true;
+
+    s_last = *entry;
+    s_have_last = true;
+}
+
+bool flash_log_pending(void)
+{
+    return s_stage_dirty && s_stage_slots == FLASH_LOG_SLOTS;
+}
+
+bool flash_log_service(void)
+{
+    if (!flash_log_pending()) return true;
+    if (!flash_log_write_stage()) return false;
+    flash_log_next_page();
+    return true;
+}
+
+bool flash_log_flush(void)
+{
+    if (!s_stage_dirty) return true;
+    if (!flash_log_write_stage()) return false;
+    if (s_stage_slots == FLASH_LOG_SLOTS) {
+        flash_log_next_page();
+    }
+    return true;
+}
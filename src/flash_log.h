@@ -0,0 +1,66 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Persistent activity log (on-board flash)
+// ==============================
+//
+// Append-only 16-byte records (time, steps, calories, battery), each with
+// its own CRC. Records are staged in RAM and programmed a whole 256-byte
+// page at a time into the current segment (one 4 KB sector). A full segment
+// moves on to the next one, round-robin, which is erased first, so wear is
+// spread evenly over the region. Each segment starts with a header holding
+// a sequence number, so boot only reads the headers to find the newest
+// segment, then that segment's pages.
+//
+// Flash writes stall XIP, so they run from RAM under flash_safe_execute()
+// with core 1 parked (it must call flash_safe_execute_core_init()). Sensor
+// data keeps collecting in the IMU FIFO meanwhile.
+//
+
+// Size of the log region at the very end of flash (config.c sits below it)
+#define FLASH_LOG_REGION_SIZE    (64u * 1024u)
+
+typedef struct {
+    uint32_t time_s;      // log clock: seconds, monotonic across reboots
+    uint32_t steps;       // total steps at that time
+    uint16_t calories;
+    uint8_t  battery;     // percent
+} flash_log_entry_t;
+
+// Find the newest segment and the write position. Returns true if a
+// previous record exists (see flash_log_last()).
+bool flash_log_init(void);
+
+// Newest record, staged or in flash. Returns false if the log is empty.
+bool flash_log_last(flash_log_entry_t *out);
+
+// Log-clock time for an uptime in ms: carries on from the newest record
+// found at boot
+uint32_t flash_log_time_s(uint32_t now_ms);
+
+// Visit every valid record in flash, oldest first (after flash_log_init();
+// XIP reads only). Boot uses it to rebuild the step history.
+typedef void (*flash_log_visitor_t)(const flash_log_entry_t *entry, void *ctx);
+void flash_log_for_each(flash_log_visitor_t visit, void *ctx);
+
+// Stage a record in RAM (cheap, never touches flash). Dropped if the
+// previous full page still hasn't gone out.
+void flash_log_append(const flash_log_entry_t *entry);
+
+// True when a full page is staged and waiting for flash_log_service()
+bool flash_log_pending(void);
+
+// Program the staged page if it's full. Call right after draining the IMU
+// FIFO, so the stall has the whole FIFO depth to spare. Returns false if
+// the write failed: a deferred write stays staged and is retried next time,
+// a page that doesn't verify is skipped along with its records.
+bool flash_log_service(void);
+
+// Write whatever is staged now, even a partial page (e.g. before a reset)
+bool flash_log_flush(void);
+
+#endif // FLASH_LOG_H
@@ -0,0 +1,108 @@
+#include "history.h"
+
+#include <string.h>
+
+typedef struct {
+    uint16_t *buckets;
+    uint8_t   size;
+    uint32_t  span_s;     // seconds per bucket
+    uint32_t  unit;       // absolute index (time / span) of the current bucket
+    uint32_t  total;      // sum of every bucket in the ring
+} history_ring_t;
+
+static uint16_t s_minutes[HISTORY_MINUTES];
+static uint16_t s_hours[HISTORY_HOURS];
+static uint16_t s_days[HISTORY_DAYS];
+
+static history_ring_t s_rings[HISTORY_TIER_COUNT] = {
+    [HISTORY_TIER_MINUTE] = { s_minutes, HISTORY_MINUTES, 60u,        0, 0 },
+    [HISTORY_TIER_HOUR]   = { s_hours,   HISTORY_HOURS,   3600u,      0, 0 },
+    [HISTORY_TIER_DAY]    = { s_days,    HISTORY_DAYS,    24u * 3600u, 0, 0 },
+};
+
+// Ring slot for an absolute unit index; slots are tied to absolute time,
+// so there is no separate head to keep in step
+static inline uint16_t *history_slot(history_ring_t *r, uint32_t unit)
+{
+    return &r->buckets[unit % r->size];
+}
+
+static void history_ring_advance(history_ring_t *r, uint32_t now_s)
+{
+    uint32_t unit = now_s / r->span_s;
+    uint32_t gap = unit - r->unit;
+    if ((int32_t)gap <= 0) return;
+
+    if (gap >= r->size) {
+        memset(r->buckets, 0, r->size * sizeof(r->buckets[0]));
+        r->total = 0;
+    } else {
+        // At most size-1 buckets expire
+        for (uint32_t u = r->unit + 1; u <= unit; u++) {
+            uint16_t *b = history_slot(r, u);
+            r->total -= *b;
+            *b = 0;
+        }
+    }
+    r->unit = unit;
+}
+
+static void history_ring_add(history_ring_t *r, uint32_t steps, uint32_t at_s)
+{
+    uint32_t ago = r->unit - at_s / r->span_s;
+    if (ago >= r->size) return;   // older than the ring (or the future)
+
+    uint16_t *b = history_slot(r, r->unit - ago);
+    uint32_t room = 0xFFFFu - *b;
+    if (steps > room) steps = room;
+    *b = (uint16_t)(*b + steps);
+    r->total += steps;
+}
+
+void history_init(uint32_t now_s)
+{
+    for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+        history_ring_t *r = &s_rings[t];
+        memset(r->buckets, 0, r->size * sizeof(r->buckets[0]));
+        r->total = 0;
+        r->unit = now_s / r->span_s;
+    }
+}
+
+void history_advance(uint32_t now_s)
+{
+    for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+        history_ring_advance(&s_rings[t], now_s);
+    }
+}
+
+void history_add_steps(uint32_t steps, uint32_t at_s)
+{
+    if (steps == 0) return;
+    history_advance(at_s);
+    for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+        history_ring_add(&s_rings[t], steps, at_s);
+    }
+}
+
+uint32_t history_steps_last(history_tier_t tier, uint8_t n)
+{
+    if (tier >= HISTORY_TIER_COUNT) return 0;
+    history_ring_t *r = &s_rings[tier];
+    if (n >= r->size) return r->total;
+    if (n > r->unit + 1) n = (uint8_t)(r->unit + 1);   // nothing before time zero
+
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        sum += *history_slot(r, r->unit - i);
+    }
+    return sum;
+}
+
+uint16_t history_bucket(history_tier_t tier, uint8_t ago)
+{
+    if (tier >= HISTORY_TIER_COUNT) return 0;
+    history_ring_t *r = &s_rings[tier];
+    if (ago >= r->size || ago > r->unit) return 0;
+    return *history_slot(r, r->unit - ago);
+}
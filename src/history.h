@@ -0,0 +1,56 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Tiered step history
+// ==============================
+//
+// Three rings of 16-bit buckets: the last 60 minutes, 24 hours and 30 days.
+// Each step is added to its minute, hour and day bucket at once, so nothing
+// has to be rolled up later, and catching up after a gap clears at most one
+// ring's worth of buckets (or the whole ring in one go), however long the
+// gap was. Buckets saturate at 65535.
+//
+// Time is in seconds on a monotonic base. Minutes/hours/days are aligned to
+// that base's zero, so "today" means the current 24 h period since it.
+//
+
+#define HISTORY_MINUTES  60
+#define HISTORY_HOURS    24
+#define HISTORY_DAYS     30
+
+typedef enum {
+    HISTORY_TIER_MINUTE,
+    HISTORY_TIER_HOUR,
+    HISTORY_TIER_DAY,
+    HISTORY_TIER_COUNT
+} history_tier_t;
+
+// Clear everything and start at now_s
+void history_init(uint32_t now_s);
+
+// Move the current buckets forward to now_s (constant time)
+void history_advance(uint32_t now_s);
+
+// Add steps taken at at_s. Advances to at_s if it's newer than the current
+// buckets; older times still land in their own bucket while it's in range.
+void history_add_steps(uint32_t steps, uint32_t at_s);
+
+// Steps in the current bucket and the n-1 before it (n is clamped to the
+// ring size). Whole-ring totals are kept running, so n = ring size is O(1).
+uint32_t history_steps_last(history_tier_t tier, uint8_t n);
+
+// One bucket, `ago` buckets back from the current one (0 = current)
+uint16_t history_bucket(history_tier_t tier, uint8_t ago);
+
+// Convenience ranges
+static inline uint32_t history_steps_last_minutes(uint8_t n) { return history_steps_last(HISTORY_TIER_MINUTE, n); }
+static inline uint32_t history_steps_last_hours(uint8_t n)   { return history_steps_last(HISTORY_TIER_HOUR, n); }
+static inline uint32_t history_steps_last_days(uint8_t n)    { return history_steps_last(HISTORY_TIER_DAY, n); }
+static inline uint32_t history_steps_today(void)             { return history_bucket(HISTORY_TIER_DAY, 0); }
+static inline uint32_t history_steps_this_week(void)         { return history_steps_last(HISTORY_TIER_DAY, 7); }
+
+#endif // HISTORY_H
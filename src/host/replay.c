@@ -0,0 +1,477 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define REPLAY_HAVE_TSC 1
+#else
+#define REPLAY_HAVE_TSC 0
+#endif
+
+#include "../calories.h"
+#include "../crc.h"
+#include "../step_detect.h"
+
+// ==============================
+//  Step detector replay (env:native_replay)
+// ==============================
+//
+// Runs recorded walks through the same step_detect.c the firmware uses, as
+// fast as the host allows, and reports per trace:
+//   - steps found vs the true count, and the error
+//   - detector cost per sample (ns, and TSC cycles on x86) and speed-up
+//     over real time
+//   - calories through the firmware's calorie engine, from the step events
+//     (and, for reference, from the true count alone)
+//   - heap calls made from inside the detector (must stay 0)
+//
+// Traces are either CSV as written by tools/telemetry_decode.py --csv
+// (t_ms,odr_hz,ax,ay,az) or a raw telemetry capture (--raw, or
+// telemetry_decode.py's input), whose ACCEL frames are replayed and whose
+// STEP frames give the count the device itself made.
+//
+// The true count comes from "path=STEPS" on the command line or a
+// "# steps=STEPS" line in a CSV. Tuning constants (STEP_THRESHOLD_G,
+// STEP_DETECTOR, ...) are build flags: change build_flags in platformio.ini
+// and rerun.
+//
+// Usage: replay [--weight LBS] [--height tall|medium|short] [--calories per-1000|table|met] [--max-error PCT]
+//               walk1.csv=1043 walk2.bin ...
+//
+
+#define REPLAY_MAX_SAMPLES   (1u << 22)   // ~11 h at 104 Hz
+#define REPLAY_REPEAT_MIN    2000000u     // repeat short traces so timings are stable
+
+// Telemetry frames (src/telemetry.h)
+#define REPLAY_FRAME_ACCEL   0x01
+#define REPLAY_FRAME_STEP    0x02
+#define REPLAY_FRAME_MAX     512
+#define REPLAY_ACCEL_MAX     32           // TELEMETRY_ACCEL_MAX_SAMPLES
+
+typedef struct {
+    uint32_t t_ms;
+    uint16_t odr_hz;
+    uint16_t n;
+} replay_block_t;
+
+// Traces are loaded into blocks exactly as the firmware would see them
+static int16_t        s_xyz[REPLAY_MAX_SAMPLES * 3];
+static replay_block_t s_blocks[REPLAY_MAX_SAMPLES / 8];
+static size_t         s_sample_count;
+static size_t         s_block_count;
+static uint32_t       s_device_steps;     // from STEP frames in a capture
+static bool           s_have_device_steps;
+
+// ==============================
+//  Allocation check
+// ==============================
+//
+// glibc lets a program replace malloc and friends; the replacements count
+// calls made while the detector is running and forward to the real ones.
+
+static volatile bool s_in_detector;
+static uint32_t      s_detector_allocs;
+
+#if defined(__GLIBC__)
+#define REPLAY_ALLOC_CHECK 1
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void  __libc_free(void *p);
+
+void *malloc(size_t size)
+{
+    if (s_in_detector) s_detector_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    if (s_in_detector) s_detector_allocs++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    if (s_in_detector) s_detector_allocs++;
+    return __libc_realloc(p, size);
+}
+
+void free(void *p)
+{
+    if (s_in_detector && p) s_detector_allocs++;
+    __libc_free(p);
+}
+#else
+#define REPLAY_ALLOC_CHECK 0
+#endif
+
+// ==============================
+//  Trace loading
+// ==============================
+
+// Append n samples taken at odr_hz from t_ms on, splitting them into
+// detector-sized blocks
+static bool replay_add_samples(uint32_t t_ms, uint16_t odr_hz, const int16_t *xyz, size_t n)
+{
+    if (s_sample_count + n > REPLAY_MAX_SAMPLES) return false;
+    uint32_t period_us = 1000000u / (odr_hz ? odr_hz : 1);
+    size_t off = 0;
+    while (off < n) {
+        size_t chunk = n - off;
+        if (chunk > STEP_DETECT_MAX_BLOCK) chunk = STEP_DETECT_MAX_BLOCK;
+        if (s_block_count == sizeof(s_blocks) / sizeof(s_blocks[0])) return false;
+        s_blocks[s_block_count++] = (replay_block_t){
+            .t_ms = t_ms + (uint32_t)((off * period_us) / 1000u),
+            .odr_hz = odr_hz,
+            .n = (uint16_t)chunk,
+        };
+        memcpy(&s_xyz[s_sample_count * 3], &xyz[off * 3], chunk * 3 * sizeof(int16_t));
+        s_sample_count += chunk;
+        off += chunk;
+    }
+    return true;
+}
+
+// CSV: one sample per line. Consecutive samples at the same rate, without
+// a gap, are batched like the FIFO drain would batch them.
+static bool replay_load_csv(FILE *f, long *true_steps)
+{
+    char line[256];
+    int16_t run[STEP_DETECT_MAX_BLOCK * 3];
+    size_t run_n = 0;
+    double run_t0 = 0.0, last_t = 0.0;
+    uint16_t run_odr = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        long steps;
+        if (sscanf(line, "# steps=%ld", &steps) == 1) {
+            if (*true_steps < 0) *true_steps = steps;
+            continue;
+        }
+        double t;
+        unsigned odr;
+        int ax, ay, az;
+        if (sscanf(line, "%lf,%u,%d,%d,%d", &t, &odr, &ax, &ay, &az) != 5 || odr == 0) {
+            continue;   // header, comments
+        }
+
+        double period_ms = 1000.0 / odr;
+        bool contiguous = run_n > 0 && odr == run_odr && (t - last_t) < 1.5 * period_ms;
+        if (run_n == STEP_DETECT_MAX_BLOCK || (run_n > 0 && !contiguous)) {
+            if (!replay_add_samples((uint32_t)(run_t0 + 0.5), run_odr, run, run_n)) return false;
+            run_n = 0;
+        }
+        if (run_n == 0) {
+            run_t0 = t;
+            run_odr = (uint16_t)odr;
+        }
+        run[run_n * 3 + 0] = (int16_t)ax;
+        run[run_n * 3 + 1] = (int16_t)ay;
+        run[run_n * 3 + 2] = (int16_t)az;
+        run_n++;
+        last_t = t;
+    }
+    return run_n == 0 || replay_add_samples((uint32_t)(run_t0 + 0.5), run_odr, run, run_n);
+}
+
+static size_t replay_cobs_decode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < len;) {
+        uint8_t code = in[i];
+        if (code == 0 || i + code > len) return 0;
+        memcpy(&out[o], &in[i + 1], code - 1u);
+        o += code - 1u;
+        i += code;
+        if (code < 0xFF && i < len) out[o++] = 0;
+    }
+    return o;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Raw capture: 0x00-delimited COBS frames, anything else (printf text,
+// corrupt frames) is skipped
+static bool replay_load_capture(FILE *f)
+{
+    uint8_t enc[REPLAY_FRAME_MAX], raw[REPLAY_FRAME_MAX];
+    size_t len = 0;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (c != 0) {
+            if (len < sizeof(enc)) enc[len] = (uint8_t)c;
+            len++;
+            continue;
+        }
+        size_t n = (len <= sizeof(enc)) ? replay_cobs_decode(enc, len, raw) : 0;
+        len = 0;
+        if (n < 5) continue;
+        uint16_t crc = (uint16_t)(raw[n - 2] | (raw[n - 1] << 8));
+        if (crc16_ccitt(CRC16_INIT, raw, n - 2) != crc) continue;
+
+        const uint8_t *payload = &raw[3];
+        size_t payload_len = n - 5;
+        if (raw[0] == REPLAY_FRAME_ACCEL && payload_len >= 8) {
+            uint32_t t0 = get_u32(payload);
+            uint16_t odr = (uint16_t)(payload[4] | (payload[5] << 8));
+            size_t count = payload[6];
+            if (payload_len < 8 + count * 6 || odr == 0) continue;
+            if (count > REPLAY_ACCEL_MAX) continue;
+            int16_t xyz[REPLAY_ACCEL_MAX * 3];
+            for (size_t i = 0; i < count * 3; i++) {
+                const uint8_t *p = &payload[8 + 2 * i];
+                xyz[i] = (int16_t)(p[0] | (p[1] << 8));
+            }
+            if (!replay_add_samples(t0, odr, xyz, count)) return false;
+        } else if (raw[0] == REPLAY_FRAME_STEP && payload_len >= 9) {
+            s_device_steps += payload[8];
+            s_have_device_steps = true;
+        }
+    }
+    return true;
+}
+
+static bool replay_load(const char *path, long *true_steps)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    s_sample_count = 0;
+    s_block_count = 0;
+    s_device_steps = 0;
+    s_have_device_steps = false;
+
+    const char *ext = strrchr(path, '.');
+    bool ok = (ext && strcmp(ext, ".csv") == 0) ? replay_load_csv(f, true_steps) : replay_load_capture(f);
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: trace too long (max %u samples)\n", path, REPLAY_MAX_SAMPLES);
+    return ok;
+}
+
+// ==============================
+//  Replay
+// ==============================
+
+static uint64_t replay_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t replay_cycles(void)
+{
+#if REPLAY_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// One pass over the loaded trace with a fresh detector; returns the steps
+// found. With cal set, the step events also go to the calorie engine.
+static uint32_t replay_pass(uint32_t *ref_steps, calories_t *cal)
+{
+    static step_detector_t det;
+    step_event_t events[STEP_DETECT_MAX_BLOCK];
+    uint32_t steps = 0;
+
+    step_detect_init(&det, s_block_count ? s_blocks[0].odr_hz : 104);
+    const int16_t *xyz = s_xyz;
+    for (size_t b = 0; b < s_block_count; b++) {
+        const replay_block_t *blk = &s_blocks[b];
+        if (blk->odr_hz != det.odr_hz) step_detect_set_odr(&det, blk->odr_hz);
+        size_t found = step_detect_block(&det, xyz, blk->n, blk->t_ms, events);
+        for (size_t i = 0; cal && i < found; i++) {
+            calories_step(cal, &events[i]);
+        }
+        steps += (uint32_t)found;
+        xyz += 3 * blk->n;
+    }
+    *ref_steps = det.ref_steps;
+    return steps;
+}
+
+typedef struct {
+    uint64_t samples;
+    uint64_t ns;
+    uint64_t cycles;
+    double   real_s;
+    long     steps;
+    long     truth;
+    uint32_t allocs;
+} replay_totals_t;
+
+static const char *s_height_names[] = {
+    [HEIGHT_TALL] = "tall", [HEIGHT_MEDIUM] = "medium", [HEIGHT_SHORT] = "short",
+};
+
+// Calories for a bare count (no event timing: the per-1,000 rate in MET mode)
+static uint32_t replay_calories(const calories_profile_t *profile, uint32_t steps)
+{
+    calories_t cal;
+    calories_init(&cal, profile);
+    return calories_update(&cal, steps);
+}
+
+static const char *s_mode_names[] = {
+    [CALORIES_MODE_PER_1000] = "per-1000", [CALORIES_MODE_TABLE] = "table", [CALORIES_MODE_MET] = "met",
+};
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: replay [--weight LBS] [--height tall|medium|short] [--calories per-1000|table|met] [--max-error PCT]\n"
+                    "              trace.csv[=STEPS] capture.bin[=STEPS] ...\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    calories_profile_t profile = {
+        .weight_lbs = 160, .height = HEIGHT_MEDIUM, .mode = CALORIES_DEFAULT_MODE,
+    };
+    double max_error = -1.0;
+    replay_totals_t total = {0};
+    int traces = 0, failed = 0, paths = 0;
+
+    printf("detector=%d threshold=%.3fg min_interval=%dms ab_compare=%d heap_check=%s\n",
+           STEP_DETECTOR, (double)STEP_THRESHOLD_G, STEP_MIN_INTERVAL_MS, STEP_DETECT_AB_COMPARE,
+           REPLAY_ALLOC_CHECK ? "on" : "unavailable");
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--weight") == 0 && a + 1 < argc) {
+            profile.weight_lbs = (uint16_t)atoi(argv[++a]);
+            continue;
+        }
+        if (strcmp(argv[a], "--height") == 0 && a + 1 < argc) {
+            const char *h = argv[++a];
+            if (strcmp(h, "tall") == 0) profile.height = HEIGHT_TALL;
+            else if (strcmp(h, "medium") == 0) profile.height = HEIGHT_MEDIUM;
+            else if (strcmp(h, "short") == 0) profile.height = HEIGHT_SHORT;
+            else usage();
+            continue;
+        }
+        if (strcmp(argv[a], "--calories") == 0 && a + 1 < argc) {
+            const char *m = argv[++a];
+            if (strcmp(m, "per-1000") == 0) profile.mode = CALORIES_MODE_PER_1000;
+            else if (strcmp(m, "table") == 0) profile.mode = CALORIES_MODE_TABLE;
+            else if (strcmp(m, "met") == 0) profile.mode = CALORIES_MODE_MET;
+            else usage();
+            continue;
+        }
+        if (strcmp(argv[a], "--max-error") == 0 && a + 1 < argc) {
+            max_error = atof(argv[++a]);
+            continue;
+        }
+        if (argv[a][0] == '-') usage();
+        argv[1 + paths++] = argv[a];   // options apply to every trace, wherever they are
+    }
+
+    for (int a = 1; a <= paths; a++) {
+        // path[=true steps]
+        char path[1024];
+        long truth = -1;
+        snprintf(path, sizeof(path), "%s", argv[a]);
+        char *eq = strrchr(path, '=');
+        if (eq) {
+            *eq = '\0';
+            truth = atol(eq + 1);
+        }
+        if (!replay_load(path, &truth)) {
+            failed++;
+            continue;
+        }
+        if (s_sample_count == 0) {
+            fprintf(stderr, "%s: no accelerometer samples\n", path);
+            failed++;
+            continue;
+        }
+        if (truth < 0 && s_have_device_steps) truth = s_device_steps;
+
+        // Repeat short traces so the timing isn't all clock overhead
+        uint32_t reps = (uint32_t)((REPLAY_REPEAT_MIN + s_sample_count - 1) / s_sample_count);
+        uint32_t steps = 0, ref_steps = 0;
+        s_detector_allocs = 0;
+        s_in_detector = true;
+        uint64_t c0 = replay_cycles();
+        uint64_t t0 = replay_now_ns();
+        for (uint32_t r = 0; r < reps; r++) {
+            steps = replay_pass(&ref_steps, NULL);
+        }
+        uint64_t ns = replay_now_ns() - t0;
+        uint64_t cycles = replay_cycles() - c0;
+        s_in_detector = false;
+
+        // Once more, untimed, through the calorie engine
+        calories_t cal;
+        calories_init(&cal, &profile);
+        replay_pass(&ref_steps, &cal);
+
+        const replay_block_t *last = &s_blocks[s_block_count - 1];
+        double real_s = (last->t_ms - s_blocks[0].t_ms + (double)last->n * 1000.0 / last->odr_hz) / 1000.0;
+        uint64_t samples = (uint64_t)s_sample_count * reps;
+        double ns_per_sample = (double)ns / (double)samples;
+
+        printf("%s: %zu samples, %.1f s\n", path, s_sample_count, real_s);
+        if (truth >= 0) {
+            double err = truth ? 100.0 * ((double)steps - (double)truth) / (double)truth : 0.0;
+            printf("  steps     %u (true %ld, error %+.1f%%)%s\n", steps, truth, err,
+                   (!eq && s_have_device_steps) ? " [true = device STEP frames]" : "");
+            printf("  calories  %u (true count: %u) at %u lb, %s, %s\n",
+                   calories_get(&cal), replay_calories(&profile, (uint32_t)truth),
+                   profile.weight_lbs, s_height_names[profile.height], s_mode_names[profile.mode]);
+            if (max_error >= 0.0 && (err > max_error || err < -max_error)) failed++;
+            total.truth += truth;
+            total.steps += steps;
+        } else {
+            printf("  steps     %u (no true count)\n", steps);
+            printf("  calories  %u at %u lb, %s, %s\n", calories_get(&cal),
+                   profile.weight_lbs, s_height_names[profile.height], s_mode_names[profile.mode]);
+        }
+        if (profile.mode == CALORIES_MODE_MET) {
+            printf("  cadence   %u spm, MET %.1f at the last step\n",
+                   calories_cadence_spm(&cal), calories_met_x10(&cal) / 10.0);
+        }
+#if STEP_DETECT_AB_COMPARE
+        printf("  reference %u\n", ref_steps);
+#endif
+        printf("  cost      %.1f ns/sample", ns_per_sample);
+#if REPLAY_HAVE_TSC
+        printf(", %.1f TSC cycles/sample", (double)cycles / (double)samples);
+#else
+        (void)cycles;
+#endif
+        printf(", %.0fx real time\n", real_s * reps * 1e9 / (double)ns);
+        printf("  heap      %u calls in the detector\n", s_detector_allocs);
+
+        traces++;
+        total.samples += samples;
+        total.ns += ns;
+        total.cycles += cycles;
+        total.real_s += real_s * reps;
+        total.allocs += s_detector_allocs;
+        if (s_detector_allocs) failed++;
+    }
+
+    if (traces == 0 && failed == 0) usage();
+    if (traces > 1) {
+        printf("total: %d traces", traces);
+        if (total.truth > 0) {
+            printf(", steps %ld (true %ld, error %+.1f%%)", total.steps, total.truth,
+                   100.0 * (double)(total.steps - total.truth) / (double)total.truth);
+        }
+        printf(", %.1f ns/sample, %.0fx real time, %u heap calls\n",
+               (double)total.ns / (double)total.samples, total.real_s * 1e9 / (double)total.ns,
+               total.allocs);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+#include "i2c_bus.h"
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+// ==============================
+//  Config
+// ==============================
+
+#define I2C_BUS_MAX_RETRIES  2
+#define I2C_BUS_TIMEOUT_US   20000   // longest transaction is ~6 ms at 400 kHz
+#define I2C_BUS_PRIO_LEVELS  3
+
+// Queue level for each device (0 runs first)
+static const uint8_t s_dev_prio[I2C_DEV_COUNT] = {
+    [I2C_DEV_IMU]        = 0,
+    [I2C_DEV_FUEL_GAUGE] = 1,
+    [I2C_DEV_OLED]       = 2,
+};
+
+// ==============================
+//  Internal state
+// ==============================
+
+static bool         s_ready = false;
+static spin_lock_t *s_lock;
+static int          s_tx_chan = -1;
+static int          s_rx_chan = -1;
+
+// FIFO queue per priority level
+static i2c_txn_t   *s_head[I2C_BUS_PRIO_LEVELS];
+static i2c_txn_t   *s_tail[I2C_BUS_PRIO_LEVELS];
+
+static i2c_txn_t   *s_active = NULL;
+static bool         s_active_aborted = false;
+static uint32_t     s_active_start_us = 0;
+static bool         s_watchdog_armed = false;   // timeout alarm pending (under s_lock)
+
+// DATA_CMD entries for the active transaction (byte + READ/RESTART/STOP)
+static uint16_t     s_words[I2C_BUS_MAX_XFER];
+
+static i2c_dev_stats_t s_stats[I2C_DEV_COUNT];
+
+// ==============================
+//  Engine (called with s_lock held)
+// ==============================
+
+static void i2c_bus_start_locked(i2c_txn_t *txn)
+{
+    i2c_hw_t *hw = i2c_get_hw(I2C_BUS_PORT);
+
+    uint16_t *w = s_words;
+    if (txn->reg >= 0) *w++ = (uint8_t)txn->reg;
+    for (uint16_t i = 0; i < txn->tx_len; i++) *w++ = txn->tx[i];
+    for (uint16_t i = 0; i < txn->rx_len; i++) {
+        uint16_t cmd = I2C_IC_DATA_CMD_CMD_BITS;
+        if (i == 0 && w != s_words) cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+        *w++ = cmd;
+    }
+    w[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    s_active = txn;
+    s_active_aborted = false;
+    s_active_start_us = time_us_32();
+    txn->status = I2C_TXN_ACTIVE;
+
+    // Same target-address dance i2c_write_blocking() does; the controller
+    // is idle here because the previous transaction ended with a STOP
+    hw->enable = 0;
+    hw->tar = txn->addr;
+    hw->enable = 1;
+
+    if (txn->rx_len) {
+        dma_channel_transfer_to_buffer_now(s_rx_chan, txn->rx, txn->rx_len);
+    }
+    dma_channel_transfer_from_buffer_now(s_tx_chan, s_words, (uint32_t)(w - s_words));
+}
+
+static void i2c_bus_start_next_locked(void)
+{
+    s_active = NULL;
+    for (uint8_t p = 0; p < I2C_BUS_PRIO_LEVELS; p++) {
+        i2c_txn_t *txn = s_head[p];
+        if (txn) {
+            s_head[p] = txn->next;
+            if (!s_head[p]) s_tail[p] = NULL;
+            txn->next = NULL;
+            i2c_bus_start_locked(txn);
+            return;
+        }
+    }
+}
+
+// Wrap up the active transaction. Returns it if it finished (so the caller
+// can run its callback outside the lock), or NULL if it was retried.
+static i2c_txn_t *i2c_bus_finish_locked(bool ok)
+{
+    i2c_txn_t *txn = s_active;
+    i2c_dev_stats_t *st = &s_stats[txn->dev];
+
+    if (ok) {
+        st->txns++;
+        txn->status = I2C_TXN_DONE;
+    } else {
+        st->errors++;
+        if (txn->retries_left > 0) {
+            txn->retries_left--;
+            st->retries++;
+            i2c_bus_start_locked(txn);
+            return NULL;
+        }
+        st->failures++;
+        txn->status = I2C_TXN_ERROR;
+    }
+
+    i2c_bus_start_next_locked();
+    __sev(); // wake a waiter on the other core
+    return txn;
+}
+
+static void i2c_bus_stop_dma(void)
+{
+    dma_channel_abort(s_tx_chan);
+    dma_channel_abort(s_rx_chan);
+}
+
+static void i2c_bus_irq_handler(void)
+{
+    i2c_hw_t *hw = i2c_get_hw(I2C_BUS_PORT);
+    i2c_txn_t *done = NULL;
+
+    uint32_t save = spin_lock_blocking(s_lock);
+    uint32_t stat = hw->intr_stat;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // NACK or arbitration loss. The controller flushes its TX FIFO and
+        // still finishes with a STOP, which completes the transaction below.
+        i2c_bus_stop_dma();
+        (void)hw->clr_tx_abrt;
+        s_active_aborted = true;
+    }
+
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        if (s_active) {
+            if (!s_active_aborted) {
+                // The last byte may still be on its way out of the RX FIFO
+                while (dma_channel_is_busy(s_rx_chan)) tight_loop_contents();
+            }
+            done = i2c_bus_finish_locked(!s_active_aborted);
+        }
+    }
+
+    spin_unlock(s_lock, save);
+
+    if (done && done->done) done->done(done, done->ctx);
+}
+
+// Give up on a transaction that has been on the bus far too long
+// (e.g. a device holding SCL low)
+static void i2c_bus_check_timeout(void)
+{
+    i2c_txn_t *done = NULL;
+
+    uint32_t save = spin_lock_blocking(s_lock);
+    if (s_active && (time_us_32() - s_active_start_us) > I2C_BUS_TIMEOUT_US) {
+        i2c_bus_stop_dma();
+        i2c_get_hw(I2C_BUS_PORT)->enable = 0;  // re-enabled by the next start
+        s_active->retries_left = 0;
+        done = i2c_bus_finish_locked(false);
+    }
+    spin_unlock(s_lock, save);
+
+    if (done && done->done) done->done(done, done->ctx);
+}
+
+// While anything is on the bus, one alarm enforces the timeout, so async
+// transactions (nobody in i2c_bus_wait()) fail too instead of staying busy
+// forever. It reschedules itself for the active transaction's deadline and
+// lapses once the bus is idle.
+static int64_t i2c_bus_watchdog_cb(alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    i2c_bus_check_timeout();
+
+    int64_t again_us = 0;
+    uint32_t save = spin_lock_blocking(s_lock);
+    if (s_active) {
+        uint32_t elapsed = time_us_32() - s_active_start_us;
+        again_us = elapsed < I2C_BUS_TIMEOUT_US ? (int64_t)(I2C_BUS_TIMEOUT_US - elapsed) + 1 : 1;
+    } else {
+        s_watchdog_armed = false;
+    }
+    spin_unlock(s_lock, save);
+    return again_us;
+}
+
+// ==============================
+//  Public API
+// ==============================
+
+void i2c_bus_init(void)
+{
+    if (s_ready) return;
+
+    s_lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    i2c_init(I2C_BUS_PORT, I2C_BUS_BAUD_HZ);
+    gpio_set_function(I2C_BUS_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_BUS_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(I2C_BUS_SDA_PIN);
+    gpio_pull_up(I2C_BUS_SCL_PIN);
+
+    i2c_hw_t *hw = i2c_get_hw(I2C_BUS_PORT);
+
+    // TX: 16-bit DATA_CMD entries, paced by the TX FIFO
+    s_tx_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(s_tx_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(I2C_BUS_PORT, true));
+    dma_channel_configure(s_tx_chan, &c, &hw->data_cmd, s_words, 0, false);
+
+    // RX: received bytes out of DATA_CMD, paced by the RX FIFO
+    s_rx_chan = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(s_rx_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(I2C_BUS_PORT, false));
+    dma_channel_configure(s_rx_chan, &c, NULL, &hw->data_cmd, 0, false);
+
+    // Every transaction ends in a STOP; aborts are noted on the way
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    irq_set_exclusive_handler(I2C1_IRQ, i2c_bus_irq_handler);
+    irq_set_enabled(I2C1_IRQ, true);
+
+    s_ready = true;
+}
+
+bool i2c_bus_submit(i2c_txn_t *txn)
+{
+    size_t len = (txn->reg >= 0 ? 1u : 0u) + txn->tx_len + txn->rx_len;
+    if (!s_ready || len == 0 || len > I2C_BUS_MAX_XFER || txn->dev >= I2C_DEV_COUNT) {
+        return false;
+    }
+    if (i2c_bus_txn_busy(txn)) return false;
+
+    txn->next = NULL;
+    txn->retries_left = I2C_BUS_MAX_RETRIES;
+    txn->status = I2C_TXN_QUEUED;
+
+    uint8_t p = s_dev_prio[txn->dev];
+    uint32_t save = spin_lock_blocking(s_lock);
+    if (s_tail[p]) s_tail[p]->next = txn;
+    else           s_head[p] = txn;
+    s_tail[p] = txn;
+    if (!s_active) i2c_bus_start_next_locked();
+    bool arm = !s_watchdog_armed;
+    s_watchdog_armed = true;
+    spin_unlock(s_lock, save);
+
+    if (arm && add_alarm_in_us(I2C_BUS_TIMEOUT_US + 1, i2c_bus_watchdog_cb, NULL, true) <= 0) {
+        // No alarm slot: the next submit tries again
+        save = spin_lock_blocking(s_lock);
+        s_watchdog_armed = false;
+        spin_unlock(s_lock, save);
+    }
+    return true;
+}
+
+bool i2c_bus_txn_busy(const i2c_txn_t *txn)
+{
+    return txn->status == I2C_TXN_QUEUED || txn->status == I2C_TXN_ACTIVE;
+}
+
+void i2c_bus_wait(i2c_txn_t *txn)
+{
+    while (i2c_bus_txn_busy(txn)) {
+        // Completion SEVs. The watchdog alarm enforces the timeout; checking
+        // here as well covers a wait with interrupts masked.
+        best_effort_wfe_or_timeout(make_timeout_time_us(500));
+        i2c_bus_check_timeout();
+    }
+}
+
+int i2c_bus_xfer(i2c_dev_t dev, uint8_t addr, int16_t reg,
+                 const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len)
+{
+    i2c_txn_t txn = {
+        .dev = dev,
+        .addr = addr,
+        .reg = reg,
+        .tx = tx,
+        .tx_len = (uint16_t)tx_len,
+        .rx = rx,
+        .rx_len = (uint16_t)rx_len,
+        .status = I2C_TXN_IDLE,
+    };
+    if (!i2c_bus_submit(&txn)) return -1;
+    i2c_bus_wait(&txn);
+    return (txn.status == I2C_TXN_DONE) ? 0 : -1;
+}
+
+void i2c_bus_get_stats(i2c_dev_t dev, i2c_dev_stats_t *out)
+{
+    if (dev >= I2C_DEV_COUNT || !out) return;
+    uint32_t save = spin_lock_blocking(s_lock);
+    *out = s_stats[dev];
+    spin_unlock(s_lock, save);
+}
+
+void i2c_bus_clock_changed(void)
+{
+    i2c_set_baudrate(I2C_BUS_PORT, I2C_BUS_BAUD_HZ);
+}
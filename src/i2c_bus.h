@@ -0,0 +1,103 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+// ==============================
+//  Shared I2C bus manager (i2c1)
+// ==============================
+//
+// The OLED, LSM6DS3 and MAX17048 all sit on i2c1, driven from both cores.
+// This module is the only code that touches the controller: drivers submit
+// transactions, which are queued by device priority (IMU first, then the
+// fuel gauge, then the display) and run back-to-back by DMA. Completion is
+// signalled from the I2C interrupt, so a large framebuffer push is just a
+// series of low-priority chunks that an IMU read can overtake. A timer
+// alarm gives up on a transaction that is still on the bus after 20 ms
+// (ERROR), whether or not anyone is waiting on it.
+//
+
+#define I2C_BUS_PORT     i2c1
+#define I2C_BUS_SDA_PIN  14
+#define I2C_BUS_SCL_PIN  15
+#define I2C_BUS_BAUD_HZ  (400 * 1000)
+
+// Largest transaction: 1 (reg) + tx_len + rx_len bytes on the wire
+#define I2C_BUS_MAX_XFER     256
+
+typedef enum {
+    I2C_DEV_IMU,          // highest priority
+    I2C_DEV_FUEL_GAUGE,
+    I2C_DEV_OLED,         // lowest priority
+    I2C_DEV_COUNT
+} i2c_dev_t;
+
+typedef enum {
+    I2C_TXN_IDLE,
+    I2C_TXN_QUEUED,
+    I2C_TXN_ACTIVE,
+    I2C_TXN_DONE,
+    I2C_TXN_ERROR,
+} i2c_txn_status_t;
+
+typedef struct i2c_txn i2c_txn_t;
+
+// Completion callback, called from interrupt context once the transaction
+// is DONE or ERROR. It may submit new transactions.
+typedef void (*i2c_txn_cb_t)(i2c_txn_t *txn, void *ctx);
+
+// One bus transaction: write [reg] + tx, then (with a repeated START) read
+// rx_len bytes. reg is a register address or control byte, -1 for none.
+// Buffers must stay valid until the transaction completes.
+struct i2c_txn {
+    i2c_dev_t       dev;
+    uint8_t         addr;
+    int16_t         reg;
+    const uint8_t  *tx;
+    uint16_t        tx_len;
+    uint8_t        *rx;
+    uint16_t        rx_len;
+    i2c_txn_cb_t    done;
+    void           *ctx;
+
+    // Owned by the bus manager
+    volatile i2c_txn_status_t status;
+    uint8_t         retries_left;
+    i2c_txn_t      *next;
+};
+
+typedef struct {
+    uint32_t txns;       // transactions completed successfully
+    uint32_t errors;     // aborted attempts (NACK, arbitration loss, timeout)
+    uint32_t retries;    // attempts repeated after an error
+    uint32_t failures;   // transactions given up on
+} i2c_dev_stats_t;
+
+// Configure i2c1, its pins, DMA channels and interrupt. Call once from
+// core 0 before either core submits anything.
+void i2c_bus_init(void);
+
+// Queue a transaction. Returns false if it's malformed or still in flight.
+bool i2c_bus_submit(i2c_txn_t *txn);
+
+// True while the transaction is queued or on the bus
+bool i2c_bus_txn_busy(const i2c_txn_t *txn);
+
+// Sleep until the transaction has completed (or failed)
+void i2c_bus_wait(i2c_txn_t *txn);
+
+// Blocking helper: submit and wait. Returns 0 on success, -1 on failure.
+int i2c_bus_xfer(i2c_dev_t dev, uint8_t addr, int16_t reg,
+                 const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len);
+
+// Snapshot of a device's counters
+void i2c_bus_get_stats(i2c_dev_t dev, i2c_dev_stats_t *out);
+
+// Recompute the SCL timing after clk_sys changed (power.c). Only with
+// nothing in flight.
+void i2c_bus_clock_changed(void);
+
+#endif // I2C_BUS_H
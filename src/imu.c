@@ -1,20 +1,22 @@
 #include "imu.h"
 
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
-#include <math.h>
+#include "config.h"
+#include "flash_log.h"
+#include "i2c_bus.h"
+#include "history.h"
+#include "log.h"
+#include "step_detect.h"
+#include "telemetry.h"
 #include <string.h>
-#include <stdio.h>
 
 // ==============================
 //  Hardware / wiring config (I2C)
 // ==============================
 //
-// Uses the same I2C bus as the OLED/MAX17048 (i2c1 on GPIO10/11).
+// Uses the same I2C bus as the OLED/MAX17048. All transfers go through the
+// bus manager (see i2c_bus.h), where IMU reads have the highest priority.
 //
-#define IMU_I2C_PORT           i2c1
-#define IMU_PIN_SDA            14
-#define IMU_PIN_SCL            15
 #define LSM6DS3_ADDR_SA0_LOW   0x6A  // 7-bit I2C address when SDO/SA0 pulled low
 #define LSM6DS3_ADDR_SA0_HIGH  0x6B  // 7-bit I2C address when SDO/SA0 pulled high
 
@@ -23,11 +25,20 @@
 // ==============================
 
 #define LSM6DS3_REG_FUNC_CFG_ACCESS  0x01
+#define LSM6DS3_REG_FIFO_CTRL1       0x06
+#define LSM6DS3_REG_FIFO_CTRL2       0x07
+#define LSM6DS3_REG_FIFO_CTRL3       0x08
+#define LSM6DS3_REG_FIFO_CTRL4       0x09
+#define LSM6DS3_REG_FIFO_CTRL5       0x0A
+#define LSM6DS3_REG_INT1_CTRL        0x0D
 #define LSM6DS3_REG_WHO_AM_I         0x0F
 #define LSM6DS3_REG_CTRL1_XL         0x10
 #define LSM6DS3_REG_CTRL2_G          0x11
 #define LSM6DS3_REG_CTRL3_C          0x12
+#define LSM6DS3_REG_CTRL6_C          0x15
 #define LSM6DS3_REG_CTRL8_XL         0x17
+#define LSM6DS3_REG_CTRL10_C         0x19
+#define LSM6DS3_REG_WAKE_UP_SRC      0x1B
 #define LSM6DS3_REG_STATUS_REG       0x1E
 
 #define LSM6DS3_REG_OUTX_L_G         0x22
@@ -44,22 +55,143 @@
 #define LSM6DS3_REG_OUTZ_L_XL        0x2C
 #define LSM6DS3_REG_OUTZ_H_XL        0x2D
 
+#define LSM6DS3_REG_FIFO_STATUS1     0x3A
+#define LSM6DS3_REG_FIFO_STATUS2     0x3B
+#define LSM6DS3_REG_FIFO_STATUS3     0x3C
+#define LSM6DS3_REG_FIFO_STATUS4     0x3D
+#define LSM6DS3_REG_FIFO_DATA_OUT_L  0x3E
+#define LSM6DS3_REG_FIFO_DATA_OUT_H  0x3F
+#define LSM6DS3_REG_STEP_COUNTER_L   0x4B
+#define LSM6DS3_REG_STEP_COUNTER_H   0x4C
+#define LSM6DS3_REG_FUNC_SRC1        0x53
+#define LSM6DS3_REG_TAP_CFG          0x58
+#define LSM6DS3_REG_WAKE_UP_THS      0x5B
+#define LSM6DS3_REG_WAKE_UP_DUR      0x5C
+#define LSM6DS3_REG_MD1_CFG          0x5E
+
 #define LSM6DS3_WHO_AM_I_VALUE       0x6A
+#define IMU_BOOT_TIMEOUT_MS          20     // datasheet turn-on time is 15 ms
+
+// INT1_CTRL fields
+#define LSM6DS3_INT1_DRDY_XL         (1u << 0)
+#define LSM6DS3_INT1_FTH             (1u << 3)
+
+// CTRL10_C fields (embedded functions)
+#define LSM6DS3_CTRL10_FUNC_EN       (1u << 2)
+#define LSM6DS3_CTRL10_PEDO_EN       (1u << 4)
+
+// CTRL1_XL ODR_XL field (FS_XL = ±2g)
+#define LSM6DS3_XL_ODR_26HZ          (0x2u << 4)
+#define LSM6DS3_XL_ODR_104HZ         (0x4u << 4)
+
+// CTRL6_C fields
+#define LSM6DS3_CTRL6_XL_HM_MODE     (1u << 4)   // 1 = accel high-performance off
+
+// Wake-up engine: TAP_CFG / MD1_CFG / WAKE_UP_SRC fields
+#define LSM6DS3_TAP_CFG_INT_EN       (1u << 7)
+#define LSM6DS3_TAP_CFG_LIR          (1u << 0)   // latch until WAKE_UP_SRC is read
+#define LSM6DS3_MD1_INT1_WU          (1u << 5)
+#define LSM6DS3_WAKE_UP_SRC_WU_IA    (1u << 3)
+
+// FIFO_CTRL5 fields
+#define LSM6DS3_FIFO_MODE_BYPASS     0x00
+#define LSM6DS3_FIFO_MODE_CONTINUOUS 0x06
+#define LSM6DS3_FIFO_ODR_26HZ        (0x2u << 3)
+#define LSM6DS3_FIFO_ODR_104HZ       (0x4u << 3)
+
+// FIFO_STATUS2 flags
+#define LSM6DS3_FIFO_STATUS2_OVER_RUN (1u << 6)
+#define LSM6DS3_FIFO_STATUS2_EMPTY    (1u << 4)
+
+// ==============================
+//  FIFO ingestion config
+// ==============================
+//
+// The accelerometer is the only data set stored in the FIFO, so the
+// pattern is always X, Y, Z (three 16-bit words per sample).
+
+#ifndef IMU_USE_FIFO
+#define IMU_USE_FIFO                 1
+#endif
+#define IMU_FIFO_WORDS_PER_SAMPLE    3
+#define IMU_FIFO_BURST_SAMPLES       32   // samples pulled per I2C burst read
+
+// ==============================
+//  Sensor power modes
+// ==============================
+//
+// The gyro is never used and stays powered down. The accelerometer runs at
+// 104 Hz high-performance while there's movement, and drops to 26 Hz
+// low-power after a stretch without steps (a short one when the last hour
+// was idle too). The wake-up engine raises INT1 on movement and brings it
+// straight back to full rate.
+
+// The normal idle time is CONFIG_IDLE_TO_LOW_S
+#define IMU_IDLE_TO_LOW_QUIET_MS     10000   // when imu_get_activity_level() == 0
+#define IMU_WAKE_THS                 3       // wake-up slope threshold, FS/64 = 31 mg/LSB
+
+typedef struct {
+    uint8_t  ctrl1_xl;
+    uint8_t  ctrl6_c;
+    uint8_t  fifo_odr;
+    uint16_t odr_hz;
+    uint32_t period_us;
+    uint16_t watermark;          // FIFO watermark, samples
+} imu_power_cfg_t;
+
+static const imu_power_cfg_t s_power_cfg[IMU_POWER_MODE_COUNT] = {
+    [IMU_POWER_ACTIVE] = {
+        .ctrl1_xl = LSM6DS3_XL_ODR_104HZ, .ctrl6_c = 0,
+        .fifo_odr = LSM6DS3_FIFO_ODR_104HZ,
+        .odr_hz = 104, .period_us = 1000000u / 104,
+        .watermark = 16,         // ~150 ms of data
+    },
+    [IMU_POWER_LOW] = {
+        .ctrl1_xl = LSM6DS3_XL_ODR_26HZ, .ctrl6_c = LSM6DS3_CTRL6_XL_HM_MODE,
+        .fifo_odr = LSM6DS3_FIFO_ODR_26HZ,
+        .odr_hz = 26, .period_us = 1000000u / 26,
+        .watermark = 64,         // ~2.5 s of data
+    },
+};
 
 // ==============================
 //  Step detection / history config
 // ==============================
 //
-// Assumption: imu_update() is called at a fairly fixed rate (~50-100 Hz).
+// With IMU_USE_FIFO every sample is fed through the detector at the full
+// ODR; imu_update() only has to be called often enough to keep the FIFO
+// from overflowing. Without it, imu_update() reads one sample per call and
+// should be called at a fairly fixed rate (~50-100 Hz).
+
+// The detectors themselves live in step_detect.c (step_detect.h has the
+// build-time selection, STEP_DETECTOR and STEP_DETECT_AB_COMPARE)
+#define IMU_ACCEL_LSB_2G             STEP_DETECT_LSB_G
+#define IMU_BLOCK_MAX_SAMPLES        STEP_DETECT_MAX_BLOCK   // per detector pass, one telemetry frame
 
-#define IMU_ACCEL_LSB_2G             (0.000061f)  // 0.061 mg/LSB = 0.000061 g/LSB
-#define IMU_STEP_THRESHOLD_G         0.35f        // high-pass magnitude threshold in g
-#define IMU_STEP_MIN_INTERVAL_MS     350          // ignore steps closer than this in time
-#define IMU_HISTORY_MINUTES          60
-#define IMU_STEP_GOAL_PER_HOUR       250
+_Static_assert(IMU_BLOCK_MAX_SAMPLES <= TELEMETRY_ACCEL_MAX_SAMPLES, "detector block must fit one ACCEL frame");
 
-// Simple low-pass filter tracking the 1g baseline (used to get a high-pass signal)
-#define IMU_MAG_LP_ALPHA             0.01f        // 0 < alpha <= 1
+// Step events waiting for imu_read_step_events(); power of two. A full
+// low-power FIFO (2.5 s) holds at most ~10 steps.
+#define IMU_STEP_EVENTS              32u
+
+// ==============================
+//  Hardware pedometer config
+// ==============================
+//
+// In hardware mode the sensor's embedded pedometer counts steps and the
+// MCU only reads STEP_COUNTER every IMU_PEDO_POLL_MS; the FIFO is off. Every
+// IMU_PEDO_CHECK_PERIOD_MS the software detector runs alongside for
+// IMU_PEDO_CHECK_WINDOW_MS as a cross-check, and repeated disagreement
+// falls back to software counting for good.
+
+#ifndef IMU_DEFAULT_STEP_SOURCE
+#define IMU_DEFAULT_STEP_SOURCE      IMU_STEP_SOURCE_SOFTWARE
+#endif
+#define IMU_PEDO_POLL_MS             1000
+#define IMU_PEDO_CHECK_PERIOD_MS     (5u * 60u * 1000u)
+#define IMU_PEDO_CHECK_WINDOW_MS     20000
+#define IMU_PEDO_CHECK_MIN_STEPS     8    // quieter windows prove nothing
+#define IMU_PEDO_CHECK_MAX_FAILS     3    // consecutive disagreements before falling back
 
 // ==============================
 //  Internal state
@@ -73,64 +205,61 @@ static int16_t  s_raw_ax               = 0;
 static int16_t  s_raw_ay               = 0;
 static int16_t  s_raw_az               = 0;
 
-// Last converted accel sample in g (no extra filtering for now)
-static float    s_filt_ax              = 0.0f;
-static float    s_filt_ay              = 0.0f;
-static float    s_filt_az              = 0.0f;
-
-// Magnitude baseline / high-pass
-static bool     s_mag_lp_initialized   = false;
-static float    s_mag_lp               = 0.0f;   // low-pass of |a|
-static float    s_mag_hp               = 0.0f;   // high-pass: |a| - low-pass
+static step_detector_t s_det;
 
 // Step counters
 static uint32_t s_total_steps          = 0;
-static uint32_t s_last_step_ms         = 0;
 
-// Per-minute history for the last hour
-static uint16_t s_steps_per_min[IMU_HISTORY_MINUTES];
-static uint8_t  s_curr_min_idx         = 0;
-static uint32_t s_curr_bucket_start_ms = 0;
-static uint32_t s_steps_last_hour_sum  = 0;
+// Step event stream (core 0 only: produced and consumed in the main loop)
+static step_event_t s_step_events[IMU_STEP_EVENTS];
+static uint32_t s_step_ev_head         = 0;
+static uint32_t s_step_ev_tail         = 0;
+
+// FIFO bookkeeping
+static uint32_t s_last_sample_ms       = 0;
+static uint32_t s_fifo_overruns        = 0;
+
+// Power mode
+static imu_power_mode_t       s_power_mode = IMU_POWER_ACTIVE;
+static const imu_power_cfg_t *s_pcfg       = &s_power_cfg[IMU_POWER_ACTIVE];
+static uint32_t s_last_activity_ms     = 0;   // last step or wake-up
+static uint32_t s_low_since_ms         = 0;   // when low-power mode was entered
+
+// Hardware pedometer bookkeeping
+static imu_step_source_t s_step_source = IMU_STEP_SOURCE_SOFTWARE;
+static uint16_t s_pedo_last_count      = 0;   // STEP_COUNTER at the last poll
+static uint32_t s_pedo_last_poll_ms    = 0;
+
+// Cross-check window (hardware mode only)
+static bool     s_check_active         = false;
+static uint32_t s_check_start_ms       = 0;   // also when the next window is due
+static uint32_t s_check_hw_base        = 0;   // s_total_steps when the window opened
+static uint32_t s_check_sw_steps       = 0;   // counted by the software detector
+static uint8_t  s_check_fails          = 0;
 
 // ==============================
 //  I2C helpers
 // ==============================
 
-static void imu_i2c_init_pins(void)
-{
-    static bool init_done = false;
-    if (init_done) return;
-    i2c_init(IMU_I2C_PORT, 400 * 1000); // 400 kHz
-    gpio_set_function(IMU_PIN_SDA, GPIO_FUNC_I2C);
-    gpio_set_function(IMU_PIN_SCL, GPIO_FUNC_I2C);
-    gpio_pull_up(IMU_PIN_SDA);
-    gpio_pull_up(IMU_PIN_SCL);
-    init_done = true;
-}
-
 // Write a single register over I2C
 static void imu_write_reg(uint8_t reg, uint8_t value)
 {
-    uint8_t tx[2] = {reg, value};
-    i2c_write_blocking(IMU_I2C_PORT, s_i2c_addr, tx, 2, false);
+    i2c_bus_xfer(I2C_DEV_IMU, s_i2c_addr, reg, &value, 1, NULL, 0);
 }
 
 // Read a single register over I2C
 static uint8_t imu_read_reg(uint8_t reg)
 {
     uint8_t rx = 0;
-    i2c_write_blocking(IMU_I2C_PORT, s_i2c_addr, &reg, 1, true);
-    i2c_read_blocking(IMU_I2C_PORT, s_i2c_addr, &rx, 1, false);
+    i2c_bus_xfer(I2C_DEV_IMU, s_i2c_addr, reg, NULL, 0, &rx, 1);
     return rx;
 }
 
-// Read multiple consecutive registers (auto-increment)
-static void imu_read_regs(uint8_t start_reg, uint8_t *buf, size_t len)
+// Read multiple consecutive registers (auto-increment).
+// Returns false if the transfer failed.
+static bool imu_read_regs(uint8_t start_reg, uint8_t *buf, size_t len)
 {
-    uint8_t reg = start_reg;
-    i2c_write_blocking(IMU_I2C_PORT, s_i2c_addr, &reg, 1, true);
-    i2c_read_blocking(IMU_I2C_PORT, s_i2c_addr, buf, len, false);
+    return i2c_bus_xfer(I2C_DEV_IMU, s_i2c_addr, start_reg, NULL, 0, buf, len) == 0;
 }
 
 // Grab a 3-axis accelerometer sample (raw LSB units)
@@ -148,36 +277,72 @@ static void imu_read_accel_raw_internal(int16_t *ax, int16_t *ay, int16_t *az)
     if (az) *az = z;
 }
 
+// Configure the FIFO to hold accelerometer samples only, in continuous mode.
+// Switching through bypass mode first flushes anything left over.
+static void imu_fifo_init(void)
+{
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+
+    // Watermark threshold is expressed in 16-bit words (FTH[10:0])
+    uint16_t fth = s_pcfg->watermark * IMU_FIFO_WORDS_PER_SAMPLE;
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL1, (uint8_t)(fth & 0xFF));
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL2, (uint8_t)((fth >> 8) & 0x07));
+
+    // FIFO_CTRL3: DEC_FIFO_XL = 001 (accel, no decimation), gyro not stored
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL3, 0x01);
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL4, 0x00);
+
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL5,
+                  s_pcfg->fifo_odr | LSM6DS3_FIFO_MODE_CONTINUOUS);
+}
+
+// Read FIFO_STATUS1..4 in one burst.
+// Returns the number of unread 16-bit words; *pattern receives the index of
+// the next word within the X/Y/Z pattern, *status2 the raw flags register.
+static uint16_t imu_fifo_status(uint16_t *pattern, uint8_t *status2)
+{
+    uint8_t st[4];
+    imu_read_regs(LSM6DS3_REG_FIFO_STATUS1, st, 4);
+    if (pattern) *pattern = (uint16_t)(((st[3] & 0x03) << 8) | st[2]);
+    if (status2) *status2 = st[1];
+    return (uint16_t)(((st[1] & 0x07) << 8) | st[0]);
+}
+
+// Start feeding samples to the software detector: the FIFO (continuous
+// mode) with INT1 on its watermark, or INT1 on each new sample without it
+static void imu_sw_stream_start(void)
+{
+#if IMU_USE_FIFO
+    imu_fifo_init();
+    // INT1 (push-pull, active high) follows the FIFO watermark flag
+    imu_write_reg(LSM6DS3_REG_INT1_CTRL, LSM6DS3_INT1_FTH);
+#else
+    // INT1 pulses on each new accelerometer sample
+    imu_write_reg(LSM6DS3_REG_INT1_CTRL, LSM6DS3_INT1_DRDY_XL);
+#endif
+}
+
+// Stop the sample stream (FIFO to bypass, INT1 quiet)
+static void imu_sw_stream_stop(void)
+{
+    imu_write_reg(LSM6DS3_REG_INT1_CTRL, 0x00);
+    imu_write_reg(LSM6DS3_REG_FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS);
+}
+
 // ==============================
 //  Time bucket / history helpers
 // ==============================
 
-static void imu_history_reset(uint32_t now_ms)
+// Step history lives in history.c, in seconds on the log clock, so that
+// boot can rebuild it from the flash log's records
+static inline uint32_t imu_history_time_s(uint32_t ms)
 {
-    memset(s_steps_per_min, 0, sizeof(s_steps_per_min));
-    s_curr_min_idx         = 0;
-    s_curr_bucket_start_ms = now_ms;
-    s_steps_last_hour_sum  = 0;
+    return flash_log_time_s(ms);
 }
 
-// Advance the "current minute" bucket based on now_ms
 static void imu_history_advance_buckets(uint32_t now_ms)
 {
-    if (s_curr_bucket_start_ms == 0) {
-        // First time we get called: initialise starting point
-        imu_history_reset(now_ms);
-        return;
-    }
-
-    // Move forward in 60-second chunks until the buckets are up to date
-    while ((now_ms - s_curr_bucket_start_ms) >= 60000u) {
-        s_curr_bucket_start_ms += 60000u;
-        s_curr_min_idx = (uint8_t)((s_curr_min_idx + 1) % IMU_HISTORY_MINUTES);
-
-        // Drop the oldest bucket from the running sum and clear it
-        s_steps_last_hour_sum -= s_steps_per_min[s_curr_min_idx];
-        s_steps_per_min[s_curr_min_idx] = 0;
-    }
+    history_advance(imu_history_time_s(now_ms));
 }
 
 // ==============================
@@ -186,23 +351,24 @@ static void imu_history_advance_buckets(uint32_t now_ms)
 
 bool imu_init(void)
 {
-    imu_i2c_init_pins();
-
-    // Give the sensor some time to power up
-    sleep_ms(20);
-
-    // Try default address, then alternate if needed
-    s_i2c_addr = LSM6DS3_ADDR_SA0_LOW;
-    // Confirm we're talking to the correct device
-    uint8_t whoami = imu_read_reg(LSM6DS3_REG_WHO_AM_I);
-    if (whoami != LSM6DS3_WHO_AM_I_VALUE) {
-        s_i2c_addr = LSM6DS3_ADDR_SA0_HIGH;
+    i2c_bus_init();
+
+    // Poll WHO_AM_I at both addresses until the sensor has booted (up to
+    // IMU_BOOT_TIMEOUT_MS after power-up; straight away on a warm reset)
+    absolute_time_t deadline = make_timeout_time_ms(IMU_BOOT_TIMEOUT_MS);
+    uint8_t whoami;
+    do {
+        s_i2c_addr = LSM6DS3_ADDR_SA0_LOW;
         whoami = imu_read_reg(LSM6DS3_REG_WHO_AM_I);
-    }
+        if (whoami != LSM6DS3_WHO_AM_I_VALUE) {
+            s_i2c_addr = LSM6DS3_ADDR_SA0_HIGH;
+            whoami = imu_read_reg(LSM6DS3_REG_WHO_AM_I);
+        }
+    } while (whoami != LSM6DS3_WHO_AM_I_VALUE && !time_reached(deadline));
 
-    printf("IMU WHO_AM_I=0x%02X @0x%02X (expect 0x6A)\n", whoami, s_i2c_addr);
+    LOG_I("IMU WHO_AM_I=0x%02X @0x%02X (expect 0x6A)", whoami, s_i2c_addr);
     if (whoami != LSM6DS3_WHO_AM_I_VALUE) {
-        printf("IMU WHO_AM_I mismatch: 0x%02X (expected 0x6A)\n", whoami);
+        LOG_E("IMU WHO_AM_I mismatch: 0x%02X (expected 0x6A)", whoami);
         s_initialized = false;
         return false;
     }
@@ -215,78 +381,405 @@ bool imu_init(void)
 
     // CTRL1_XL: accelerometer configuration
     // ODR_XL = 104 Hz (0b0100 << 4 = 0x40), FS_XL = ±2g (00)
-    imu_write_reg(LSM6DS3_REG_CTRL1_XL, 0x40);
+    s_power_mode = IMU_POWER_ACTIVE;
+    s_pcfg = &s_power_cfg[IMU_POWER_ACTIVE];
+    imu_write_reg(LSM6DS3_REG_CTRL6_C, s_pcfg->ctrl6_c);
+    imu_write_reg(LSM6DS3_REG_CTRL1_XL, s_pcfg->ctrl1_xl);
 
-    // CTRL2_G: gyroscope configuration
-    // ODR_G = 104 Hz, FS_G = ±245 dps
-    imu_write_reg(LSM6DS3_REG_CTRL2_G, 0x40);
+    // CTRL2_G: gyroscope powered down (ODR_G = 0), nothing reads it
+    imu_write_reg(LSM6DS3_REG_CTRL2_G, 0x00);
+
+    // Wake-up engine (slope filter), routed to INT1 only in low-power mode
+    imu_write_reg(LSM6DS3_REG_WAKE_UP_THS, IMU_WAKE_THS);
+    imu_write_reg(LSM6DS3_REG_WAKE_UP_DUR, 0x00);
+    imu_write_reg(LSM6DS3_REG_TAP_CFG, LSM6DS3_TAP_CFG_INT_EN | LSM6DS3_TAP_CFG_LIR);
+    imu_write_reg(LSM6DS3_REG_MD1_CFG, 0x00);
 
     // Reset runtime state
     s_raw_ax = s_raw_ay = s_raw_az = 0;
-    s_filt_ax = s_filt_ay = s_filt_az = 0.0f;
-    s_mag_lp_initialized = false;
-    s_mag_lp = 0.0f;
-    s_mag_hp = 0.0f;
+    step_detect_init(&s_det, s_pcfg->odr_hz);
     s_total_steps = 0;
-    s_last_step_ms = 0;
-    imu_history_reset(0); // will be re-aligned on the first update() call
+    s_last_activity_ms = to_ms_since_boot(get_absolute_time());
+    history_init(imu_history_time_s(to_ms_since_boot(get_absolute_time())));
+    s_last_sample_ms = 0;
+    s_fifo_overruns = 0;
 
     s_initialized = true;
+
+    s_step_source = IMU_STEP_SOURCE_SOFTWARE;
+    imu_sw_stream_start();
+    if (IMU_DEFAULT_STEP_SOURCE == IMU_STEP_SOURCE_HARDWARE) {
+        imu_set_step_source(IMU_STEP_SOURCE_HARDWARE);
+    }
     return true;
 }
 
-void imu_update(uint32_t now_ms)
+// Queue a step event. When the reader has fallen behind, the newest entry
+// absorbs the steps instead, so counts are never lost, only timing detail.
+static void imu_push_step_event(const step_event_t *e)
 {
-    if (!s_initialized) {
+    if (s_step_ev_head - s_step_ev_tail < IMU_STEP_EVENTS) {
+        s_step_events[s_step_ev_head++ % IMU_STEP_EVENTS] = *e;
+        return;
+    }
+    step_event_t *last = &s_step_events[(s_step_ev_head - 1u) % IMU_STEP_EVENTS];
+    uint32_t count = (uint32_t)last->count + e->count;
+    last->count = count > UINT16_MAX ? UINT16_MAX : (uint16_t)count;
+    last->t_ms = e->t_ms;
+    if (e->peak_mg) last->peak_mg = e->peak_mg;
+}
+
+// Add steps into the totals, the minute bucket for their time and the
+// event stream
+static void imu_add_steps(const step_event_t *e)
+{
+    uint32_t steps = e->count;
+    uint32_t at_ms = e->t_ms;
+    s_total_steps += steps;
+    s_last_activity_ms = at_ms;
+    imu_push_step_event(e);
+
+    // Count steps into their minute/hour/day buckets
+    history_add_steps(steps, imu_history_time_s(at_ms));
+    telemetry_send_step(at_ms, s_total_steps, steps > UINT8_MAX ? UINT8_MAX : (uint8_t)steps);
+}
+
+// Count one step found by the software detector. While the hardware
+// pedometer is the step source it only feeds the cross-check.
+static void imu_count_step(const step_event_t *e)
+{
+    if (s_step_source == IMU_STEP_SOURCE_HARDWARE) {
+        s_check_sw_steps += e->count;
+        return;
+    }
+    imu_add_steps(e);
+}
+
+void imu_process_block(const int16_t *xyz, size_t n, uint32_t t0_ms)
+{
+    while (n > 0) {
+        size_t chunk = (n > IMU_BLOCK_MAX_SAMPLES) ? IMU_BLOCK_MAX_SAMPLES : n;
+        step_event_t steps[IMU_BLOCK_MAX_SAMPLES];
+
+        // Raw samples at full ODR for logging/training data
+        telemetry_send_accel(t0_ms, s_pcfg->odr_hz, xyz, chunk);
+
+        size_t found = step_detect_block(&s_det, xyz, chunk, t0_ms, steps);
+        for (size_t i = 0; i < found; i++) {
+            imu_count_step(&steps[i]);
+        }
+
+        // Keep the history buckets current even when nobody is walking
+        imu_history_advance_buckets(t0_ms + (uint32_t)(((chunk - 1) * s_pcfg->period_us) / 1000u));
+
+        // Keep the newest raw reading (LSB)
+        s_raw_ax = xyz[3 * (chunk - 1) + 0];
+        s_raw_ay = xyz[3 * (chunk - 1) + 1];
+        s_raw_az = xyz[3 * (chunk - 1) + 2];
+        s_last_sample_ms = t0_ms + (uint32_t)(((chunk - 1) * s_pcfg->period_us) / 1000u);
+
+        xyz += 3 * chunk;
+        n -= chunk;
+        t0_ms += (uint32_t)((chunk * s_pcfg->period_us) / 1000u);
+    }
+}
+
+// Drain everything currently stored in the FIFO. Samples are read in bursts
+// of up to IMU_FIFO_BURST_SAMPLES and timestamped backwards from now_ms at
+// the ODR period (the newest sample is taken to be "now").
+static void imu_fifo_drain(uint32_t now_ms)
+{
+    uint16_t pattern = 0;
+    uint8_t status2 = 0;
+    uint16_t words = imu_fifo_status(&pattern, &status2);
+
+    if (status2 & LSM6DS3_FIFO_STATUS2_OVER_RUN) {
+        // Oldest data was overwritten; what's left is still contiguous
+        s_fifo_overruns++;
+        LOG_W("IMU FIFO overrun #%lu", s_fifo_overruns);
+    }
+    if (words == 0 || (status2 & LSM6DS3_FIFO_STATUS2_EMPTY)) {
         return;
     }
 
-    // 1) Update the per-minute buckets according to the current time
-    imu_history_advance_buckets(now_ms);
+    // Re-align to an X word if the pattern pointer is mid-sample
+    // (can happen right after an overrun)
+    int16_t xyz[IMU_FIFO_BURST_SAMPLES * IMU_FIFO_WORDS_PER_SAMPLE];
+    if (pattern != 0) {
+        uint16_t skip = IMU_FIFO_WORDS_PER_SAMPLE - pattern;
+        if (skip > words) skip = words;
+        imu_read_regs(LSM6DS3_REG_FIFO_DATA_OUT_L, (uint8_t *)xyz, skip * 2);
+        words -= skip;
+    }
+
+    uint32_t remaining = words / IMU_FIFO_WORDS_PER_SAMPLE;
+    while (remaining > 0) {
+        uint32_t n = (remaining > IMU_FIFO_BURST_SAMPLES) ? IMU_FIFO_BURST_SAMPLES : remaining;
+
+        // The FIFO output address rolls back to FIFO_DATA_OUT_L on each
+        // word, so the whole burst is a single multi-byte read. Words are
+        // little-endian, like the M33, so the bytes land as int16 X/Y/Z.
+        imu_read_regs(LSM6DS3_REG_FIFO_DATA_OUT_L, (uint8_t *)xyz, n * IMU_FIFO_WORDS_PER_SAMPLE * 2);
+
+        // Oldest sample of the burst; everything still waiting after it is
+        // one ODR period newer, up to the newest sample at "now"
+        uint32_t t0_ms = now_ms - ((remaining - 1) * s_pcfg->period_us) / 1000u;
+        // Never step backwards relative to the previous drain
+        if ((int32_t)(t0_ms - s_last_sample_ms) < 0) {
+            t0_ms = s_last_sample_ms;
+        }
+        imu_process_block(xyz, n, t0_ms);
+        remaining -= n;
+    }
+}
+
+// ==============================
+//  Hardware pedometer
+// ==============================
+
+static bool imu_pedo_read(uint16_t *count)
+{
+    uint8_t raw[2];
+    if (!imu_read_regs(LSM6DS3_REG_STEP_COUNTER_L, raw, 2)) return false;
+    *count = (uint16_t)((raw[1] << 8) | raw[0]);
+    return true;
+}
 
-    // 2) Read raw accelerometer data (LSB)
-    int16_t ax, ay, az;
-    imu_read_accel_raw_internal(&ax, &ay, &az);
-    s_raw_ax = ax;
-    s_raw_ay = ay;
-    s_raw_az = az;
+// Enable the embedded pedometer and take its current count as the baseline
+static bool imu_pedo_enable(uint32_t now_ms)
+{
+    uint8_t ctrl10 = LSM6DS3_CTRL10_FUNC_EN | LSM6DS3_CTRL10_PEDO_EN;
+    imu_write_reg(LSM6DS3_REG_CTRL10_C, ctrl10);
+    if (imu_read_reg(LSM6DS3_REG_CTRL10_C) != ctrl10) return false;
+    if (!imu_pedo_read(&s_pedo_last_count)) return false;
+    s_pedo_last_poll_ms = now_ms;
+    return true;
+}
 
-    // 3) Convert to g units (assuming ±2g full-scale)
-    float ax_g = (float)ax * IMU_ACCEL_LSB_2G;
-    float ay_g = (float)ay * IMU_ACCEL_LSB_2G;
-    float az_g = (float)az * IMU_ACCEL_LSB_2G;
+// Pull new hardware steps into the totals (16-bit counter, so the delta
+// survives wrap-around as long as we poll more than every ~65k steps)
+static void imu_pedo_poll(uint32_t now_ms)
+{
+    uint16_t count;
+    if (!imu_pedo_read(&count)) return;
+    uint16_t delta = (uint16_t)(count - s_pedo_last_count);
+    s_pedo_last_count = count;
+    s_pedo_last_poll_ms = now_ms;
+    if (delta) {
+        imu_add_steps(&(step_event_t){ .t_ms = now_ms, .count = delta });
+    } else {
+        imu_history_advance_buckets(now_ms);
+    }
 
-    s_filt_ax = ax_g;
-    s_filt_ay = ay_g;
-    s_filt_az = az_g;
+    // Keep the raw reading live for diagnostics
+    imu_read_accel_raw_internal(&s_raw_ax, &s_raw_ay, &s_raw_az);
+}
 
-    // 4) Compute magnitude and apply a crude high-pass to remove gravity
-    float mag = sqrtf(ax_g * ax_g + ay_g * ay_g + az_g * az_g);
+static void imu_fall_back_to_software(const char *why)
+{
+    LOG_W("IMU: hardware pedometer %s, falling back to software counting", why);
+    imu_set_step_source(IMU_STEP_SOURCE_SOFTWARE);
+}
 
-    if (!s_mag_lp_initialized) {
-        // First sample seeds the low-pass
-        s_mag_lp = mag;
-        s_mag_lp_initialized = true;
+// Open and close the periodic cross-check window
+static void imu_pedo_check(uint32_t now_ms)
+{
+#if IMU_USE_FIFO
+    if (!s_check_active) {
+        if ((int32_t)(now_ms - s_check_start_ms) < 0) return;
+        // Fresh detector state: the filters last saw data minutes ago
+        step_detect_reset(&s_det);
+        imu_pedo_poll(now_ms);
+        s_check_active = true;
+        s_check_start_ms = now_ms;
+        s_check_hw_base = s_total_steps;
+        s_check_sw_steps = 0;
+        s_last_sample_ms = now_ms;
+        imu_sw_stream_start();
+        return;
+    }
+
+    if ((now_ms - s_check_start_ms) < IMU_PEDO_CHECK_WINDOW_MS) return;
+
+    imu_pedo_poll(now_ms);
+    imu_sw_stream_stop();
+    s_check_active = false;
+    s_check_start_ms = now_ms + IMU_PEDO_CHECK_PERIOD_MS;
+
+    uint32_t hw = s_total_steps - s_check_hw_base;
+    uint32_t sw = s_check_sw_steps;
+    if (hw < IMU_PEDO_CHECK_MIN_STEPS && sw < IMU_PEDO_CHECK_MIN_STEPS) return;
+
+    // The pedometer holds back its first few steps (debounce), so allow
+    // a handful plus 25%
+    uint32_t diff = (hw > sw) ? hw - sw : sw - hw;
+    uint32_t ref = (hw > sw) ? hw : sw;
+    if (diff > 4 + ref / 4) {
+        LOG_D("IMU: pedometer cross-check hw=%lu sw=%lu", hw, sw);
+        if (++s_check_fails >= IMU_PEDO_CHECK_MAX_FAILS) {
+            imu_fall_back_to_software("disagrees with the software detector");
+        }
     } else {
-        s_mag_lp += IMU_MAG_LP_ALPHA * (mag - s_mag_lp);
+        s_check_fails = 0;
     }
+#else
+    (void)now_ms;
+#endif
+}
 
-    s_mag_hp = mag - s_mag_lp;
+bool imu_set_step_source(imu_step_source_t source)
+{
+    if (!s_initialized) return false;
+    if (source == s_step_source) return true;
 
-    // 5) Very simple step detector:
-    //    - look for high-pass magnitude above threshold
-    //    - enforce a minimum time interval between step events
-    if (s_mag_hp > IMU_STEP_THRESHOLD_G) {
-        uint32_t dt = now_ms - s_last_step_ms;
-        if (dt > IMU_STEP_MIN_INTERVAL_MS) {
-            s_last_step_ms = now_ms;
-            s_total_steps++;
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
 
-            // Count step into the current minute bucket
-            s_steps_per_min[s_curr_min_idx]++;
-            s_steps_last_hour_sum++;
+    if (source == IMU_STEP_SOURCE_HARDWARE) {
+        if (!imu_pedo_enable(now_ms)) {
+            imu_write_reg(LSM6DS3_REG_CTRL10_C, 0x00);
+            LOG_W("IMU: hardware pedometer unavailable");
+            return false;
         }
+        imu_sw_stream_stop();
+        s_step_source = IMU_STEP_SOURCE_HARDWARE;
+        s_check_active = false;
+        s_check_fails = 0;
+        s_check_start_ms = now_ms + IMU_PEDO_CHECK_PERIOD_MS;
+        return true;
     }
+
+    // Collect the last hardware steps before handing over
+    imu_pedo_poll(now_ms);
+    imu_write_reg(LSM6DS3_REG_CTRL10_C, 0x00);
+    s_step_source = IMU_STEP_SOURCE_SOFTWARE;
+    s_check_active = false;
+    step_detect_reset(&s_det);
+    s_last_sample_ms = now_ms;
+    imu_sw_stream_start();
+    return true;
+}
+
+imu_step_source_t imu_get_step_source(void)
+{
+    return s_step_source;
+}
+
+// ==============================
+//  Power mode management
+// ==============================
+
+// Reprogram the accelerometer for a new mode. Samples buffered at the old
+// rate must already have been drained.
+static void imu_apply_power_mode(imu_power_mode_t mode, uint32_t now_ms)
+{
+    s_power_mode = mode;
+    s_pcfg = &s_power_cfg[mode];
+
+    imu_write_reg(LSM6DS3_REG_CTRL6_C, s_pcfg->ctrl6_c);
+    imu_write_reg(LSM6DS3_REG_CTRL1_XL, s_pcfg->ctrl1_xl);
+    imu_write_reg(LSM6DS3_REG_MD1_CFG, (mode == IMU_POWER_LOW) ? LSM6DS3_MD1_INT1_WU : 0x00);
+
+    step_detect_set_odr(&s_det, s_pcfg->odr_hz);
+
+    // Restart the FIFO with the new rate and watermark
+    bool streaming = (s_step_source == IMU_STEP_SOURCE_SOFTWARE) || s_check_active;
+    if (streaming) {
+        imu_sw_stream_start();
+    }
+    s_last_sample_ms = now_ms;
+    (void)imu_read_reg(LSM6DS3_REG_WAKE_UP_SRC); // clear a stale wake-up flag
+}
+
+// Choose the power mode after the latest samples have been processed
+static void imu_power_update(uint32_t now_ms)
+{
+    if (s_power_mode == IMU_POWER_LOW) {
+        // Wake on the sensor's wake-up engine, or on steps counted anyway.
+        // Reading WAKE_UP_SRC also releases the latched INT1.
+        uint8_t wu = imu_read_reg(LSM6DS3_REG_WAKE_UP_SRC);
+        if ((wu & LSM6DS3_WAKE_UP_SRC_WU_IA) ||
+            (int32_t)(s_last_activity_ms - s_low_since_ms) > 0) {
+            s_last_activity_ms = now_ms;
+            imu_apply_power_mode(IMU_POWER_ACTIVE, now_ms);
+        }
+        return;
+    }
+
+    uint32_t idle_ms = (imu_get_activity_level() == 0) ? IMU_IDLE_TO_LOW_QUIET_MS
+                                                       : config_value(CONFIG_IDLE_TO_LOW_S) * 1000u;
+    if ((now_ms - s_last_activity_ms) >= idle_ms) {
+        s_low_since_ms = now_ms;
+        imu_apply_power_mode(IMU_POWER_LOW, now_ms);
+    }
+}
+
+bool imu_sleep_prepare(uint32_t now_ms)
+{
+    if (!s_initialized) return false;
+
+    // Catch up first; this may already switch back to active
+    imu_update(now_ms);
+    if (s_power_mode != IMU_POWER_LOW || s_check_active) return false;
+
+    if (s_step_source == IMU_STEP_SOURCE_SOFTWARE) {
+        imu_sw_stream_stop();
+    }
+    // Release the latched INT1. Movement in the meantime means we stay up:
+    // the next imu_update() goes active.
+    uint8_t wu = imu_read_reg(LSM6DS3_REG_WAKE_UP_SRC);
+    if (wu & LSM6DS3_WAKE_UP_SRC_WU_IA) {
+        s_last_activity_ms = now_ms;
+        imu_sleep_resume(now_ms);
+        return false;
+    }
+    return true;
+}
+
+void imu_sleep_resume(uint32_t now_ms)
+{
+    if (!s_initialized) return;
+    if (s_step_source == IMU_STEP_SOURCE_SOFTWARE) {
+        imu_sw_stream_start();
+    }
+    s_last_sample_ms = now_ms;
+}
+
+imu_power_mode_t imu_get_power_mode(void)
+{
+    return s_power_mode;
+}
+
+uint16_t imu_get_odr_hz(void)
+{
+    return s_pcfg->odr_hz;
+}
+
+void imu_update(uint32_t now_ms)
+{
+    if (!s_initialized) {
+        return;
+    }
+
+    if (s_step_source == IMU_STEP_SOURCE_HARDWARE) {
+#if IMU_USE_FIFO
+        if (s_check_active) imu_fifo_drain(now_ms);
+#endif
+        if ((now_ms - s_pedo_last_poll_ms) >= IMU_PEDO_POLL_MS) {
+            imu_pedo_poll(now_ms);
+        }
+        imu_pedo_check(now_ms);
+        imu_power_update(now_ms);
+        return;
+    }
+
+#if IMU_USE_FIFO
+    imu_fifo_drain(now_ms);
+#else
+    int16_t xyz[3];
+    imu_read_accel_raw_internal(&xyz[0], &xyz[1], &xyz[2]);
+    imu_process_block(xyz, 1, now_ms);
+#endif
+    imu_power_update(now_ms);
 }
 
 void imu_get_accel_raw(int16_t *ax, int16_t *ay, int16_t *az)
@@ -298,9 +791,15 @@ void imu_get_accel_raw(int16_t *ax, int16_t *ay, int16_t *az)
 
 void imu_get_accel_filtered(float *ax, float *ay, float *az)
 {
-    if (ax) *ax = s_filt_ax;
-    if (ay) *ay = s_filt_ay;
-    if (az) *az = s_filt_az;
+    // Converted on request rather than per sample
+    if (ax) *ax = (float)s_raw_ax * IMU_ACCEL_LSB_2G;
+    if (ay) *ay = (float)s_raw_ay * IMU_ACCEL_LSB_2G;
+    if (az) *az = (float)s_raw_az * IMU_ACCEL_LSB_2G;
+}
+
+uint32_t imu_get_fifo_overruns(void)
+{
+    return s_fifo_overruns;
 }
 
 uint32_t imu_get_total_steps(void)
@@ -308,18 +807,44 @@ uint32_t imu_get_total_steps(void)
     return s_total_steps;
 }
 
+void imu_restore_total_steps(uint32_t steps)
+{
+    s_total_steps = steps;
+    s_check_hw_base = steps;
+}
+
+void imu_set_step_params(const step_detect_params_t *params)
+{
+    step_detect_set_params(&s_det, params);
+}
+
+size_t imu_read_step_events(step_event_t *out, size_t max)
+{
+    size_t n = 0;
+    while (n < max && s_step_ev_tail != s_step_ev_head) {
+        out[n++] = s_step_events[s_step_ev_tail++ % IMU_STEP_EVENTS];
+    }
+    return n;
+}
+
+uint32_t imu_get_reference_steps(void)
+{
+    return s_det.ref_steps;
+}
+
 uint16_t imu_get_steps_last_hour(void)
 {
-    if (s_steps_last_hour_sum > 0xFFFFu) {
+    uint32_t steps = history_steps_last_minutes(HISTORY_MINUTES);
+    if (steps > 0xFFFFu) {
         // Clamp in case of overflow (shouldn't realistically happen)
         return 0xFFFFu;
     }
-    return (uint16_t)s_steps_last_hour_sum;
+    return (uint16_t)steps;
 }
 
 bool imu_step_goal_reached(void)
 {
-    return imu_get_steps_last_hour() >= IMU_STEP_GOAL_PER_HOUR;
+    return imu_get_steps_last_hour() >= config_value(CONFIG_STEP_GOAL_PER_HOUR);
 }
 
 // Very rough activity classification based on steps in the last hour.
@@ -330,12 +855,13 @@ bool imu_step_goal_reached(void)
 uint8_t imu_get_activity_level(void)
 {
     uint16_t steps = imu_get_steps_last_hour();
+    uint32_t goal = config_value(CONFIG_STEP_GOAL_PER_HOUR);
 
     if (steps < 50) {
         return 0;
-    } else if (steps < IMU_STEP_GOAL_PER_HOUR) {
+    } else if (steps < goal) {
         return 1;
-    } else if (steps < (IMU_STEP_GOAL_PER_HOUR * 2)) {
+    } else if (steps < (goal * 2)) {
         return 2;
     } else {
         return 3;
@@ -2,8 +2,38 @@
 #define IMU_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "step_detect.h"
+
+//LSM6DS3 INT1 (FIFO watermark / data-ready / wake-up), push-pull active
+//high. The current PCB leaves the sensor's INT pins unconnected, so INT1
+//needs a rework wire to this GPIO. The pin has a pull-down, so without
+//the wire it stays low and the main loop's fallback drain does the work.
+#ifndef IMU_INT1_PIN
+#define IMU_INT1_PIN  13
+#endif
+
+//Set to 1 once that wire is fitted. Only then may the MCU go dormant
+//(power.h): INT1 is the one thing that can wake it for movement.
+#ifndef IMU_INT1_FITTED
+#define IMU_INT1_FITTED  0
+#endif
+
+// Where step counts come from
+typedef enum {
+    IMU_STEP_SOURCE_SOFTWARE,   // MCU runs the step detector on every sample
+    IMU_STEP_SOURCE_HARDWARE,   // LSM6DS3 embedded pedometer, polled by the MCU
+} imu_step_source_t;
+
+// Accelerometer power modes (the gyro is always off)
+typedef enum {
+    IMU_POWER_ACTIVE,           // 104 Hz high-performance
+    IMU_POWER_LOW,              // 26 Hz low-power, wake-up interrupt armed
+    IMU_POWER_MODE_COUNT
+} imu_power_mode_t;
+
 // 3D vector
 typedef struct {
     float x;
@@ -12,12 +42,48 @@ typedef struct {
 } imu_vec3f_t;
 
 //Initialize the IMU module.
+//INT1 is configured to go high on FIFO watermark (or on accelerometer
+//data-ready when the FIFO is disabled).
 //Returns true on success, false if the sensor is not responding.
 bool imu_init(void);
 
-//Update IMU state. Call this at a fixed rate.
+//Update IMU state. In FIFO mode this drains every buffered sample and runs
+//each one through the step detector; call it often enough that the FIFO
+//doesn't overflow (a few times per second is plenty).
 void imu_update(uint32_t now_ms);
 
+//Select the step source. Totals and per-minute history carry on across the
+//switch. In hardware mode the software detector still runs now and then as
+//a cross-check and takes over for good if the two disagree.
+//Returns false if the hardware pedometer couldn't be enabled.
+bool imu_set_step_source(imu_step_source_t source);
+
+//Current step source (may have fallen back to software on its own).
+imu_step_source_t imu_get_step_source(void);
+
+//Current accelerometer power mode and its output data rate. imu_update()
+//switches modes on its own: low-power after a while without steps, back to
+//active as soon as the sensor's wake-up interrupt sees movement.
+imu_power_mode_t imu_get_power_mode(void);
+
+//Before the MCU goes dormant (low-power mode only): stop the sample stream
+//so INT1 carries nothing but the wake-up engine. Returns false, with
+//everything left running, if that isn't possible right now or the sensor
+//already saw movement.
+bool imu_sleep_prepare(uint32_t now_ms);
+
+//After waking: restart the sample stream
+void imu_sleep_resume(uint32_t now_ms);
+uint16_t imu_get_odr_hz(void);
+
+//Run a batch of n accelerometer samples through the step detector.
+//xyz holds interleaved raw X/Y/Z (LSB); sample i was taken at
+//t0_ms + i periods of the current ODR. imu_update() calls this for each FIFO burst.
+void imu_process_block(const int16_t *xyz, size_t n, uint32_t t0_ms);
+
+//Number of times the sensor FIFO overran and lost samples since init.
+uint32_t imu_get_fifo_overruns(void);
+
 //Get the last raw accelerometer reading (LSB).
 //ax, ay, az: pointers that will receive the raw 16-bit values.
 void imu_get_accel_raw(int16_t *ax, int16_t *ay, int16_t *az);
@@ -28,6 +94,23 @@ void imu_get_accel_filtered(float *ax, float *ay, float *az);
 //Get the total number of steps since boot.
 uint32_t imu_get_total_steps(void);
 
+//Carry a total over from before a reset (e.g. the persistent log); new
+//steps are added on top. Call once, right after imu_init().
+void imu_restore_total_steps(uint32_t steps);
+
+//Retune the software step detector (config.h); call after imu_init().
+//Detector state and counts are kept.
+void imu_set_step_params(const step_detect_params_t *params);
+
+//Take up to max queued step events, oldest first; returns how many. Every
+//counted step shows up here once (hardware-pedometer steps as one event
+//per poll). If the queue fills, the newest event absorbs the new counts.
+size_t imu_read_step_events(step_event_t *out, size_t max);
+
+//Steps counted by the other detector (float reference, or fixed-point if
+//the float one is primary). Always 0 unless built with STEP_DETECT_AB_COMPARE.
+uint32_t imu_get_reference_steps(void);
+
 //Get the number of steps in the last 60 minutes.
 uint16_t imu_get_steps_last_hour(void);
 
@@ -0,0 +1,85 @@
+#include "log.h"
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "telemetry.h"
+
+// Entries per core; power of two
+#define LOG_RING_SIZE     32u
+#define LOG_RING_MASK     (LOG_RING_SIZE - 1u)
+
+// Longest formatted message; longer ones are cut
+#define LOG_TEXT_MAX      96
+
+typedef struct {
+    const char *fmt;
+    uint32_t    args[4];
+    uint32_t    t_us;
+    uint8_t     level;
+    uint8_t     nargs;
+} log_entry_t;
+
+// One single-producer ring per core (producer: that core, outside IRQs;
+// consumer: core 1), so pushing never needs a lock
+typedef struct {
+    log_entry_t       entries[LOG_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t          drops;
+} log_ring_t;
+
+static log_ring_t s_rings[2];
+
+void log_push(uint8_t level, const char *fmt, uint8_t nargs,
+              uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    log_ring_t *r = &s_rings[get_core_num()];
+    uint32_t head = r->head;
+    if (head - r->tail >= LOG_RING_SIZE) {
+        r->drops++;
+        return;
+    }
+
+    log_entry_t *e = &r->entries[head & LOG_RING_MASK];
+    e->fmt = fmt;
+    e->args[0] = a0;
+    e->args[1] = a1;
+    e->args[2] = a2;
+    e->args[3] = a3;
+    e->t_us = time_us_32();
+    e->level = level;
+    e->nargs = nargs;
+
+    __dmb();   // entry visible before the new head
+    r->head = head + 1;
+}
+
+void log_service(void)
+{
+    for (uint32_t core = 0; core < 2; core++) {
+        log_ring_t *r = &s_rings[core];
+        uint32_t head = r->head;
+        __dmb();   // pairs with the producer's barrier
+
+        for (uint32_t tail = r->tail; tail != head; tail++) {
+            const log_entry_t *e = &r->entries[tail & LOG_RING_MASK];
+            char text[LOG_TEXT_MAX];
+
+            // Every argument is one 32-bit word, so passing all four is safe
+            // whatever the format consumes
+            int n = snprintf(text, sizeof(text), e->fmt,
+                             e->args[0], e->args[1], e->args[2], e->args[3]);
+            if (n < 0) n = 0;
+            if (n >= (int)sizeof(text)) n = sizeof(text) - 1;
+            telemetry_send_log(e->level, e->t_us, text, (size_t)n);
+
+            __dmb();   // done with the entry before handing the slot back
+            r->tail = tail + 1;
+        }
+    }
+}
+
+uint32_t log_get_drops(void)
+{
+    return s_rings[0].drops + s_rings[1].drops;
+}
@@ -0,0 +1,86 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// ==============================
+//  Deferred logging
+// ==============================
+//
+// LOG_E/LOG_W/LOG_I/LOG_D(fmt, ...) take printf-style formats with up to
+// four arguments. Levels above LOG_LEVEL compile to nothing (arguments are
+// not evaluated). Enabled ones only store the format pointer, the raw
+// arguments and a timestamp in a per-core lock-free ring; log_service() on
+// core 1 formats them and sends them out as telemetry LOG frames.
+//
+// Because formatting happens later, arguments are captured as 32-bit words:
+// integers, chars and pointers to strings that outlive the call (literals,
+// static tables). No floats, no 64-bit values, no stack buffers with %s.
+//
+
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Queue one entry (use the LOG_* macros instead)
+void log_push(uint8_t level, const char *fmt, uint8_t nargs,
+              uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+// Core 1: format and send everything queued so far
+void log_service(void);
+
+// Entries lost because a ring was full
+uint32_t log_get_drops(void);
+
+// ---- macro plumbing ----
+
+#define LOG_ARG(x)  ((uint32_t)(uintptr_t)(x))
+#define LOG_ARGC(...) LOG_ARGC_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define LOG_ARGC_(_0, _1, _2, _3, _4, n, ...) n
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+
+#define LOG_PUSH_0(l, f)             log_push(l, f, 0, 0, 0, 0, 0)
+#define LOG_PUSH_1(l, f, a)          log_push(l, f, 1, LOG_ARG(a), 0, 0, 0)
+#define LOG_PUSH_2(l, f, a, b)       log_push(l, f, 2, LOG_ARG(a), LOG_ARG(b), 0, 0)
+#define LOG_PUSH_3(l, f, a, b, c)    log_push(l, f, 3, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), 0)
+#define LOG_PUSH_4(l, f, a, b, c, d) log_push(l, f, 4, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d))
+
+// Format-checks the arguments against fmt without ever calling printf
+#define LOG_POST(level, fmt, ...) do {                                   \
+        (void)(0 && printf(fmt, ##__VA_ARGS__));                         \
+        LOG_CAT(LOG_PUSH_, LOG_ARGC(__VA_ARGS__))(level, fmt, ##__VA_ARGS__); \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) LOG_POST(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) LOG_POST(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) LOG_POST(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) LOG_POST(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) ((void)0)
+#endif
+
+#endif // LOG_H
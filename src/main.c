@@ -1,349 +1,411 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
 
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
-#include "hardware/pio.h"
+#include "pico/multicore.h"
 #include "hardware/gpio.h"
 
+#include "battery.h"
+#include "boot.h"
+#include "buttons.h"
+#include "calorie_model.h"
+#include "calories.h"
+#include "config.h"
+#include "events.h"
+#include "flash_log.h"
+#include "history.h"
+#include "i2c_bus.h"
 #include "imu.h"
-#include "oled.h"
-#include "font5x7.h"
-#include "steps_to_calories.h"
-#include "ws2812.pio.h"
-
-// I2C is shared by the OLED and MAX17048 fuel gauge
-#define I2C_PORT    i2c1
-#define I2C_SDA_PIN 14
-#define I2C_SCL_PIN 15
-
-// WS2812 configuration
-#define LED_PIN         8
-#define NUM_LEDS        4
-#define IS_RGBW         false
-#define LED_FREQ_HZ     800000
-#define STEPS_PER_LED   25
-#define BREATH_PERIOD_MS 3000
-
-// Button GPIOs on Proton board
-#define BUTTON_MODE_PIN  26  // Toggle display between steps and calories
-#define BUTTON_START_PIN 21  // Start/pause/continue workout
-
-// User configuration for calorie estimates
-#define USER_WEIGHT_LBS       160
-#define USER_HEIGHT_CATEGORY  HEIGHT_MEDIUM
+#include "log.h"
+#include "max17048.h"
+#include "power.h"
+#include "prof.h"
+#include "telemetry.h"
+#include "ui.h"
+#include "ui_state.h"
+
+// ==============================
+//  Core 0: sensors and step detection
+// ==============================
+//
+// Core 0 owns the IMU, fuel gauge and buttons and publishes a ui_state
+// snapshot; core 1 (ui.c) owns the OLED, LEDs and serial diagnostics, so a
+// slow display push or USB write can't delay step detection.
+//
 
 // Update cadences (ms)
-#define IMU_SAMPLE_MS       20   // ~50 Hz for step detection
-#define DISPLAY_REFRESH_MS  250
-#define BATTERY_SAMPLE_MS   1000
-#define DIAG_INTERVAL_MS    500  // Serial diagnostics cadence
-
-// Fuel-gauge API (implemented in max17048.c)
-float read_voltage(void);
-float read_soc(void);
-int quickstart(void);
-
-// WS2812 helpers (implemented in ws2812.c)
-uint32_t rgb_to_grb(uint8_t r, uint8_t g, uint8_t b);
-void put_pixel(uint32_t pixel_grb);
-
-static void i2c_bus_init(void) {
-    i2c_init(I2C_PORT, 400 * 1000); // 400 kHz
-    gpio_set_function(I2C_SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(I2C_SDA_PIN);
-    gpio_pull_up(I2C_SCL_PIN);
-}
-
-static uint8_t clamp_percent(float soc) {
-    if (soc < 0.0f) return 0;
-    if (soc > 100.0f) return 100;
-    return (uint8_t)(soc + 0.5f); // round to nearest
-}
-
-// Smooth red -> yellow -> green gradient across 0-100%
-static void battery_color(uint8_t percent, uint8_t *r, uint8_t *g, uint8_t *b) {
-    uint8_t p = (percent > 100) ? 100 : percent;
-    // Swapped channels to test physical wiring/order: green now tracks low charge,
-    // red tracks high charge. Expect green at 100%, red at 0% if channels were reversed.
-    *g = (uint8_t)((255 * (100 - p)) / 100); // 255 at 0%, 0 at 100%
-    *r = (uint8_t)((255 * p) / 100);         // 0 at 0%, 255 at 100%
-    *b = 0;
-}
-
-static void update_led_bar(uint32_t steps, uint8_t battery_percent, uint32_t now_ms) {
-    uint8_t r = 0, g = 0, b = 0;
-    battery_color(battery_percent, &r, &g, &b);
-
-    // Breathing blue for unlit/partial LEDs
-    float phase = (float)(now_ms % BREATH_PERIOD_MS) / (float)BREATH_PERIOD_MS; // 0-1
-    float breath = (sinf(phase * 2.0f * (float)M_PI) + 1.0f) * 0.5f;             // 0-1
-    uint8_t breath_level = (uint8_t)(breath * 80.0f); // cap breathing brightness
-
-    for (uint8_t i = 0; i < NUM_LEDS; i++) {
-        int32_t steps_into_segment = (int32_t)steps - (int32_t)(i * STEPS_PER_LED);
-        if (steps_into_segment <= 0) {
-            put_pixel(rgb_to_grb(0, 0, breath_level));
-            continue;
-        }
-        if (steps_into_segment > STEPS_PER_LED) steps_into_segment = STEPS_PER_LED;
-        uint8_t scale = (uint8_t)((steps_into_segment * 255) / STEPS_PER_LED); // 0-255 brightness
-        uint8_t sr = (uint8_t)((r * scale) / 255);
-        uint8_t sg = (uint8_t)((g * scale) / 255);
-        uint8_t sb = (uint8_t)((b * scale) / 255);
-        if (scale < 255) {
-            // Add breathing blue when not fully lit
-            uint16_t boosted_b = sb + breath_level;
-            sb = (boosted_b > 255) ? 255 : (uint8_t)boosted_b;
-        }
-        put_pixel(rgb_to_grb(sr, sg, sb));
+#define IMU_SAMPLE_MS       500  // FIFO drain without an INT1 edge (the only path with INT1 unwired)
+#define TICK_MS             100  // EVENT_TICK period for publishing
+#define TICK_IDLE_MS        250  // the same with the display asleep (fallback drain only)
+#define FLASH_LOG_INTERVAL_MS 60000  // one persistent record per minute
+#define TELEMETRY_STATE_MS  500  // periodic state frame
+#define PROF_REPORT_MS      5000 // profiler window length
+#define POWER_REPORT_MS     60000 // power-state totals
+
+// An IMU pass later than this is a deadline miss: the fallback drain period
+// plus one tick (of the current length) of wake-up granularity
+#define IMU_DEADLINE_MS(tick_ms) (IMU_SAMPLE_MS + (tick_ms))
+
+static void send_state_telemetry(const ui_state_t *ui, uint32_t now_ms) {
+    telemetry_state_t t = {
+        .t_ms = now_ms,
+        .steps = ui->steps,
+        .total_steps = ui->imu_ok ? imu_get_total_steps() : 0,
+        .calories = ui->calories,
+        .soc_x10 = (uint16_t)(ui->soc * 10.0f + 0.5f),
+        .battery_percent = ui->battery_percent,
+        .odr_hz = ui->imu_odr_hz,
+        .accel_raw = {ui->accel_raw[0], ui->accel_raw[1], ui->accel_raw[2]},
+        .fifo_overruns = ui->imu_ok ? imu_get_fifo_overruns() : 0,
+    };
+    if (ui->imu_ok) t.flags |= TELEMETRY_STATE_IMU_OK;
+    if (ui->show_calories) t.flags |= TELEMETRY_STATE_SHOW_CALORIES;
+    if (ui->paused) t.flags |= TELEMETRY_STATE_PAUSED;
+    if (ui->imu_ok && imu_get_power_mode() == IMU_POWER_LOW) t.flags |= TELEMETRY_STATE_LOW_POWER;
+    if (ui->imu_ok && imu_get_step_source() == IMU_STEP_SOURCE_HARDWARE) t.flags |= TELEMETRY_STATE_HW_STEPS;
+
+    for (int d = 0; d < I2C_DEV_COUNT; d++) {
+        i2c_dev_stats_t bs;
+        i2c_bus_get_stats((i2c_dev_t)d, &bs);
+        t.i2c_errors += bs.errors;
+        t.i2c_failures += bs.failures;
     }
+    telemetry_send_state(&t);
 }
 
+// ==============================
+//  Workout
+// ==============================
+//
+// Runs from boot. A START press pauses or resumes it (steps taken while
+// paused don't count); a long press ends it and starts a new one at zero.
+
 typedef struct {
-    uint16_t frame_idx;
-    uint16_t frames_per_travel;
-    uint8_t last_pos;
-} led_bounce_state_t;
-
-static void startup_led_bounce_step(void *ctx, int16_t x_unused) {
-    (void)x_unused;
-    led_bounce_state_t *state = (led_bounce_state_t *)ctx;
-    if (state->frames_per_travel == 0) state->frames_per_travel = 1;
-
-    if (NUM_LEDS == 0) return;
-    uint8_t end = NUM_LEDS - 1;
-    uint16_t travel = state->frame_idx / state->frames_per_travel;
-    uint16_t within = state->frame_idx % state->frames_per_travel;
-
-    bool forward = (travel & 0x1) == 0;
-
-    float t = 0.0f;
-    if (state->frames_per_travel > 1) {
-        t = (float)within / (float)(state->frames_per_travel - 1);
+    bool     running;
+    uint32_t offset;        // total at the start, plus steps taken while paused
+    uint32_t paused_total;  // total when paused
+} workout_t;
+
+static uint32_t workout_steps(workout_t *w, uint32_t total)
+{
+    uint32_t end = w->running ? total : w->paused_total;
+    if (end < w->offset) {
+        // The total went backwards (restored log): restart from here
+        w->offset = end;
     }
+    return end - w->offset;
+}
 
-    // Position along strip with a smooth cross-fade between LEDs
-    float posf = t * (float)end;
-    if (!forward) posf = (float)end - posf;
-
-    uint8_t base = (uint8_t)posf;
-    if (base > end) base = end;
-    float frac = posf - (float)base; // 0..1 between base and next
-
-    uint8_t head_level = (uint8_t)(80.0f + frac * 20.0f + 0.5f);    // 80 -> 100
-    uint8_t next_level = (uint8_t)(frac * 20.0f + 0.5f);            // 0 -> 20
-    uint8_t neighbor = forward ? (uint8_t)(base + 1) : (base == 0 ? 0 : (uint8_t)(base - 1));
-    if (neighbor > end) neighbor = end;
-
-    for (uint8_t i = 0; i < NUM_LEDS; i++) {
-        uint8_t level = 0;
-        if (i == base) {
-            level = head_level;
-        } else if (i == neighbor && neighbor != base) {
-            level = next_level;
+static void workout_button(workout_t *w, button_gesture_t gesture, uint32_t total)
+{
+    if (gesture == BUTTON_LONG_PRESS) {
+        w->running = true;
+        w->offset = total;
+        LOG_I("New workout at %lu steps", total);
+    } else if (gesture == BUTTON_PRESS) {
+        if (w->running) {
+            w->paused_total = total;
+        } else if (total >= w->paused_total) {
+            w->offset += total - w->paused_total;
         }
-        put_pixel(rgb_to_grb(level, level, 0)); // warm yellow bounce with smooth cross-fade
+        w->running = !w->running;
+        LOG_I("Workout %s", w->running ? "resumed" : "paused");
     }
-
-    state->last_pos = base;
-    state->frame_idx++;
 }
 
-static void buttons_init(void) {
-    gpio_init(BUTTON_MODE_PIN);
-    gpio_set_dir(BUTTON_MODE_PIN, GPIO_IN);
-    gpio_pull_up(BUTTON_MODE_PIN);   // Active-low button with pull-up
+// ==============================
+//  History restore
+// ==============================
+//
+// The log holds a running total once a minute; the difference between two
+// records goes into the later one's buckets. Only the span the rings cover
+// is replayed.
 
-    gpio_init(BUTTON_START_PIN);
-    gpio_set_dir(BUTTON_START_PIN, GPIO_IN);
-    gpio_pull_up(BUTTON_START_PIN);  // Active-low button with pull-up
+typedef struct {
+    uint32_t since_s;
+    uint32_t now_s;
+    uint32_t prev_steps;
+    bool     have_prev;
+} history_replay_t;
+
+static void history_replay_visit(const flash_log_entry_t *e, void *ctx)
+{
+    history_replay_t *h = (history_replay_t *)ctx;
+    // A smaller total means the count restarted from zero at that boot
+    uint32_t steps = (h->have_prev && e->steps >= h->prev_steps) ? e->steps - h->prev_steps : e->steps;
+    bool first = !h->have_prev;
+    h->prev_steps = e->steps;
+    h->have_prev = true;
+    if (first || e->time_s < h->since_s || e->time_s > h->now_s) return;
+    history_add_steps(steps, e->time_s);
 }
 
-static void render_oled(uint32_t steps, uint32_t calories, uint8_t battery_percent,
-                        bool show_calories, bool paused, uint32_t now_ms,
-                        uint32_t flash_until_ms) {
-    oled_home();
-
-    bool flash = now_ms < flash_until_ms;
-
-    if (show_calories) {
-        oled_print(6, 4, "CAL");
-        oled_show_battery_animated(battery_percent, now_ms);
-        oled_show_calories(calories);
-    } else {
-        oled_print(6, 4, "STEPS");
-        oled_show_battery_animated(battery_percent, now_ms);
-        oled_show_steps(steps);
-    }
+static void restore_history(uint32_t now_ms) {
+    uint32_t now_s = flash_log_time_s(now_ms);
+    history_replay_t h = {
+        .since_s = now_s > HISTORY_DAYS * 86400u ? now_s - HISTORY_DAYS * 86400u : 0,
+        .now_s = now_s,
+    };
+    history_init(h.since_s);
+    flash_log_for_each(history_replay_visit, &h);
+    history_advance(now_s);
+    LOG_I("Restored step history: %lu today", history_steps_today());
+}
 
-    if (paused) {
-        // Show "PAUSED" near the bottom of the 32px display
-        oled_print(32, 24, "PAUSED");
-    }
+static void imu_int_init(void) {
+    gpio_init(IMU_INT1_PIN);
+    gpio_set_dir(IMU_INT1_PIN, GPIO_IN);
+    gpio_pull_down(IMU_INT1_PIN);   // quiet if the line isn't fitted (imu.h)
+    events_bind_gpio(IMU_INT1_PIN, GPIO_IRQ_EDGE_RISE, EVENT_IMU);
+}
 
-    if (flash) {
-        // 1px border flash to indicate a new step
-        oled_draw_rect(0, 0, OLED_WIDTH, OLED_HEIGHT, 1);
+// Hand the config values to the modules that own their derived constants
+// (calorie rates, detector thresholds); called at boot and after every edit
+static void apply_config(calories_t *cal, bool imu_ok) {
+    const config_t *cfg = config_get();
+
+    // Re-resolving the profile keeps the running total
+    uint32_t steps = cal->steps;
+    uint32_t calories = calories_get(cal);
+    calories_init(cal, &(calories_profile_t){
+        .weight_lbs = cfg->v[CONFIG_WEIGHT_LBS],
+        .height = (height_category_t)cfg->v[CONFIG_HEIGHT],
+        .mode = (calories_mode_t)cfg->v[CONFIG_CALORIES_MODE],
+    });
+    calories_restore(cal, steps, calories);
+    calorie_model_set_stride((uint32_t)(cal->stride_m * 1000.0f + 0.5f));
+
+    if (imu_ok) {
+        imu_set_step_params(&(step_detect_params_t){
+            .threshold_mg = cfg->v[CONFIG_STEP_THRESHOLD_MG],
+            .min_interval_ms = cfg->v[CONFIG_STEP_MIN_INTERVAL_MS],
+            .block_min_peak_mg = cfg->v[CONFIG_STEP_BLOCK_MIN_PEAK_MG],
+            .block_min_interval_ms = cfg->v[CONFIG_STEP_BLOCK_MIN_INTERVAL_MS],
+        });
     }
-
-    oled_display();
 }
 
 int main(void) {
-    stdio_init_all();
-    sleep_ms(200); // give USB time to enumerate
+    // Before anything touches the watchdog scratch registers
+    boot_init();
 
+    // No wait for USB: log and telemetry frames queue until core 1 sends them
+    stdio_init_all();
+    telemetry_init();
+    prof_init();
     i2c_bus_init();
+    events_init(TICK_MS);
     buttons_init();
 
-    if (quickstart() != 0) {
-        printf("MAX17048 quickstart failed\n");
-    }
-
-    bool oled_ok = oled_init();
-    if (!oled_ok) {
-        printf("OLED init failed!\n");
-    }
-
+    // The IMU goes first so its FIFO is filling while the rest comes up
     bool imu_ok = imu_init();
     if (!imu_ok) {
-        printf("IMU init failed!\n");
+        LOG_E("IMU init failed!");
+    } else {
+        imu_int_init();
     }
 
-    uint offset = pio_add_program(pio0, &ws2812_program);
-    ws2812_program_init(pio0, 0, offset, LED_PIN, LED_FREQ_HZ, IS_RGBW);
-    for (uint8_t i = 0; i < NUM_LEDS; i++) {
-        put_pixel(rgb_to_grb(0, 0, 0)); // clear strip
+    battery_init();
+    power_init(IMU_INT1_PIN);
+
+    // Pick up where the last run left off: a warm reset has the exact
+    // totals in the scratch registers, otherwise use the last flash record
+    flash_log_entry_t last_log;
+    bool have_log = flash_log_init() && flash_log_last(&last_log);
+    config_init();
+    uint32_t restore_steps = 0;
+    uint32_t restore_calories = 0;
+    bool restored = false;
+    if (boot_restore(&restore_steps, &restore_calories)) {
+        restored = true;
+        LOG_I("Restored %lu steps from before the reset", restore_steps);
+    } else if (have_log) {
+        restore_steps = last_log.steps;
+        restore_calories = last_log.calories;
+        restored = true;
+        LOG_I("Restored %lu steps from flash log", restore_steps);
+    }
+    if (restored && imu_ok) {
+        imu_restore_total_steps(restore_steps);
+    }
+    // history.c runs on the log clock, which only now knows where it left off
+    if (have_log && imu_ok) {
+        restore_history(to_ms_since_boot(get_absolute_time()));
     }
 
-    float soc = read_soc();
-    if (soc < 0.0f) soc = 0.0f;
-    uint8_t battery_percent = clamp_percent(soc);
+    const battery_state_t *battery = battery_get();
     uint32_t last_imu_ms = 0;
-    uint32_t last_display_ms = 0;
-    uint32_t last_battery_ms = 0;
-    uint32_t last_diag_ms = 0;
-    uint32_t prev_steps = 0;
+    uint32_t last_log_ms = 0;
+    uint32_t last_state_ms = 0;
+    uint32_t last_prof_ms = 0;
+    uint32_t last_power_ms = 0;
     bool show_calories = false;
-    // Seed last button states from actual GPIO levels so we don't auto-toggle on boot.
-    bool last_mode_level = gpio_get(BUTTON_MODE_PIN);
-    uint32_t last_mode_toggle_ms = 0;  // debounce timer
-    bool workout_running = true;       // start immediately
-    bool workout_started = true;
-    bool last_start_level = gpio_get(BUTTON_START_PIN);
-    uint32_t last_start_toggle_ms = 0; // unused while auto-run is enabled
-    uint32_t workout_steps = 0;
-    uint32_t workout_offset = 0;       // start counting from boot
-    uint32_t step_flash_until_ms = 0;  // border flash timer on step increment
-
-    if (oled_ok) {
-        const char *title = "Pico Activity Tracker";
-        size_t title_len = strlen(title);
-        uint16_t title_px = (uint16_t)(title_len * (FONT_WIDTH + 1));
-        if (title_px > 0) title_px -= 1;
-        int16_t target_x = (title_px < OLED_WIDTH) ? (int16_t)((OLED_WIDTH - title_px) / 2) : 0;
-        uint16_t slide_frames = (uint16_t)(((OLED_WIDTH - target_x) / 2) + 1); // matches oled_slide_in_text step of 2px
-        if (slide_frames < 2) slide_frames = 2;
-        uint16_t travel_frames = slide_frames / 2; // two end-to-end travels during the slide
-        if (travel_frames == 0) travel_frames = 1;
-
-        uint8_t title_y = (OLED_HEIGHT - 8) / 2; // center the 8px font vertically
-        led_bounce_state_t bounce = {.last_pos = 0, .frame_idx = 0, .frames_per_travel = travel_frames};
-        oled_slide_in_text_hook(title, title_y, 12,
-                                startup_led_bounce_step, &bounce);
-        // Clear LEDs before handing control to the normal update loop
-        for (uint8_t i = 0; i < NUM_LEDS; i++) {
-            put_pixel(rgb_to_grb(0, 0, 0));
-        }
-        sleep_ms(400); // let the title sit briefly before normal UI resumes
+    uint32_t wake_count = 0;           // display wake sources seen
+    uint32_t tick_ms = TICK_MS;
+    imu_power_mode_t last_power_mode = imu_ok ? imu_get_power_mode() : IMU_POWER_ACTIVE;
+    workout_t workout = { .running = true };   // counting from boot
+
+    // The calorie rate is resolved from the profile here and on config
+    // edits, never per step
+    calories_t cal = {0};
+    calorie_model_init(0, flash_log_time_s(to_ms_since_boot(get_absolute_time())));
+    apply_config(&cal, imu_ok);
+    if (restored && imu_ok) {
+        calories_restore(&cal, restore_steps, restore_calories);
     }
 
+    ui_state_t ui = {0};
+    ui.imu_ok = imu_ok;
+    ui.soc = battery->soc;
+    ui.battery_percent = battery->percent;
+    ui_state_publish(&ui);
+
+    // UI runs on core 1 from here on (including the startup animation on a
+    // cold boot), so steps are counted while the title slides in
+    multicore_launch_core1(ui_core1_main);
+
+    boot_watchdog_start();
+    LOG_I("Main loop %lu ms after reset", to_ms_since_boot(get_absolute_time()));
+
     while (true) {
+        // Sleep until the IMU, a button or the tick needs attention
+        uint32_t events = events_wait();
+        uint32_t pass_start = prof_begin();
+        boot_watchdog_feed();
         uint32_t now_ms = to_ms_since_boot(get_absolute_time());
 
-        if ((now_ms - last_imu_ms) >= IMU_SAMPLE_MS) {
+        // INT1 is level-high while the FIFO sits above the watermark, so the
+        // fallback drain also recovers from an edge that was missed at boot.
+        if ((events & EVENT_IMU) || (now_ms - last_imu_ms) >= IMU_SAMPLE_MS) {
             last_imu_ms = now_ms;
+            // Idle and dormant stretch the gaps on purpose (power.c)
+            if (power_get_state() == POWER_ACTIVE) prof_deadline(now_ms, IMU_DEADLINE_MS(tick_ms));
             if (imu_ok) {
+                uint32_t t = prof_begin();
                 imu_update(now_ms);
+                prof_end(PROF_ZONE_IMU_UPDATE, t);
+            }
+            // The FIFO was just emptied, so a flash stall now has its
+            // whole depth to spare before samples are lost
+            uint32_t t = prof_begin();
+            flash_log_service();
+            prof_end(PROF_ZONE_FLASH_LOG, t);
+        }
+
+        // On ALRT or the fallback poll only, so most passes skip the bus
+        {
+            uint32_t t = prof_begin();
+            if (battery_service(events, now_ms)) {
+                LOG_D("battery: %u%% (%lu gauge transfers)", battery->percent, max17048_get_xfers());
             }
+            prof_end(PROF_ZONE_BATTERY, t);
         }
 
-        if ((now_ms - last_battery_ms) >= BATTERY_SAMPLE_MS) {
-            last_battery_ms = now_ms;
-            float soc_read = read_soc();
-            if (soc_read >= 0.0f) {
-                soc = soc_read;
-                battery_percent = clamp_percent(soc);
+        // Config edits from the host, received by core 1
+        telemetry_cmd_t cmd;
+        while (telemetry_poll_command(&cmd)) {
+            if (config_handle_command(cmd.type, cmd.payload, cmd.len)) {
+                apply_config(&cal, imu_ok);
             }
         }
 
         uint32_t total_steps = imu_ok ? imu_get_total_steps() : 0;
 
-        // Handle mode button (GPIO 26): toggle between steps and calories
-        bool mode_level = gpio_get(BUTTON_MODE_PIN);  // 1 = released, 0 = pressed (active-low)
-        if (!mode_level && last_mode_level &&
-            (now_ms - last_mode_toggle_ms) > 200) {   // simple debounce
-            show_calories = !show_calories;
-            last_mode_toggle_ms = now_ms;
-            printf("Mode button pressed -> display %s\n",
-                   show_calories ? "CALORIES" : "STEPS");
+        // Debounced gestures from the button interrupts. A press while the
+        // display is asleep only wakes it. MODE toggles steps/calories,
+        // START drives the workout.
+        button_event_t be;
+        while (buttons_read(&be)) {
+            wake_count++;
+            if (!ui_display_awake()) continue;
+            if (be.button == BUTTON_MODE && be.gesture == BUTTON_PRESS) {
+                show_calories = !show_calories;
+            } else if (be.button == BUTTON_START) {
+                workout_button(&workout, (button_gesture_t)be.gesture, total_steps);
+                // A new workout starts its calories from zero with its steps
+                if (be.gesture == BUTTON_LONG_PRESS) calories_restore(&cal, 0, 0);
+            }
         }
-        last_mode_level = mode_level;
-
-        // Auto-run: always count steps from boot; ignore start/pause button for now
-        (void)last_start_level;
-        (void)last_start_toggle_ms;
-        (void)workout_started;
-        (void)workout_running;
-
-        if (total_steps >= workout_offset) {
-            workout_steps = total_steps - workout_offset;
-        } else {
-            workout_steps = 0;
-            workout_offset = total_steps;
+
+        // The IMU's wake-up interrupt (movement after it dropped to low
+        // power) wakes the display too
+        if (imu_ok) {
+            imu_power_mode_t power_mode = imu_get_power_mode();
+            if (last_power_mode == IMU_POWER_LOW && power_mode != IMU_POWER_LOW) wake_count++;
+            last_power_mode = power_mode;
         }
 
-        uint32_t calories = steps_to_calories(workout_steps, USER_WEIGHT_LBS, USER_HEIGHT_CATEGORY);
+        // Calories follow the workout's step events (cadence and intensity),
+        // so a pass without new steps costs nothing. Steps taken while paused
+        // are drained and dropped, as they are from the workout count.
+        step_event_t step_events[8];
+        size_t n_events;
+        while ((n_events = imu_read_step_events(step_events, sizeof(step_events) / sizeof(step_events[0]))) > 0) {
+            if (!workout.running) continue;
+            for (size_t i = 0; i < n_events; i++) {
+                calories_step(&cal, &step_events[i]);
+            }
+        }
+        uint32_t calories = calories_get(&cal);
+        if (imu_ok) {
+            boot_save(total_steps, calories);
+        }
+        if (calorie_model_update(flash_log_time_s(now_ms))) {
+            LOG_D("calorie model: %lu kcal today (%lu active min)",
+                  calorie_model_today(), calorie_model_active_minutes());
+        }
 
-        if (workout_steps != prev_steps) {
-            printf("STEP %lu @ %lums\n", workout_steps, now_ms);
-            prev_steps = workout_steps;
-            step_flash_until_ms = now_ms + 180; // brief border flash
+        // Staging is RAM-only; the page goes to flash from the IMU pass above
+        if ((now_ms - last_log_ms) >= FLASH_LOG_INTERVAL_MS) {
+            last_log_ms = now_ms;
+            flash_log_entry_t entry = {
+                .time_s = flash_log_time_s(now_ms),
+                .steps = total_steps,
+                .calories = calories > UINT16_MAX ? UINT16_MAX : (uint16_t)calories,
+                .battery = battery->percent,
+            };
+            flash_log_append(&entry);
         }
 
-        if ((now_ms - last_diag_ms) >= DIAG_INTERVAL_MS) {
-            last_diag_ms = now_ms;
-            int16_t ax = 0, ay = 0, az = 0;
-            float fax = 0.0f, fay = 0.0f, faz = 0.0f;
-            float mag = 0.0f;
+        ui.steps = workout_steps(&workout, total_steps);
+        ui.calories = calories;
+        ui.soc = battery->soc;
+        ui.battery_percent = battery->percent;
+        ui.show_calories = show_calories;
+        ui.paused = !workout.running;
+        ui.wake_count = wake_count;
+        if (imu_ok) {
+            imu_get_accel_raw(&ui.accel_raw[0], &ui.accel_raw[1], &ui.accel_raw[2]);
+            imu_get_accel_filtered(&ui.accel_g[0], &ui.accel_g[1], &ui.accel_g[2]);
+            ui.imu_odr_hz = imu_get_odr_hz();
+        }
+        ui_state_publish(&ui);
 
-            if (imu_ok) {
-                imu_get_accel_raw(&ax, &ay, &az);
-                imu_get_accel_filtered(&fax, &fay, &faz);
-                mag = sqrtf(fax * fax + fay * fay + faz * faz);
-                printf("diag t=%lums raw=(%6d,%6d,%6d) g=(%.3f,%.3f,%.3f) |g|=%.3f steps=%lu batt=%u%%\n",
-                       now_ms, ax, ay, az, fax, fay, faz, mag, workout_steps, battery_percent);
-            } else {
-                printf("diag t=%lums IMU not initialized, steps=%lu batt=%u%%\n",
-                       now_ms, workout_steps, battery_percent);
-            }
+        if ((now_ms - last_state_ms) >= TELEMETRY_STATE_MS) {
+            last_state_ms = now_ms;
+            send_state_telemetry(&ui, now_ms);
         }
+        prof_end(PROF_ZONE_CORE0_PASS, pass_start);
 
-        update_led_bar(workout_steps, battery_percent, now_ms);
+        if ((now_ms - last_prof_ms) >= PROF_REPORT_MS) {
+            last_prof_ms = now_ms;
+            prof_report();
+        }
+        if ((now_ms - last_power_ms) >= POWER_REPORT_MS) {
+            last_power_ms = now_ms;
+            power_report();
+        }
 
-        if ((now_ms - last_display_ms) >= DISPLAY_REFRESH_MS) {
-            last_display_ms = now_ms;
-            bool paused = false; // always running in auto mode
-            render_oled(workout_steps, calories, battery_percent, show_calories, paused, now_ms,
-                        step_flash_until_ms);
-            printf("steps=%lu cal=%lu soc=%.1f%% %s\n",
-                   workout_steps, calories, soc, paused ? "[PAUSED]" : "");
+        // With the display asleep nothing needs publishing every 100 ms;
+        // buttons and INT1 still wake the loop at once
+        uint32_t want_tick_ms = ui_display_awake() ? TICK_MS : TICK_IDLE_MS;
+        if (want_tick_ms != tick_ms) {
+            tick_ms = want_tick_ms;
+            events_set_tick(tick_ms);
+            prof_deadline_skip();   // the gap in progress was timed on the old tick
         }
 
-        sleep_ms(5);
+        // Park core 1 / slow down / go dormant once there's nothing to do
+        power_service(now_ms, imu_ok, wake_count);
     }
 }
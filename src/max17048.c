@@ -1,10 +1,10 @@
+#include "max17048.h"
+
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "i2c_bus.h"
 #include <stdio.h>
 
-#define I2C_PORT       i2c1
-#define I2C_SDA_PIN    10    
-#define I2C_SCL_PIN    11
+// Shares i2c1 with the IMU and OLED through the bus manager (see i2c_bus.h)
 #define MAX1704X_ADDR  0x36 // Equal to 54 in base 10
 
 // Page 7 (Registers)
@@ -14,33 +14,42 @@
 #define REG_MODE_MSB    0x06
 #define REG_VERSION_MSB 0x08
 #define REG_CONFIG_MSB  0x0C
+#define REG_STATUS_MSB  0x1A
 #define REG_COMMAND_MSB 0xFE
 
 // TODO: FINISH THIS
 #define QUICKSTART_VALUE 0x4000
 #define POWERONRST_VALUE 0x5400
 
+// CONFIG: RCOMP in the MSB (left at the POR value), alert control in the LSB
+#define CONFIG_RCOMP_DEFAULT 0x9700
+#define CONFIG_ALSC      (1u << 6)   // alert on 1 % SOC change
+#define CONFIG_ALRT      (1u << 5)   // alert asserted; write 0 to clear
+#define CONFIG_ATHD_MASK 0x1F        // empty threshold = 32 - ATHD %
+
+// STATUS flags live in the MSB
+#define STATUS_ALERT_MASK (MAX17048_STATUS_RI | MAX17048_STATUS_VH | MAX17048_STATUS_VL | \
+                           MAX17048_STATUS_VR | MAX17048_STATUS_HD | MAX17048_STATUS_SC)
+
+static uint16_t s_config = CONFIG_RCOMP_DEFAULT | 0x1C;   // POR value
+static uint32_t s_xfers;
+
 int i2c_read16(uint8_t reg_msb, uint16_t *out) {
-    uint8_t reg = reg_msb; // copy so we dont overwrite argument
-    if (i2c_write_blocking(I2C_PORT, MAX1704X_ADDR, &reg, 1, true) != 1) {
-        return -1; // -1 == error 
-    }
     uint8_t buf[2] = {0};
-    int bytes_read = i2c_read_blocking(I2C_PORT, MAX1704X_ADDR, buf, 2, false);
-    if (bytes_read != 2) {
-        return -1;
+    s_xfers++;
+    if (i2c_bus_xfer(I2C_DEV_FUEL_GAUGE, MAX1704X_ADDR, reg_msb, NULL, 0, buf, 2) != 0) {
+        return -1; // -1 == error 
     }
     *out = ((uint16_t)buf[0] << 8) | buf[1];
     return 0; // zero == good
 }
 
 int i2c_write16(uint8_t reg_msb, uint16_t val) {
-    uint8_t to_write[3];
-    to_write[0] = reg_msb;
-    to_write[1] = (uint8_t)(val >> 8);   // MSB
-    to_write[2] = (uint8_t)(val & 0xFF); // LSB
-    int bytes_written = i2c_write_blocking(I2C_PORT, MAX1704X_ADDR, to_write, 3, false);
-    return (bytes_written == 3) ? 0 : -1;
+    uint8_t to_write[2];
+    to_write[0] = (uint8_t)(val >> 8);   // MSB
+    to_write[1] = (uint8_t)(val & 0xFF); // LSB
+    s_xfers++;
+    return i2c_bus_xfer(I2C_DEV_FUEL_GAUGE, MAX1704X_ADDR, reg_msb, to_write, 2, NULL, 0);
 }
 
 float read_voltage() {
@@ -72,4 +81,58 @@ int power_on_reset() {
     return i2c_write16(REG_COMMAND_MSB, POWERONRST_VALUE);
 }
 
+// ==============================
+//  Alert-driven reads
+// ==============================
+
+int max17048_read(max17048_reading_t *out) {
+    uint8_t buf[4] = {0};
+    s_xfers++;
+    if (i2c_bus_xfer(I2C_DEV_FUEL_GAUGE, MAX1704X_ADDR, REG_VCELL_MSB, NULL, 0, buf, 4) != 0) {
+        return -1;
+    }
+    uint16_t raw_vcell = ((uint16_t)buf[0] << 8) | buf[1];
+    uint16_t raw_soc = ((uint16_t)buf[2] << 8) | buf[3];
+    out->voltage = (raw_vcell >> 4) * 0.00125f;
+    out->soc = raw_soc / 256.0f;
+    return 0;
+}
+
+int max17048_config_alerts(uint8_t empty_percent) {
+    if (empty_percent < 1) empty_percent = 1;
+    if (empty_percent > 32) empty_percent = 32;
+    uint16_t rcomp = 0;
+    if (i2c_read16(REG_CONFIG_MSB, &rcomp) != 0) {
+        return -1;
+    }
+    // Keep RCOMP and SLEEP as they are; ALRT written as 0 clears it
+    s_config = (rcomp & 0xFF80u) | CONFIG_ALSC | ((32u - empty_percent) & CONFIG_ATHD_MASK);
+    if (i2c_write16(REG_CONFIG_MSB, s_config) != 0) {
+        return -1;
+    }
+    return max17048_clear_alerts();
+}
+
+int max17048_read_status(uint16_t *status) {
+    uint16_t raw = 0;
+    if (i2c_read16(REG_STATUS_MSB, &raw) != 0) {
+        return -1;
+    }
+    *status = raw & STATUS_ALERT_MASK;
+    return 0;
+}
+
+int max17048_clear_alerts(void) {
+    // Flags clear by writing 0; EnVR (bit 14) is kept off
+    if (i2c_write16(REG_STATUS_MSB, 0) != 0) {
+        return -1;
+    }
+    // The pin stays low until CONFIG.ALRT is cleared too
+    return i2c_write16(REG_CONFIG_MSB, s_config);
+}
+
+uint32_t max17048_get_xfers(void) {
+    return s_xfers;
+}
+
 // no main()
@@ -0,0 +1,48 @@
+#ifndef MAX17048_H
+#define MAX17048_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  MAX17048 fuel gauge (i2c1, shared through i2c_bus)
+// ==============================
+
+// STATUS register alert flags (MSB), see max17048_read_status()
+#define MAX17048_STATUS_RI   (1u << 8)    // reset indicator (power-up)
+#define MAX17048_STATUS_VH   (1u << 9)    // voltage high
+#define MAX17048_STATUS_VL   (1u << 10)   // voltage low
+#define MAX17048_STATUS_VR   (1u << 11)   // voltage reset
+#define MAX17048_STATUS_HD   (1u << 12)   // SOC fell below the empty threshold
+#define MAX17048_STATUS_SC   (1u << 13)   // SOC changed by 1 %
+
+typedef struct {
+    float voltage;   // cell voltage (V)
+    float soc;       // state of charge (%)
+} max17048_reading_t;
+
+// One register each (kept for bring-up and the bench)
+float read_voltage(void);
+float read_soc(void);
+int quickstart(void);
+int power_on_reset(void);
+
+// VCELL and SOC in one 4-byte burst (the registers are adjacent).
+// Returns 0 on success.
+int max17048_read(max17048_reading_t *out);
+
+// Enable the ALRT pin for every 1 % SOC change (ALSC) and for SOC falling
+// below empty_percent (1-32). Also clears any pending alert.
+int max17048_config_alerts(uint8_t empty_percent);
+
+// Pending alert flags (MAX17048_STATUS_*); returns 0 on success
+int max17048_read_status(uint16_t *status);
+
+// Clear every STATUS flag and the CONFIG.ALRT bit, releasing the pin. Read
+// the gauge after this, so a change that lands in between raises a new alert.
+int max17048_clear_alerts(void);
+
+// Bus transactions to the gauge since boot
+uint32_t max17048_get_xfers(void);
+
+#endif // MAX17048_H
@@ -7,15 +7,15 @@
 
 #include "oled.h"
 #include "font5x7.h"
+#include "anim.h"
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "i2c_bus.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
 
-#define OLED_I2C_PORT   i2c1
-#define OLED_I2C_SDA    14
-#define OLED_I2C_SCL    15
+// Shares i2c1 with the IMU and fuel gauge; pushes are the lowest-priority
+// traffic on the bus (see i2c_bus.h)
 #define SSD1306_ADDR    0x3C    // Common address; some displays use 0x3D
 
 #define SSD1306_CMD     0x00    // I2C control byte: next byte is a command
@@ -41,13 +41,265 @@
 #define SSD1306_SEG_REMAP           0xA0
 #define SSD1306_COM_SCAN_DEC        0xC8
 #define SSD1306_DISPLAY_ALL_ON_RES  0xA4
+#define SSD1306_NOP                 0xE3
 
-#define BUFFER_SIZE ((OLED_WIDTH * OLED_HEIGHT) / 8)
+// Longest the panel takes to answer after power-up
+#define OLED_BOOT_TIMEOUT_MS        100
 
-static uint8_t s_buffer[BUFFER_SIZE];
+#define BUFFER_SIZE ((OLED_WIDTH * OLED_HEIGHT) / 8)
+#define OLED_PAGES  (OLED_HEIGHT / 8)
+
+// Command stream that sets a column/page draw window
+#define WINDOW_CMD_LEN  6
+
+// Diff runs closer than this are merged: a new window costs the 6 command
+// bytes, two control bytes and two extra address bytes on the wire.
+#define OLED_DIFF_MERGE_GAP     10
+#define OLED_MAX_RUNS_PER_PAGE  4
+#define OLED_MAX_WINDOWS        (OLED_PAGES * OLED_MAX_RUNS_PER_PAGE)
+
+// Back buffer (what gets drawn into), word aligned for the diff
+static uint8_t s_buffer[BUFFER_SIZE] __attribute__((aligned(4)));
+
+// Front buffer: what the panel is currently showing
+static uint8_t s_front[BUFFER_SIZE] __attribute__((aligned(4)));
+static bool s_front_valid = false;
+
+// Per-page dirty column span [lo, hi] (lo > hi means clean): columns drawn
+// to since the last push. The used span may hold lit pixels since the last
+// clear; the stale span is what clears have blanked since the last push.
+// Neither a clear nor drawing is final until the push, which trims both to
+// where the page really differs from the panel, so homing and redrawing the
+// same thing leaves the page clean.
+static uint8_t s_dirty_lo[OLED_PAGES];
+static uint8_t s_dirty_hi[OLED_PAGES];
+static uint8_t s_used_lo[OLED_PAGES];
+static uint8_t s_used_hi[OLED_PAGES];
+static uint8_t s_stale_lo[OLED_PAGES];
+static uint8_t s_stale_hi[OLED_PAGES];
+
+// One column window on one page that needs to be sent
+typedef struct {
+    uint8_t page;
+    uint8_t lo;
+    uint8_t hi;
+} oled_window_t;
+
+// In-flight push: a command and a data transaction per window. Drawing
+// into s_buffer can continue while they run.
+static i2c_txn_t s_txns[OLED_MAX_WINDOWS * 2];
+static uint8_t s_win_cmds[OLED_MAX_WINDOWS][WINDOW_CMD_LEN];
+static uint8_t s_txn_count = 0;
+static uint32_t s_push_failures = 0;
 static uint8_t s_cursor_x = 0;
 static uint8_t s_cursor_y = 0;
 
+// Battery icon breathing phase
+#define OLED_BATTERY_BREATH_MS  1200
+static anim_phase_t s_battery_phase;
+
+// ==============================
+//  Dirty-region tracking
+// ==============================
+
+static inline void oled_mark_dirty(uint8_t page, uint8_t x0, uint8_t x1)
+{
+    if (x0 < s_dirty_lo[page]) s_dirty_lo[page] = x0;
+    if (x1 > s_dirty_hi[page]) s_dirty_hi[page] = x1;
+}
+
+static inline void oled_mark_used(uint8_t page, uint8_t x0, uint8_t x1)
+{
+    if (x0 < s_used_lo[page]) s_used_lo[page] = x0;
+    if (x1 > s_used_hi[page]) s_used_hi[page] = x1;
+}
+
+static void oled_mark_all_clean(void)
+{
+    for (uint8_t p = 0; p < OLED_PAGES; p++) {
+        s_dirty_lo[p] = 0xFF;
+        s_dirty_hi[p] = 0;
+        s_stale_lo[p] = 0xFF;
+        s_stale_hi[p] = 0;
+    }
+}
+
+// Blank the framebuffer; only columns that held pixels become stale
+static void oled_clear_buffer(void)
+{
+    for (uint8_t p = 0; p < OLED_PAGES; p++) {
+        if (s_used_lo[p] <= s_used_hi[p]) {
+            if (s_used_lo[p] < s_stale_lo[p]) s_stale_lo[p] = s_used_lo[p];
+            if (s_used_hi[p] > s_stale_hi[p]) s_stale_hi[p] = s_used_hi[p];
+            memset(&s_buffer[p * OLED_WIDTH + s_used_lo[p]], 0,
+                   s_used_hi[p] - s_used_lo[p] + 1);
+        }
+        s_used_lo[p] = 0xFF;
+        s_used_hi[p] = 0;
+    }
+}
+
+// Fold the page's stale span into its dirty span, then trim that from both
+// ends (a word at a time) to the first and last words that differ from the
+// panel. Returns false if the page turns out to match it.
+static bool oled_trim_dirty(uint8_t page)
+{
+    if (s_stale_lo[page] <= s_stale_hi[page]) {
+        oled_mark_dirty(page, s_stale_lo[page], s_stale_hi[page]);
+    }
+    if (s_dirty_lo[page] > s_dirty_hi[page]) return false;
+
+    const uint32_t *back = (const uint32_t *)&s_buffer[page * OLED_WIDTH];
+    const uint32_t *front = (const uint32_t *)&s_front[page * OLED_WIDTH];
+    uint8_t lo = s_dirty_lo[page] / 4;
+    uint8_t hi = s_dirty_hi[page] / 4;
+    while (lo <= hi && back[lo] == front[lo]) lo++;
+    if (lo > hi) return false;
+    while (back[hi] == front[hi]) hi--;   // stops at lo at the latest
+    s_dirty_lo[page] = (uint8_t)(lo * 4);
+    s_dirty_hi[page] = (uint8_t)(hi * 4 + 3);
+    return true;
+}
+
+// Append the run [lo, hi] to the window list, folding it into the page's
+// last window once the per-page budget is used up
+static void oled_emit_run(oled_window_t *out, uint8_t *n, uint8_t page_first,
+                          uint8_t page, uint8_t lo, uint8_t hi)
+{
+    if (*n - page_first >= OLED_MAX_RUNS_PER_PAGE) {
+        out[*n - 1].hi = hi;
+        return;
+    }
+    out[*n].page = page;
+    out[*n].lo = lo;
+    out[*n].hi = hi;
+    (*n)++;
+}
+
+// Compare back and front buffers a word at a time within the page's dirty
+// span and append a window for each run of differing bytes
+static void oled_diff_page(uint8_t page, oled_window_t *out, uint8_t *n)
+{
+    const uint32_t *back = (const uint32_t *)&s_buffer[page * OLED_WIDTH];
+    const uint32_t *front = (const uint32_t *)&s_front[page * OLED_WIDTH];
+    uint8_t first = *n;
+    int16_t run_lo = -1;
+    int16_t run_hi = -1;
+
+    for (uint8_t w = s_dirty_lo[page] / 4; w <= s_dirty_hi[page] / 4; w++) {
+        uint32_t diff = back[w] ^ front[w];
+        if (diff == 0) continue;
+
+        // Little-endian: byte k of the word is column 4*w + k
+        for (uint8_t k = 0; k < 4; k++, diff >>= 8) {
+            if ((diff & 0xFF) == 0) continue;
+            int16_t col = (int16_t)(w * 4 + k);
+            if (run_lo >= 0 && (col - run_hi) <= OLED_DIFF_MERGE_GAP) {
+                run_hi = col;
+            } else {
+                if (run_lo >= 0) {
+                    oled_emit_run(out, n, first, page, (uint8_t)run_lo, (uint8_t)run_hi);
+                }
+                run_lo = run_hi = col;
+            }
+        }
+    }
+    if (run_lo >= 0) {
+        oled_emit_run(out, n, first, page, (uint8_t)run_lo, (uint8_t)run_hi);
+    }
+}
+
+// Work out which windows differ from what the panel shows, update the front
+// buffer to match and mark everything clean.
+// Returns the number of windows written to `out` (at most OLED_MAX_WINDOWS).
+static uint8_t oled_take_windows(oled_window_t *out)
+{
+    uint8_t n = 0;
+
+    if (!s_front_valid) {
+        // Panel contents unknown (power-up or failed push): send everything
+        for (uint8_t p = 0; p < OLED_PAGES; p++) {
+            out[n].page = p;
+            out[n].lo = 0;
+            out[n].hi = OLED_WIDTH - 1;
+            n++;
+        }
+        s_front_valid = true;
+    } else {
+        for (uint8_t p = 0; p < OLED_PAGES; p++) {
+            if (oled_trim_dirty(p)) {
+                oled_diff_page(p, out, &n);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        uint16_t off = out[i].page * OLED_WIDTH + out[i].lo;
+        memcpy(&s_front[off], &s_buffer[off], (size_t)(out[i].hi - out[i].lo) + 1);
+    }
+
+    oled_mark_all_clean();
+    return n;
+}
+
+static void oled_window_cmds(const oled_window_t *win, uint8_t cmds[WINDOW_CMD_LEN])
+{
+    cmds[0] = SSD1306_SET_COL_ADDR;
+    cmds[1] = win->lo;
+    cmds[2] = win->hi;
+    cmds[3] = SSD1306_SET_PAGE_ADDR;
+    cmds[4] = win->page;
+    cmds[5] = win->page;
+}
+
+// ==============================
+//  Byte-oriented blitters
+// ==============================
+//
+// Each buffer byte is a vertical 8-pixel strip, so a font column is one
+// byte OR'd into (at most) two pages, and a fill is one mask per page.
+
+// Bit k set -> bits 2k and 2k+1 set (used for 2x glyph scaling)
+static const uint8_t s_nibble_2x[16] = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF,
+};
+
+// OR a vertical strip of pixels (bit 0 = row y) into column x
+static void oled_blit_column(int16_t x, int16_t y, uint32_t bits)
+{
+    if (x < 0 || x >= OLED_WIDTH || bits == 0) return;
+    if (y < 0) {
+        if (y <= -32) return;
+        bits >>= -y;
+        y = 0;
+    }
+    if (y >= OLED_HEIGHT) return;
+
+    uint8_t page = (uint8_t)(y / 8);
+    bits <<= (y & 7);
+    for (; bits != 0 && page < OLED_PAGES; page++, bits >>= 8) {
+        uint8_t b = (uint8_t)bits;
+        if (b == 0) continue;
+        uint8_t *dst = &s_buffer[page * OLED_WIDTH + x];
+        if ((*dst | b) != *dst) {
+            *dst |= b;
+            oled_mark_dirty(page, (uint8_t)x, (uint8_t)x);
+        }
+        oled_mark_used(page, (uint8_t)x, (uint8_t)x);
+    }
+}
+
+// Draw one 5x7 glyph with its top-left pixel at (x, y)
+static void oled_blit_glyph(int16_t x, int16_t y, char c)
+{
+    if (c < 32 || c > 126) c = ' ';
+    const uint8_t *glyph = font5x7[c - FONT_FIRST_CHAR];
+    for (uint8_t col = 0; col < FONT_WIDTH; col++) {
+        oled_blit_column(x + col, y, glyph[col]);
+    }
+}
+
 // Return pixel width of a string using the 5x7 font with 1px spacing
 static uint16_t oled_text_width_px(const char *str)
 {
@@ -61,17 +313,7 @@ static uint16_t oled_text_width_px(const char *str)
 // Draw a single character at an explicit position without touching the global cursor
 static void oled_draw_char_at(int16_t x, int16_t y, char c)
 {
-    if (c < 32 || c > 126) c = ' ';
-    uint8_t idx = c - FONT_FIRST_CHAR;
-
-    for (uint8_t col = 0; col < FONT_WIDTH; col++) {
-        uint8_t line = font5x7[idx][col];
-        for (uint8_t row = 0; row < FONT_HEIGHT; row++) {
-            if (line & (1 << row)) {
-                oled_set_pixel(x + col, y + row, 1);
-            }
-        }
-    }
+    oled_blit_glyph(x, y, c);
 }
 
 // Draw text on a single line without wrapping; pixels outside the display are clipped
@@ -84,29 +326,38 @@ static void oled_draw_text_single_line(int16_t x, int16_t y, const char *text)
     }
 }
 
-static void oled_send_cmd(uint8_t cmd)
+static void oled_wait_idle(void)
 {
-    uint8_t buf[2] = {SSD1306_CMD, cmd};
-    i2c_write_blocking(OLED_I2C_PORT, SSD1306_ADDR, buf, 2, false);
+    while (oled_display_busy()) {
+        tight_loop_contents();
+    }
 }
 
-static void oled_send_data(const uint8_t *data, size_t len)
+static void oled_send_cmds(const uint8_t *cmds, size_t len)
 {
-    uint8_t buf[129];
-    buf[0] = SSD1306_DATA;
-    
-    size_t offset = 0;
-    while (offset < len) {
-        size_t chunk = (len - offset > 128) ? 128 : (len - offset);
-        memcpy(buf + 1, data + offset, chunk);
-        i2c_write_blocking(OLED_I2C_PORT, SSD1306_ADDR, buf, chunk + 1, false);
-        offset += chunk;
-    }
+    oled_wait_idle();
+    i2c_bus_xfer(I2C_DEV_OLED, SSD1306_ADDR, SSD1306_CMD, cmds, len, NULL, 0);
+}
+
+static void oled_send_cmd(uint8_t cmd)
+{
+    oled_send_cmds(&cmd, 1);
 }
 
 bool oled_init(void)
 {
-    sleep_ms(100);  // Allow display power-up
+    // Wait for the controller to ack instead of a fixed power-up delay; a
+    // panel that stayed powered (warm reset) answers straight away
+    static const uint8_t nop = SSD1306_NOP;
+    absolute_time_t deadline = make_timeout_time_ms(OLED_BOOT_TIMEOUT_MS);
+    while (i2c_bus_xfer(I2C_DEV_OLED, SSD1306_ADDR, SSD1306_CMD, &nop, 1, NULL, 0) != 0) {
+        if (time_reached(deadline)) return false;
+    }
+    oled_mark_all_clean();
+    for (uint8_t p = 0; p < OLED_PAGES; p++) {
+        s_used_lo[p] = 0xFF;
+        s_used_hi[p] = 0;
+    }
     
     // Initialization sequence configures: display off, clock, multiplexing,
     // memory addressing mode, segment remapping, COM scan direction, 
@@ -130,30 +381,83 @@ bool oled_init(void)
         SSD1306_DISPLAY_ON,
     };
     
-    for (size_t i = 0; i < sizeof(init_cmds); i++) {
-        oled_send_cmd(init_cmds[i]);
-    }
+    // One command stream (Co = 0), so the whole sequence is one transaction
+    oled_send_cmds(init_cmds, sizeof(init_cmds));
     
-    oled_clear();
+    // GDDRAM content is random after power-up, so push every column once
+    memset(s_buffer, 0, BUFFER_SIZE);
+    s_front_valid = false;
+    oled_display();
     return true;
 }
 
 void oled_clear(void)
 {
-    memset(s_buffer, 0, BUFFER_SIZE);
+    oled_clear_buffer();
     oled_display();
 }
 
 void oled_display(void)
 {
-    // Set draw window to entire display, then push framebuffer
-    oled_send_cmd(SSD1306_SET_COL_ADDR);
-    oled_send_cmd(0);
-    oled_send_cmd(OLED_WIDTH - 1);
-    oled_send_cmd(SSD1306_SET_PAGE_ADDR);
-    oled_send_cmd(0);
-    oled_send_cmd((OLED_HEIGHT / 8) - 1);
-    oled_send_data(s_buffer, BUFFER_SIZE);
+    if (oled_display_async()) {
+        oled_wait_idle();
+    }
+}
+
+bool oled_display_async(void)
+{
+    if (oled_display_busy()) return false;
+
+    oled_window_t wins[OLED_MAX_WINDOWS];
+    uint8_t n = oled_take_windows(wins);
+    if (n == 0) return true; // nothing changed
+
+    // Two transactions per window: the window commands, then its data,
+    // sent straight out of s_front (which can't change until they finish).
+    // They queue behind IMU and fuel-gauge traffic.
+    s_txn_count = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        oled_window_cmds(&wins[i], s_win_cmds[i]);
+
+        i2c_txn_t *cmd = &s_txns[s_txn_count++];
+        *cmd = (i2c_txn_t){
+            .dev = I2C_DEV_OLED, .addr = SSD1306_ADDR, .reg = SSD1306_CMD,
+            .tx = s_win_cmds[i], .tx_len = WINDOW_CMD_LEN,
+        };
+        i2c_bus_submit(cmd);
+
+        i2c_txn_t *data = &s_txns[s_txn_count++];
+        *data = (i2c_txn_t){
+            .dev = I2C_DEV_OLED, .addr = SSD1306_ADDR, .reg = SSD1306_DATA,
+            .tx = &s_front[wins[i].page * OLED_WIDTH + wins[i].lo],
+            .tx_len = (uint16_t)(wins[i].hi - wins[i].lo + 1),
+        };
+        i2c_bus_submit(data);
+    }
+    return true;
+}
+
+bool oled_display_busy(void)
+{
+    if (s_txn_count == 0) return false;
+
+    bool failed = false;
+    for (uint8_t i = 0; i < s_txn_count; i++) {
+        if (i2c_bus_txn_busy(&s_txns[i])) return true;
+        if (s_txns[i].status == I2C_TXN_ERROR) failed = true;
+    }
+
+    if (failed) {
+        s_push_failures++;
+        s_front_valid = false; // panel state unknown, resend all
+    }
+    s_txn_count = 0;
+    return false;
+}
+
+uint32_t oled_display_abort_count(void)
+{
+    return s_push_failures;
 }
 
 void oled_set_pixel(int16_t x, int16_t y, uint8_t color)
@@ -161,11 +465,17 @@ void oled_set_pixel(int16_t x, int16_t y, uint8_t color)
     if (x < 0 || x >= OLED_WIDTH || y < 0 || y >= OLED_HEIGHT) return;
     
     // Buffer is organized in 8 horizontal pages; each byte is a vertical 8-pixel strip
-    uint16_t idx = x + (y / 8) * OLED_WIDTH;
+    uint8_t page = (uint8_t)(y / 8);
+    uint16_t idx = x + page * OLED_WIDTH;
     uint8_t bit = 1 << (y & 7);
-    
-    if (color) s_buffer[idx] |= bit;
-    else       s_buffer[idx] &= ~bit;
+    uint8_t old = s_buffer[idx];
+    uint8_t val = color ? (old | bit) : (old & ~bit);
+
+    if (val != old) {
+        s_buffer[idx] = val;
+        oled_mark_dirty(page, (uint8_t)x, (uint8_t)x);
+        if (color) oled_mark_used(page, (uint8_t)x, (uint8_t)x);
+    }
 }
 
 void oled_set_cursor(uint8_t x, uint8_t y)
@@ -182,18 +492,8 @@ void oled_write_char(char c)
         return;
     }
     
-    if (c < 32 || c > 126) c = ' ';
-    uint8_t idx = c - FONT_FIRST_CHAR;
-    
     // Draw each column of the character glyph
-    for (uint8_t col = 0; col < FONT_WIDTH; col++) {
-        uint8_t line = font5x7[idx][col];
-        for (uint8_t row = 0; row < FONT_HEIGHT; row++) {
-            if (line & (1 << row)) {
-                oled_set_pixel(s_cursor_x + col, s_cursor_y + row, 1);
-            }
-        }
-    }
+    oled_blit_glyph(s_cursor_x, s_cursor_y, c);
     
     s_cursor_x += FONT_WIDTH + 1;  // Advance cursor with 1px spacing
     if (s_cursor_x + FONT_WIDTH > OLED_WIDTH) {
@@ -226,7 +526,7 @@ void oled_slide_in_text_hook(const char *text, uint8_t y, uint8_t frame_delay_ms
     }
 
     for (int16_t x = start_x; x >= target_x; x -= 2) {
-        memset(s_buffer, 0, BUFFER_SIZE);
+        oled_clear_buffer();
         oled_draw_text_single_line(x, y, text);
         oled_display();
         if (hook) hook(ctx, x);
@@ -234,7 +534,7 @@ void oled_slide_in_text_hook(const char *text, uint8_t y, uint8_t frame_delay_ms
     }
 
     // Ensure the message ends crisply at the final position
-    memset(s_buffer, 0, BUFFER_SIZE);
+    oled_clear_buffer();
     oled_draw_text_single_line(target_x, y, text);
     oled_display();
     if (hook) hook(ctx, target_x);
@@ -247,21 +547,41 @@ void oled_slide_in_text(const char *text, uint8_t y, uint8_t frame_delay_ms)
 
 void oled_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color)
 {
-    for (int16_t i = x; i < x + w; i++) {
-        for (int16_t j = y; j < y + h; j++) {
-            oled_set_pixel(i, j, color);
+    // Clip to the display
+    int16_t x0 = (x < 0) ? 0 : x;
+    int16_t x1 = (x + w > OLED_WIDTH) ? OLED_WIDTH : x + w;   // exclusive
+    int16_t y0 = (y < 0) ? 0 : y;
+    int16_t y1 = (y + h > OLED_HEIGHT) ? OLED_HEIGHT : y + h; // exclusive
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // One byte mask per page: partial pages at the top/bottom edge get a
+    // partial mask, every page in between is a whole byte
+    for (uint8_t page = (uint8_t)(y0 / 8); page <= (uint8_t)((y1 - 1) / 8); page++) {
+        int16_t top = page * 8;
+        uint8_t lo_bit = (y0 > top) ? (uint8_t)(y0 - top) : 0;
+        uint8_t hi_bit = (y1 < top + 8) ? (uint8_t)(y1 - top) : 8;       // exclusive
+        uint8_t mask = (uint8_t)((0xFFu << lo_bit) & (0xFFu >> (8 - hi_bit)));
+
+        uint8_t *row = &s_buffer[page * OLED_WIDTH];
+        bool changed = false;
+        for (int16_t i = x0; i < x1; i++) {
+            uint8_t v = color ? (row[i] | mask) : (row[i] & (uint8_t)~mask);
+            changed |= (v != row[i]);
+            row[i] = v;
         }
+        if (changed) oled_mark_dirty(page, (uint8_t)x0, (uint8_t)(x1 - 1));
+        if (color) oled_mark_used(page, (uint8_t)x0, (uint8_t)(x1 - 1));
     }
 }
 
 void oled_draw_hline(int16_t x, int16_t y, int16_t w, uint8_t color)
 {
-    for (int16_t i = x; i < x + w; i++) oled_set_pixel(i, y, color);
+    oled_fill_rect(x, y, w, 1, color);
 }
 
 void oled_draw_vline(int16_t x, int16_t y, int16_t h, uint8_t color)
 {
-    for (int16_t j = y; j < y + h; j++) oled_set_pixel(x, j, color);
+    oled_fill_rect(x, y, 1, h, color);
 }
 
 void oled_invert(bool invert)
@@ -275,6 +595,12 @@ void oled_set_contrast(uint8_t contrast)
     oled_send_cmd(contrast);
 }
 
+void oled_set_power(bool on)
+{
+    // GDDRAM keeps its contents while the panel is off
+    oled_send_cmd(on ? SSD1306_DISPLAY_ON : SSD1306_DISPLAY_OFF);
+}
+
 void oled_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color)
 {
     oled_draw_hline(x, y, w, color);              // Top
@@ -322,8 +648,12 @@ void oled_draw_battery_animated(int16_t x, int16_t y, uint8_t percent, uint32_t
     else if (percent >= 37) base_bars = 2;
     else if (percent >= 12) base_bars = 1;
 
-    // Simple breathe: blink one extra bar if not full; at full, blink the last bar
-    bool blink_on = ((now_ms / 600) & 0x1) == 0;
+    // Simple breathe: blink one extra bar if not full; at full, blink the last bar.
+    // The bar is on for the rising half of the shared breathing curve.
+    if (s_battery_phase.step_per_ms == 0) {
+        anim_phase_init(&s_battery_phase, OLED_BATTERY_BREATH_MS, now_ms);
+    }
+    bool blink_on = anim_breath[anim_phase_advance(&s_battery_phase, now_ms)] >= 128;
     uint8_t bars = base_bars;
     if (base_bars == 0) {
         bars = blink_on ? 1 : 0;
@@ -345,20 +675,15 @@ void oled_draw_battery_animated(int16_t x, int16_t y, uint8_t percent, uint32_t
 static void oled_write_char_2x(uint8_t x, uint8_t y, char c)
 {
     if (c < 32 || c > 126) c = ' ';
-    uint8_t idx = c - FONT_FIRST_CHAR;
+    const uint8_t *glyph = font5x7[c - FONT_FIRST_CHAR];
     
-    // Scale each pixel 2x in both dimensions
+    // Scale 2x in both dimensions: each nibble of a font column doubles
+    // into a byte, and each doubled column is drawn twice
     for (uint8_t col = 0; col < FONT_WIDTH; col++) {
-        uint8_t line = font5x7[idx][col];
-        for (uint8_t row = 0; row < FONT_HEIGHT; row++) {
-            if (line & (1 << row)) {
-                // Draw 2x2 block for each pixel
-                oled_set_pixel(x + col * 2,     y + row * 2,     1);
-                oled_set_pixel(x + col * 2 + 1, y + row * 2,     1);
-                oled_set_pixel(x + col * 2,     y + row * 2 + 1, 1);
-                oled_set_pixel(x + col * 2 + 1, y + row * 2 + 1, 1);
-            }
-        }
+        uint8_t line = glyph[col];
+        uint32_t tall = s_nibble_2x[line & 0x0F] | ((uint32_t)s_nibble_2x[line >> 4] << 8);
+        oled_blit_column(x + col * 2,     y, tall);
+        oled_blit_column(x + col * 2 + 1, y, tall);
     }
 }
 
@@ -440,7 +765,7 @@ void oled_show_calories(uint32_t calories)
 
 void oled_home(void)
 {
-    memset(s_buffer, 0, BUFFER_SIZE);
+    oled_clear_buffer();
     s_cursor_x = 0;
     s_cursor_y = 0;
 }
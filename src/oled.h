@@ -23,9 +23,21 @@ bool oled_init(void);
 // Clear the display buffer and update the screen
 void oled_clear(void);
 
-// Update the display with the current buffer contents
+// Update the display with the current buffer contents (blocking).
+// Only the column span of each page touched since the last push is sent.
 void oled_display(void);
 
+// Queue the current buffer on the shared I2C bus and return immediately.
+// The buffer is snapshotted, so drawing may continue at once.
+// Returns false (and does nothing) if the previous push is still running.
+bool oled_display_async(void);
+
+// True while an async push is still queued or on the bus
+bool oled_display_busy(void);
+
+// Number of pushes that failed on the bus (after the bus manager's retries)
+uint32_t oled_display_abort_count(void);
+
 // Set a single pixel in the buffer
 // x: 0 to OLED_WIDTH-1
 // y: 0 to OLED_HEIGHT-1
@@ -68,6 +80,10 @@ void oled_invert(bool invert);
 // Set display contrast (0-255)
 void oled_set_contrast(uint8_t contrast);
 
+// Turn the panel on or off (sleep). The frame shown before sleeping is
+// still there on wake. Waits for any async push to finish first.
+void oled_set_power(bool on);
+
 // Draw battery icon with 5 states (0%, 25%, 50%, 75%, 100%)
 // x, y: top-left corner position
 // percent: battery level 0-100
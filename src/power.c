@@ -0,0 +1,264 @@
+#include "power.h"
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "pico/runtime_init.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pll.h"
+#include "hardware/powman.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/xosc.h"
+
+#include "boot.h"
+#include "buttons.h"
+#include "config.h"
+#include "i2c_bus.h"
+#include "imu.h"
+#include "log.h"
+#include "prof.h"
+#include "telemetry.h"
+#include "ui.h"
+
+// The LPOSC rate is only re-measured over an awake stretch at least this long
+#define POWER_CAL_MIN_MS  60000u
+
+static power_state_t s_state = POWER_ACTIVE;
+static uint32_t s_state_since_ms;
+static uint32_t s_quiet_since_ms;       // activity level last seen above 0
+static uint32_t s_ms[POWER_STATE_COUNT];
+static uint32_t s_entries[POWER_STATE_COUNT];
+static uint32_t s_imu_int_pin;
+static uint32_t s_wake_count;           // last display wake count seen
+
+// Always-on timer against the system timer: the last point both were read
+// together, and the rate between them (system us per always-on ms)
+static uint64_t s_sync_aon_ms;
+static uint64_t s_sync_us;
+static uint64_t s_cal_us = 1000;
+static uint64_t s_cal_aon_ms = 1;
+
+static void power_enter(power_state_t state, uint32_t now_ms)
+{
+    s_ms[s_state] += now_ms - s_state_since_ms;
+    s_state_since_ms = now_ms;
+    s_state = state;
+    s_entries[state]++;
+    // Deadlines are only kept while active; the gap across a sleep isn't one
+    prof_deadline_skip();
+}
+
+// ==============================
+//  Clocks
+// ==============================
+
+// The I2C dividers and the profiler's cycle rate follow clk_sys. Nothing
+// is on the bus at this point: core 1 is parked and core 0's own transfers
+// are synchronous.
+static void power_clock_low(void)
+{
+    set_sys_clock_48mhz();   // pll_usb, so USB keeps running
+    i2c_bus_clock_changed();
+    prof_clock_changed();
+}
+
+static void power_clock_full(void)
+{
+    set_sys_clock_khz(SYS_CLK_KHZ, true);
+    i2c_bus_clock_changed();
+    prof_clock_changed();
+}
+
+// Everything on the crystal with the PLLs off, so that XOSC going dormant
+// stops every clock
+static void power_clock_xosc(void)
+{
+    clock_configure_undivided(clk_ref, CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC, 0, XOSC_HZ);
+    clock_configure_undivided(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF, 0, XOSC_HZ);
+    clock_stop(clk_usb);
+    clock_stop(clk_adc);
+    clock_configure_undivided(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, XOSC_HZ);
+    pll_deinit(pll_sys);
+    pll_deinit(pll_usb);
+}
+
+// ==============================
+//  Dormant
+// ==============================
+
+static void power_sync_timers(void)
+{
+    s_sync_aon_ms = powman_timer_get_ms();
+    s_sync_us = time_us_64();
+}
+
+// INT1 is latched high by the wake-up engine; buttons are active low.
+// Levels rather than edges, so one that fired just before can't be missed.
+static bool power_wake_pending(void)
+{
+    return gpio_get(s_imu_int_pin) || !gpio_get(BUTTON_MODE_PIN) || !gpio_get(BUTTON_START_PIN);
+}
+
+static void power_set_dormant_wake(bool enable)
+{
+    gpio_set_dormant_irq_enabled(s_imu_int_pin, GPIO_IRQ_LEVEL_HIGH, enable);
+    gpio_set_dormant_irq_enabled(BUTTON_MODE_PIN, GPIO_IRQ_LEVEL_LOW, enable);
+    gpio_set_dormant_irq_enabled(BUTTON_START_PIN, GPIO_IRQ_LEVEL_LOW, enable);
+}
+
+// The system timer stood still with clk_ref; move it on by the time slept.
+// Alarms compare on exact counts, so any that came due in the gap would
+// wait for the counter to wrap: fire them now instead.
+static void power_advance_timer(uint64_t us)
+{
+    uint64_t t = time_us_64() + us;
+    timer_hw->timelw = (uint32_t)t;
+    timer_hw->timehw = (uint32_t)(t >> 32);
+
+    uint32_t armed = timer_hw->armed;
+    for (uint32_t n = 0; n < NUM_ALARMS; n++) {
+        if (armed & (1u << n)) hardware_alarm_force_irq(n);
+    }
+}
+
+// Stop every clock until a wake pin fires. Returns the time slept, in ms
+// (0 if a wake source was already active).
+static uint32_t power_dormant(void)
+{
+    // Interrupts stay off until the clocks and the timer are back
+    uint32_t irq = save_and_disable_interrupts();
+    if (power_wake_pending()) {
+        restore_interrupts(irq);
+        return 0;
+    }
+
+    // Re-measure the LPOSC over the stretch we've just been awake
+    uint64_t aon_ms = powman_timer_get_ms();
+    uint64_t us = time_us_64();
+    if (aon_ms - s_sync_aon_ms >= POWER_CAL_MIN_MS) {
+        s_cal_aon_ms = aon_ms - s_sync_aon_ms;
+        s_cal_us = us - s_sync_us;
+    }
+
+    power_clock_xosc();
+    power_set_dormant_wake(true);
+    xosc_dormant();                      // returns once woken and the crystal is stable
+    power_set_dormant_wake(false);
+    runtime_init_clocks();               // PLLs and clocks as at boot
+    i2c_bus_clock_changed();
+    prof_clock_changed();
+
+    uint64_t slept_us = (powman_timer_get_ms() - aon_ms) * s_cal_us / s_cal_aon_ms;
+    power_advance_timer(slept_us);
+    power_sync_timers();
+    restore_interrupts(irq);
+    return (uint32_t)(slept_us / 1000u);
+}
+
+// ==============================
+//  Public API
+// ==============================
+
+void power_init(uint32_t imu_int_pin)
+{
+    s_imu_int_pin = imu_int_pin;
+
+    // A warm reset finds it still running; only the differences matter
+    if (!powman_timer_is_running()) {
+        powman_timer_set_1khz_tick_source_lposc();
+        powman_timer_set_ms(0);
+        powman_timer_start();
+    }
+    power_sync_timers();
+
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    s_state_since_ms = now_ms;
+    s_quiet_since_ms = now_ms;
+    s_entries[POWER_ACTIVE] = 1;
+}
+
+void power_service(uint32_t now_ms, bool imu_ok, uint32_t wake_count)
+{
+    uint32_t sleep_s = config_value(CONFIG_POWER_SLEEP_S);
+    if (!imu_ok || sleep_s == 0 || imu_get_activity_level() != 0) {
+        s_quiet_since_ms = now_ms;
+    }
+    // A new wake (button, IMU) means the display is about to come on
+    bool woken = wake_count != s_wake_count;
+    s_wake_count = wake_count;
+    bool settled = !woken && (now_ms - s_quiet_since_ms) >= sleep_s * 1000u &&
+                   imu_get_power_mode() == IMU_POWER_LOW && !ui_display_awake();
+
+    if (s_state == POWER_ACTIVE) {
+        if (settled && ui_park()) {
+            power_clock_low();
+            power_enter(POWER_IDLE, now_ms);
+        }
+        return;
+    }
+
+    if (!settled) {
+        power_clock_full();
+        ui_unpark();
+        power_enter(POWER_ACTIVE, now_ms);
+        return;
+    }
+
+    // Without INT1 only a button could wake us, and steps would go
+    // uncounted: idle is as far as it goes, with the sensor still streaming
+    if (!IMU_INT1_FITTED) return;
+    // Going dormant would drop the host off the bus
+    if (stdio_usb_connected()) return;
+    if (!imu_sleep_prepare(now_ms)) return;
+    if (power_wake_pending()) {
+        imu_sleep_resume(now_ms);
+        return;
+    }
+
+    power_enter(POWER_DORMANT, now_ms);
+    boot_watchdog_pause();
+    uint32_t slept_ms = power_dormant();
+    boot_watchdog_start();
+
+    // Back at full speed. Straight to active, so a short button press
+    // (still being debounced) isn't lost to the next dormant spell.
+    now_ms = to_ms_since_boot(get_absolute_time());
+    buttons_resync();
+    imu_sleep_resume(now_ms);
+    ui_unpark();
+    power_enter(POWER_ACTIVE, now_ms);
+    LOG_D("power: dormant for %lu ms", slept_ms);
+    (void)slept_ms;   // when LOG_D is compiled out
+}
+
+power_state_t power_get_state(void)
+{
+    return s_state;
+}
+
+void power_get_stats(power_stats_t *out)
+{
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    for (int s = 0; s < POWER_STATE_COUNT; s++) {
+        out->ms[s] = s_ms[s];
+        out->entries[s] = s_entries[s];
+    }
+    out->ms[s_state] += now_ms - s_state_since_ms;
+}
+
+void power_report(void)
+{
+    power_stats_t st;
+    power_get_stats(&st);
+
+    telemetry_power_t t = {
+        .state = (uint8_t)s_state,
+        .count = POWER_STATE_COUNT,
+    };
+    for (int s = 0; s < POWER_STATE_COUNT; s++) {
+        t.ms[s] = st.ms[s];
+        t.entries[s] = st.entries[s];
+    }
+    telemetry_send_power(&t);
+}
@@ -0,0 +1,61 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Power states (core 0)
+// ==============================
+//
+// POWER_IDLE: once the activity level (imu_get_activity_level()) has been
+// 0 for CONFIG_POWER_SLEEP_S, with the IMU in low-power mode (wake-up
+// engine armed on INT1) and the display asleep, core 1 is parked and
+// clk_sys drops to 48 MHz. Core 0 keeps servicing the IMU; telemetry and
+// log frames wait in their rings for core 1.
+//
+// POWER_DORMANT: only with IMU_INT1_FITTED (imu.h), since the current PCB
+// doesn't route INT1. From idle, unless a USB host is attached, the chip
+// goes dormant. Every clock stops until INT1 or a button pulls its GPIO. The
+// system timer stops too, so on wake it is moved on by what the always-on
+// (powman) timer counted, scaled by that timer's LPOSC rate as measured
+// against the crystal while awake. to_ms_since_boot() then carries on as if
+// the time had passed normally, and with it the step history buckets, the
+// minute/day rollovers and the flash log timestamps.
+//
+// Waking from dormant, or anything else that breaks the conditions
+// (movement, a button, the display waking), returns to POWER_ACTIVE at
+// full speed. Time in each state is
+// reported in TELEMETRY_FRAME_POWER.
+//
+
+typedef enum {
+    POWER_ACTIVE,
+    POWER_IDLE,       // core 1 parked, clk_sys 48 MHz
+    POWER_DORMANT,    // all clocks stopped
+    POWER_STATE_COUNT
+} power_state_t;
+
+typedef struct {
+    uint32_t ms[POWER_STATE_COUNT];        // time in each state since boot
+    uint32_t entries[POWER_STATE_COUNT];
+} power_stats_t;
+
+// Start the always-on timer; imu_int_pin is the IMU's INT1 (wake source).
+// Core 0, after buttons_init().
+void power_init(uint32_t imu_int_pin);
+
+// Last thing in each main-loop pass, with the display wake count published
+// in ui_state (core 1 can't act on it while parked). May go dormant and
+// only return once a wake source fires (with now_ms long out of date).
+void power_service(uint32_t now_ms, bool imu_ok, uint32_t wake_count);
+
+power_state_t power_get_state(void);
+
+// Totals, including the time so far in the current state
+void power_get_stats(power_stats_t *out);
+
+// Send the totals as a TELEMETRY_FRAME_POWER
+void power_report(void);
+
+#endif // POWER_H
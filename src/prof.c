@@ -0,0 +1,171 @@
+#include "prof.h"
+
+#if PROF_ENABLE
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "telemetry.h"
+#include <string.h>
+
+// ARMv8-M debug registers (per core, in the private peripheral bus)
+#define PROF_DEMCR               (*(volatile uint32_t *)0xE000EDFCu)
+#define PROF_DEMCR_TRCENA        (1u << 24)
+#define PROF_DWT_CTRL            (*(volatile uint32_t *)0xE0001000u)
+#define PROF_DWT_CTRL_CYCCNTENA  (1u << 0)
+#define PROF_DWT_CTRL_NOCYCCNT   (1u << 25)
+#define PROF_DWT_CYCCNT          (*(volatile uint32_t *)0xE0001004u)
+
+// Log-linear histogram: values 0-3 get their own bucket, then 4 buckets per
+// power of two (~25% resolution).
+#define PROF_BUCKETS             128
+
+_Static_assert(PROF_ZONE_COUNT <= TELEMETRY_PROF_MAX_ZONES, "too many zones for one PROF frame");
+
+typedef struct {
+    uint32_t window;              // report window these stats belong to
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_BUCKETS];
+} prof_stats_t;
+
+static prof_stats_t s_zones[PROF_ZONE_COUNT];
+static volatile uint32_t s_window = 1;   // zones start at 0, so the first sample resets them
+static bool s_use_dwt = false;
+static uint16_t s_cycles_per_us = 1;
+
+// Deadline tracking (core 0 only)
+static uint32_t s_last_service_ms = 0;
+static bool     s_have_service = false;
+static uint32_t s_deadline_misses = 0;
+static uint32_t s_worst_gap_ms = 0;
+
+static inline uint32_t prof_bucket(uint32_t v)
+{
+    if (v < 4) return v;
+    uint32_t octave = 31u - (uint32_t)__builtin_clz(v);   // >= 2
+    return (octave - 1u) * 4u + ((v >> (octave - 2u)) & 3u);
+}
+
+// Largest value that lands in bucket b
+static inline uint32_t prof_bucket_top(uint32_t b)
+{
+    if (b < 4) return b;
+    uint32_t octave = b / 4u + 1u;
+    uint64_t top = ((uint64_t)(4u + (b & 3u) + 1u) << (octave - 2u)) - 1u;
+    return top > UINT32_MAX ? UINT32_MAX : (uint32_t)top;
+}
+
+void prof_init(void)
+{
+    PROF_DEMCR |= PROF_DEMCR_TRCENA;   // DWT registers are gated by TRCENA
+    if (PROF_DWT_CTRL & PROF_DWT_CTRL_NOCYCCNT) {
+        // No cycle counter: fall back to the microsecond timer
+        s_use_dwt = false;
+        s_cycles_per_us = 1;
+        return;
+    }
+    PROF_DWT_CYCCNT = 0;
+    PROF_DWT_CTRL |= PROF_DWT_CTRL_CYCCNTENA;
+    s_use_dwt = true;
+    s_cycles_per_us = (uint16_t)(clock_get_hz(clk_sys) / 1000000u);
+}
+
+uint32_t prof_now(void)
+{
+    return s_use_dwt ? PROF_DWT_CYCCNT : time_us_32();
+}
+
+uint32_t prof_ticks_per_us(void)
+{
+    return s_cycles_per_us;
+}
+
+void prof_clock_changed(void)
+{
+    if (!s_use_dwt) return;   // the timer fallback always counts in us
+    s_cycles_per_us = (uint16_t)(clock_get_hz(clk_sys) / 1000000u);
+    s_window = s_window + 1;
+}
+
+void prof_end(prof_zone_t zone, uint32_t start)
+{
+    uint32_t dt = prof_now() - start;
+    prof_stats_t *z = &s_zones[zone];
+
+    uint32_t window = s_window;
+    if (z->window != window) {
+        // The reporter moved on: start this zone's new window
+        memset(z, 0, sizeof(*z));
+        z->window = window;
+        z->min = UINT32_MAX;
+    }
+
+    z->count++;
+    z->sum += dt;
+    if (dt < z->min) z->min = dt;
+    if (dt > z->max) z->max = dt;
+    z->hist[prof_bucket(dt)]++;
+}
+
+void prof_deadline(uint32_t now_ms, uint32_t deadline_ms)
+{
+    if (s_have_service) {
+        uint32_t gap = now_ms - s_last_service_ms;
+        if (gap > s_worst_gap_ms) s_worst_gap_ms = gap;
+        if (gap > deadline_ms) s_deadline_misses++;
+    }
+    s_last_service_ms = now_ms;
+    s_have_service = true;
+}
+
+void prof_deadline_skip(void)
+{
+    s_have_service = false;
+}
+
+void prof_report(void)
+{
+    telemetry_prof_t rep = {
+        .cycles_per_us = s_cycles_per_us,
+        .deadline_misses = s_deadline_misses,
+        .worst_gap_ms = s_worst_gap_ms,
+        .zone_count = PROF_ZONE_COUNT,
+    };
+
+    uint32_t window = s_window;
+    for (int i = 0; i < PROF_ZONE_COUNT; i++) {
+        // Core 1 zones may be mid-update; a slightly torn window is fine here
+        const prof_stats_t *z = &s_zones[i];
+        telemetry_prof_zone_t *out = &rep.zones[i];
+        if (z->window != window || z->count == 0) continue;
+
+        out->count = z->count;
+        out->min = z->min;
+        out->max = z->max;
+        out->mean = (uint32_t)(z->sum / z->count);
+
+        // Bucket holding the 99th percentile sample, interpolated within it
+        uint32_t target = z->count - z->count / 100u;
+        uint32_t seen = 0;
+        for (uint32_t b = 0; b < PROF_BUCKETS; b++) {
+            if (seen + z->hist[b] >= target) {
+                uint32_t lo = b ? prof_bucket_top(b - 1) + 1u : 0;
+                uint32_t hi = prof_bucket_top(b);
+                uint32_t p99 = lo + (uint32_t)(((uint64_t)(hi - lo) * (target - seen)) / z->hist[b]);
+                if (p99 < z->min) p99 = z->min;
+                out->p99 = p99 < z->max ? p99 : z->max;
+                break;
+            }
+            seen += z->hist[b];
+        }
+    }
+    telemetry_send_prof(&rep);
+
+    s_window = window + 1;
+    s_deadline_misses = 0;
+    s_worst_gap_ms = 0;
+}
+
+#endif // PROF_ENABLE
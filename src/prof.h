@@ -0,0 +1,88 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Hot-path profiler
+// ==============================
+//
+// Named zones timed with the M33 DWT cycle counter (each core has its own),
+// or the 1 MHz system timer when the DWT has no cycle counter. Each zone
+// keeps count/min/max/sum and a log-linear histogram for p99, and belongs
+// to one core: only that core calls prof_end() on it.
+//
+// Core 0 calls prof_report() periodically: it sends a PROF telemetry frame
+// and starts a new window (each zone resets itself on its next sample).
+//
+// Build with -DPROF_ENABLE=0 to compile all of it out.
+//
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+typedef enum {
+    // core 0
+    PROF_ZONE_IMU_UPDATE,     // imu_update(): FIFO drain + step detection
+    PROF_ZONE_BATTERY,        // battery_service(): alert ack + burst read
+    PROF_ZONE_FLASH_LOG,      // flash_log_service() (includes any erase/program)
+    PROF_ZONE_CORE0_PASS,     // one event-loop pass, excluding the wait
+    // core 1
+    PROF_ZONE_LED_BAR,        // update_led_bar() + ws2812_show()
+    PROF_ZONE_RENDER_OLED,    // drawing into the back buffer
+    PROF_ZONE_OLED_DISPLAY,   // oled_display_async(): diff + queueing
+    PROF_ZONE_USB,            // telemetry_service() + log_service()
+    PROF_ZONE_COUNT
+} prof_zone_t;
+
+#if PROF_ENABLE
+
+// Start the cycle counter on the calling core (call once on each core)
+void prof_init(void);
+
+// Current counter value (cycles, or us on the timer fallback)
+uint32_t prof_now(void);
+
+// Counter ticks per microsecond (1 on the timer fallback)
+uint32_t prof_ticks_per_us(void);
+
+// clk_sys was just changed: pick up the new cycle rate and start a new
+// report window, so no window mixes samples taken at two rates
+void prof_clock_changed(void);
+
+static inline uint32_t prof_begin(void)
+{
+    return prof_now();
+}
+
+// Close a zone opened with prof_begin()
+void prof_end(prof_zone_t zone, uint32_t start);
+
+// Note an IMU service pass at now_ms; more than deadline_ms since the
+// previous one counts as a deadline miss
+void prof_deadline(uint32_t now_ms, uint32_t deadline_ms);
+
+// Forget the previous pass, so the next prof_deadline() starts a new
+// interval instead of closing one that spans a sleep (power.c)
+void prof_deadline_skip(void);
+
+// Core 0: send the current window over telemetry and start a new one
+void prof_report(void);
+
+#else
+
+static inline void prof_init(void) {}
+static inline uint32_t prof_now(void) { return 0; }
+static inline uint32_t prof_ticks_per_us(void) { return 1; }
+static inline void prof_clock_changed(void) {}
+static inline uint32_t prof_begin(void) { return 0; }
+static inline void prof_end(prof_zone_t zone, uint32_t start) { (void)zone; (void)start; }
+static inline void prof_deadline(uint32_t now_ms, uint32_t deadline_ms) { (void)now_ms; (void)deadline_ms; }
+static inline void prof_deadline_skip(void) {}
+static inline void prof_report(void) {}
+
+#endif // PROF_ENABLE
+
+#endif // PROF_H
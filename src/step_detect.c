@@ -0,0 +1,412 @@
+#include "step_detect.h"
+
+#include <math.h>
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#include <arm_acle.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+// ==============================
+//  Config
+// ==============================
+
+// Simple low-pass filter tracking the 1g baseline (used to get a high-pass signal)
+#define STEP_MAG_LP_ALPHA            0.01f        // 0 < alpha <= 1
+
+// STEP_MAG_LP_ALPHA is per sample at 104 Hz; other rates scale it to keep
+// the same time constant
+#define STEP_ALPHA_REF_HZ            104
+
+// Fixed-point equivalent of the float setting above
+#define STEP_MAG_LP_ALPHA_Q15        ((int32_t)(STEP_MAG_LP_ALPHA * 32768.0f + 0.5f))
+
+// Block detector: the band-pass input is (|a|^2 >> 14) - 1g, which is
+// 32768 per g of deviation from 1g for small deviations
+#define STEP_BLOCK_MAX_INTERVAL_MS   2000         // longer gaps reset the cadence estimate
+#define STEP_BLOCK_Q_PER_G           32768
+
+static inline uint16_t step_clamp_mg(int32_t mg)
+{
+    if (mg < 0) return 0;
+    return mg > UINT16_MAX ? UINT16_MAX : (uint16_t)mg;
+}
+
+// ==============================
+//  Per-rate filter sets
+// ==============================
+//
+// Band-pass: 2nd-order Butterworth high-pass at 0.5 Hz then low-pass at
+// 3 Hz. Q14, packed for SMLAD as {b1, b2} / {-a1, -a2};
+// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2].
+typedef struct {
+    int16_t  b0;
+    uint32_t b12;
+    uint32_t a12;
+} step_biquad_t;
+
+typedef struct {
+    uint16_t      odr_hz;
+    uint8_t       env_decay_shift;   // peak envelope time constant, in samples
+    step_biquad_t bandpass[2];
+} step_rate_t;
+
+#define STEP_PACK16(lo, hi)  ((uint32_t)(uint16_t)(int16_t)(lo) | ((uint32_t)(uint16_t)(int16_t)(hi) << 16))
+
+static const step_rate_t s_rates[] = {
+    {
+        .odr_hz = 104,
+        .env_decay_shift = 8,    // ~2.5 s
+        .bandpass = {
+            { 16038, STEP_PACK16(-32075, 16038), STEP_PACK16(32068, -15699) },  // HP 0.5 Hz
+            {   119, STEP_PACK16(   238,   119), STEP_PACK16(28588, -12680) },  // LP 3 Hz
+        },
+    },
+    {
+        .odr_hz = 26,
+        .env_decay_shift = 6,    // ~2.5 s
+        .bandpass = {
+            { 15042, STEP_PACK16(-30084, 15042), STEP_PACK16(29974, -13810) },  // HP 0.5 Hz
+            {  1403, STEP_PACK16(  2805,  1403), STEP_PACK16(16698,  -5924) },  // LP 3 Hz
+        },
+    },
+};
+
+#define STEP_RATE_COUNT  (sizeof(s_rates) / sizeof(s_rates[0]))
+
+// ==============================
+//  Threshold detectors
+// ==============================
+//
+// Both high-pass |a| against a slow low-pass of itself (removing gravity)
+// and report a step when it exceeds the threshold, at most once per
+// minimum interval.
+
+#if STEP_NEED_FLOAT
+// Reference float pipeline
+static bool step_detect_float(step_float_t *d, const step_tuning_t *t, int16_t ax, int16_t ay,
+                              int16_t az, uint32_t sample_ms, uint16_t *peak_mg)
+{
+    // Convert to g units (assuming ±2g full-scale)
+    float ax_g = (float)ax * STEP_DETECT_LSB_G;
+    float ay_g = (float)ay * STEP_DETECT_LSB_G;
+    float az_g = (float)az * STEP_DETECT_LSB_G;
+
+    // Compute magnitude and apply a crude high-pass to remove gravity
+    float mag = sqrtf(ax_g * ax_g + ay_g * ay_g + az_g * az_g);
+
+    if (!d->lp_initialized) {
+        // First sample seeds the low-pass
+        d->mag_lp = mag;
+        d->lp_initialized = true;
+    } else {
+        d->mag_lp += t->lp_alpha * (mag - d->mag_lp);
+    }
+
+    d->mag_hp = mag - d->mag_lp;
+
+    if (d->mag_hp > t->threshold_g) {
+        uint32_t dt = sample_ms - d->last_step_ms;
+        if (dt > t->min_interval_ms) {
+            d->last_step_ms = sample_ms;
+            *peak_mg = step_clamp_mg((int32_t)(d->mag_hp * 1000.0f));
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+#if STEP_NEED_FIXED
+// Integer square root, only used to seed the baseline
+static uint32_t step_isqrt32(uint32_t v)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Integer pipeline on raw LSB. |a| is never computed: the threshold test is
+// |a|^2 > (lp + T)^2, and the baseline IIR gets |a| - lp from
+// (|a|^2 - lp^2) / (|a| + lp), estimating |a| + lp with one refinement.
+static bool step_detect_fixed(step_fixed_t *d, const step_tuning_t *t, int16_t ax, int16_t ay,
+                              int16_t az, uint32_t sample_ms, uint16_t *peak_mg)
+{
+    // At most 3 * 32768^2, so the sum fits in 32 bits
+    uint32_t mag2 = (uint32_t)((int32_t)ax * ax) +
+                    (uint32_t)((int32_t)ay * ay) +
+                    (uint32_t)((int32_t)az * az);
+
+    if (!d->lp_initialized) {
+        // First sample seeds the low-pass
+        d->mag_lp_q15 = (int32_t)(step_isqrt32(mag2) << 15);
+        d->lp_initialized = true;
+    } else {
+        int32_t lp = d->mag_lp_q15 >> 15;
+        if (lp < 1) lp = 1;
+        int64_t err2 = (int64_t)mag2 - (int64_t)lp * lp;
+        if (err2 > INT32_MAX) err2 = INT32_MAX;
+        if (err2 < INT32_MIN) err2 = INT32_MIN;
+
+        int32_t diff = (int32_t)err2 / (2 * lp);           // first guess at |a| - lp
+        int32_t denom = 2 * lp + diff;                     // ~ |a| + lp
+        if (denom > 0) diff = (int32_t)err2 / denom;
+
+        d->mag_lp_q15 += t->lp_alpha_q15 * diff;
+    }
+
+    uint32_t level = (uint32_t)(d->mag_lp_q15 >> 15) + (uint32_t)t->threshold_lsb;
+    if ((uint64_t)mag2 > (uint64_t)level * level) {
+        uint32_t dt = sample_ms - d->last_step_ms;
+        if (dt > t->min_interval_ms) {
+            d->last_step_ms = sample_ms;
+            // |a| - lp ~ (|a|^2 - lp^2) / 2lp, only worked out on a step
+            int32_t lp = d->mag_lp_q15 >> 15;
+            if (lp < 1) lp = 1;
+            int64_t hp = ((int64_t)mag2 - (int64_t)lp * lp) / (2 * lp);
+            *peak_mg = step_clamp_mg((int32_t)(hp * 61 / 1000));   // 0.061 mg/LSB
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+// ==============================
+//  Block detector
+// ==============================
+
+#if STEP_NEED_BLOCK
+// Dual 16x16 multiply-accumulate: acc + lo(x)*lo(y) + hi(x)*hi(y).
+// A single SMLAD on cores with the DSP extension (Cortex-M33).
+static inline int32_t step_smlad(uint32_t x, uint32_t y, int32_t acc)
+{
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+    return __smlad(x, y, acc);
+#else
+    return acc + (int16_t)(x & 0xFFFF) * (int16_t)(y & 0xFFFF)
+               + (int16_t)(x >> 16) * (int16_t)(y >> 16);
+#endif
+}
+
+static inline int16_t step_sat16(int32_t v)
+{
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+    return (int16_t)__ssat(v, 16);
+#else
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+#endif
+}
+
+// Run one Direct Form I biquad over buf in place: two SMLADs per sample
+static void step_biquad_block(const step_biquad_t *c, step_biquad_state_t *st,
+                              int16_t *buf, size_t n)
+{
+    uint32_t x12 = st->x12;
+    uint32_t y12 = st->y12;
+    for (size_t i = 0; i < n; i++) {
+        int32_t x0 = buf[i];
+        int32_t acc = x0 * c->b0 + (1 << 13);   // round
+        acc = step_smlad(c->b12, x12, acc);
+        acc = step_smlad(c->a12, y12, acc);
+        int16_t y0 = step_sat16(acc >> 14);
+
+        x12 = (x12 << 16) | (uint16_t)x0;
+        y12 = (y12 << 16) | (uint16_t)y0;
+        buf[i] = y0;
+    }
+    st->x12 = x12;
+    st->y12 = y12;
+}
+
+// Feed one band-passed sample to the peak picker. A step is a local maximum
+// above half the recent peak height (never below the minimum peak), with
+// the signal having dropped below zero since the previous step and at least
+// half the recent step interval having passed. Returns true on a step.
+static bool step_block_pick(step_block_t *d, const step_tuning_t *t, uint8_t env_decay_shift,
+                            int16_t y0, uint32_t sample_ms)
+{
+    // A peak is only known one sample late, so it belongs to y1
+    int16_t y1 = d->y1;
+    uint32_t peak_ms = d->y1_ms;
+    bool is_peak = (y1 > d->y2) && (y1 >= y0);
+    d->y2 = y1;
+    d->y1 = y0;
+    d->y1_ms = sample_ms;
+
+    if (y1 < 0) d->armed = true;
+
+    // Let the envelope sag between steps (time constant ~2.5 s), so the
+    // threshold follows someone who slows down or walks more softly
+    d->peak_env -= d->peak_env >> env_decay_shift;
+
+    if (!is_peak || !d->armed) return false;
+
+    int32_t threshold = d->peak_env / 2;
+    if (threshold < t->block_min_peak_q) threshold = t->block_min_peak_q;
+    if (y1 < threshold) return false;
+
+    uint32_t dt = peak_ms - d->last_step_ms;
+    uint32_t min_dt = d->interval_ms / 2;
+    if (min_dt < t->block_min_interval_ms) min_dt = t->block_min_interval_ms;
+    if (d->last_step_ms != 0 && dt < min_dt) return false;
+
+    if (d->last_step_ms == 0 || dt > STEP_BLOCK_MAX_INTERVAL_MS) {
+        d->interval_ms = 0;
+    } else if (d->interval_ms == 0) {
+        d->interval_ms = dt;
+    } else {
+        d->interval_ms += ((int32_t)dt - (int32_t)d->interval_ms) / 4;
+    }
+    d->peak_env += (y1 - d->peak_env) / 4;
+    d->armed = false;
+    d->last_step_ms = peak_ms;
+    return true;
+}
+#endif
+
+// ==============================
+//  Public API
+// ==============================
+
+// Everything the per-sample code would otherwise work out each time
+static void step_detect_derive(step_detector_t *d)
+{
+    const step_detect_params_t *p = &d->params;
+    step_tuning_t *t = &d->tune;
+    t->threshold_g = (float)p->threshold_mg * 0.001f;
+    t->threshold_lsb = (int32_t)(t->threshold_g / STEP_DETECT_LSB_G + 0.5f);
+    t->min_interval_ms = p->min_interval_ms;
+    t->lp_alpha = STEP_MAG_LP_ALPHA * (float)STEP_ALPHA_REF_HZ / (float)d->odr_hz;
+    t->lp_alpha_q15 = STEP_MAG_LP_ALPHA_Q15 * STEP_ALPHA_REF_HZ / d->odr_hz;
+    t->block_min_peak_q = (int32_t)(((uint32_t)p->block_min_peak_mg * STEP_BLOCK_Q_PER_G + 500u) / 1000u);
+    t->block_min_interval_ms = p->block_min_interval_ms;
+}
+
+void step_detect_default_params(step_detect_params_t *p)
+{
+    p->threshold_mg = (uint16_t)(STEP_THRESHOLD_G * 1000.0f + 0.5f);
+    p->min_interval_ms = STEP_MIN_INTERVAL_MS;
+    p->block_min_peak_mg = STEP_BLOCK_MIN_PEAK_MG;
+    p->block_min_interval_ms = STEP_BLOCK_MIN_INTERVAL_MS;
+}
+
+void step_detect_init(step_detector_t *d, uint16_t odr_hz)
+{
+    memset(d, 0, sizeof(*d));
+    step_detect_default_params(&d->params);
+    step_detect_set_odr(d, odr_hz);
+}
+
+void step_detect_set_params(step_detector_t *d, const step_detect_params_t *p)
+{
+    d->params = *p;
+    step_detect_derive(d);
+}
+
+void step_detect_set_odr(step_detector_t *d, uint16_t odr_hz)
+{
+    if (odr_hz == 0) odr_hz = 1;
+    uint8_t best = 0;
+    for (uint8_t r = 1; r < STEP_RATE_COUNT; r++) {
+        if (abs((int)s_rates[r].odr_hz - (int)odr_hz) < abs((int)s_rates[best].odr_hz - (int)odr_hz)) {
+            best = r;
+        }
+    }
+#if STEP_NEED_BLOCK
+    // New coefficients: restart the filters rather than mixing states
+    if (best != d->rate) memset(d->block.bq, 0, sizeof(d->block.bq));
+#endif
+    d->odr_hz = odr_hz;
+    d->period_us = 1000000u / odr_hz;
+    d->rate = best;
+    step_detect_derive(d);
+}
+
+void step_detect_reset(step_detector_t *d)
+{
+#if STEP_NEED_FLOAT
+    memset(&d->flt, 0, sizeof(d->flt));
+#endif
+#if STEP_NEED_FIXED
+    memset(&d->fixed, 0, sizeof(d->fixed));
+#endif
+#if STEP_NEED_BLOCK
+    memset(&d->block, 0, sizeof(d->block));
+#endif
+}
+
+size_t step_detect_block(step_detector_t *d, const int16_t *xyz, size_t n,
+                         uint32_t t0_ms, step_event_t *steps)
+{
+    size_t found = 0;
+#if STEP_NEED_FIXED || STEP_NEED_FLOAT
+    uint16_t peak_mg;
+#endif
+    if (n > STEP_DETECT_MAX_BLOCK) n = STEP_DETECT_MAX_BLOCK;
+#if STEP_NEED_BLOCK
+    int16_t bp[STEP_DETECT_MAX_BLOCK];
+#endif
+
+    for (size_t i = 0; i < n; i++) {
+        int16_t ax = xyz[3 * i + 0];
+        int16_t ay = xyz[3 * i + 1];
+        int16_t az = xyz[3 * i + 2];
+#if STEP_NEED_FIXED || STEP_NEED_FLOAT
+        uint32_t sample_ms = step_detect_sample_ms(d, t0_ms, i);
+#endif
+
+#if STEP_NEED_BLOCK
+        // At most 3 * 32768^2, so the sum fits in 32 bits
+        uint32_t mag2 = (uint32_t)((int32_t)ax * ax) +
+                        (uint32_t)((int32_t)ay * ay) +
+                        (uint32_t)((int32_t)az * az);
+        bp[i] = step_sat16((int32_t)(mag2 >> 14) - 16384);
+#endif
+#if STEP_DETECTOR == STEP_DETECTOR_FIXED
+        if (step_detect_fixed(&d->fixed, &d->tune, ax, ay, az, sample_ms, &peak_mg)) {
+            steps[found++] = (step_event_t){ .t_ms = sample_ms, .count = 1, .peak_mg = peak_mg };
+        }
+#elif STEP_DETECTOR == STEP_DETECTOR_FLOAT
+        if (step_detect_float(&d->flt, &d->tune, ax, ay, az, sample_ms, &peak_mg)) {
+            steps[found++] = (step_event_t){ .t_ms = sample_ms, .count = 1, .peak_mg = peak_mg };
+        }
+#endif
+#if STEP_DETECT_AB_COMPARE
+#if STEP_DETECTOR == STEP_DETECTOR_FLOAT
+        if (step_detect_fixed(&d->fixed, &d->tune, ax, ay, az, sample_ms, &peak_mg)) d->ref_steps++;
+#else
+        if (step_detect_float(&d->flt, &d->tune, ax, ay, az, sample_ms, &peak_mg)) d->ref_steps++;
+#endif
+#endif
+    }
+
+#if STEP_NEED_BLOCK
+    const step_rate_t *rate = &s_rates[d->rate];
+    step_biquad_block(&rate->bandpass[0], &d->block.bq[0], bp, n);
+    step_biquad_block(&rate->bandpass[1], &d->block.bq[1], bp, n);
+    for (size_t i = 0; i < n; i++) {
+        int16_t peak = d->block.y1;   // the peak is the sample before bp[i]
+        if (step_block_pick(&d->block, &d->tune, rate->env_decay_shift, bp[i], step_detect_sample_ms(d, t0_ms, i))) {
+            steps[found++] = (step_event_t){
+                .t_ms = d->block.last_step_ms,
+                .count = 1,
+                .peak_mg = step_clamp_mg((int32_t)peak * 1000 / STEP_BLOCK_Q_PER_G),
+            };
+        }
+    }
+#endif
+    return found;
+}
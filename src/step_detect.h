@@ -0,0 +1,172 @@
+#ifndef STEP_DETECT_H
+#define STEP_DETECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==============================
+//  Step detector core
+// ==============================
+//
+// Hardware-independent: takes raw accelerometer samples (±2 g full scale,
+// STEP_DETECT_LSB_G per LSB) with their timestamps and reports steps. No
+// I2C, no SDK, no heap; all state lives in a caller-owned step_detector_t,
+// so the same code runs in imu.c and in the host replay tool (src/host/).
+//
+
+#define STEP_DETECT_LSB_G            (0.000061f)  // 0.061 mg/LSB at ±2 g
+
+// Detector implementation:
+//   STEP_DETECTOR_FIXED - per-sample integer threshold on raw LSB
+//   STEP_DETECTOR_FLOAT - original float pipeline, kept as the reference
+//   STEP_DETECTOR_BLOCK - band-pass + adaptive peak picking over each batch (default)
+#define STEP_DETECTOR_FIXED          0
+#define STEP_DETECTOR_FLOAT          1
+#define STEP_DETECTOR_BLOCK          2
+#ifndef STEP_DETECTOR
+#define STEP_DETECTOR                STEP_DETECTOR_BLOCK
+#endif
+
+// When set, a reference detector also runs on every sample and keeps its
+// own count (ref_steps) for A/B accuracy testing: the float pipeline, or
+// the fixed-point one when float is the primary detector.
+#ifndef STEP_DETECT_AB_COMPARE
+#define STEP_DETECT_AB_COMPARE       0
+#endif
+
+// Threshold detectors (fixed/float); override with -D to sweep on the host
+#ifndef STEP_THRESHOLD_G
+#define STEP_THRESHOLD_G             0.35f        // high-pass magnitude threshold in g
+#endif
+#ifndef STEP_MIN_INTERVAL_MS
+#define STEP_MIN_INTERVAL_MS         350          // ignore steps closer than this in time
+#endif
+
+// Block detector: smallest peak that counts, and the fastest cadence
+#ifndef STEP_BLOCK_MIN_PEAK_MG
+#define STEP_BLOCK_MIN_PEAK_MG       37           // ~0.04 g
+#endif
+#ifndef STEP_BLOCK_MIN_INTERVAL_MS
+#define STEP_BLOCK_MIN_INTERVAL_MS   250          // 4 steps/s, faster than any sprint
+#endif
+
+// Samples per step_detect_block() call
+#define STEP_DETECT_MAX_BLOCK        32
+
+#define STEP_NEED_FLOAT  (STEP_DETECTOR == STEP_DETECTOR_FLOAT || STEP_DETECT_AB_COMPARE)
+#define STEP_NEED_FIXED  (STEP_DETECTOR == STEP_DETECTOR_FIXED || \
+                          (STEP_DETECTOR == STEP_DETECTOR_FLOAT && STEP_DETECT_AB_COMPARE))
+#define STEP_NEED_BLOCK  (STEP_DETECTOR == STEP_DETECTOR_BLOCK)
+
+// Float reference detector: magnitude baseline / high-pass in g
+typedef struct {
+    bool     lp_initialized;
+    float    mag_lp;                 // low-pass of |a|
+    float    mag_hp;                 // high-pass: |a| - low-pass
+    uint32_t last_step_ms;
+} step_float_t;
+
+// Fixed-point detector: baseline of |a| in LSB with 15 fractional bits
+typedef struct {
+    bool     lp_initialized;
+    int32_t  mag_lp_q15;
+    uint32_t last_step_ms;
+} step_fixed_t;
+
+// Block detector: biquad cascade state plus peak-picker state
+typedef struct {
+    uint32_t x12;                    // x[n-1] | x[n-2] << 16
+    uint32_t y12;                    // y[n-1] | y[n-2] << 16
+} step_biquad_state_t;
+
+typedef struct {
+    step_biquad_state_t bq[2];
+    int16_t  y1, y2;                 // last two band-passed samples
+    uint32_t y1_ms;                  // timestamp of y1
+    bool     armed;                  // signal went below zero since the last peak
+    int32_t  peak_env;               // running average of accepted peak heights
+    uint32_t last_step_ms;
+    uint32_t interval_ms;            // running average step interval, 0 = unknown
+} step_block_t;
+
+// One entry of the step event stream. The software detectors report each
+// step on its own; the hardware pedometer only reports counts per poll.
+typedef struct {
+    uint32_t t_ms;                   // when the step (or the last of them) happened
+    uint16_t count;                  // steps in this event
+    uint16_t peak_mg;                // acceleration peak above 1 g, 0 = unknown
+} step_event_t;
+
+// Tuning, settable at run time (config.h); the build flags above are the
+// defaults
+typedef struct {
+    uint16_t threshold_mg;           // threshold detectors: high-pass |a| to count
+    uint16_t min_interval_ms;        // threshold detectors: ignore steps closer than this
+    uint16_t block_min_peak_mg;      // block detector: STEP_BLOCK_MIN_PEAK_MG
+    uint16_t block_min_interval_ms;  // block detector: STEP_BLOCK_MIN_INTERVAL_MS
+} step_detect_params_t;
+
+// What the per-sample code actually reads, worked out from the params and
+// the sample rate whenever either changes
+typedef struct {
+    float    threshold_g;
+    int32_t  threshold_lsb;
+    uint32_t min_interval_ms;
+    float    lp_alpha;               // baseline low-pass, per sample at odr_hz
+    int32_t  lp_alpha_q15;
+    int32_t  block_min_peak_q;
+    uint32_t block_min_interval_ms;
+} step_tuning_t;
+
+typedef struct {
+    uint16_t odr_hz;
+    uint32_t period_us;
+    uint8_t  rate;                   // index of the filter set for odr_hz
+    step_detect_params_t params;
+    step_tuning_t tune;
+#if STEP_NEED_FLOAT
+    step_float_t flt;
+#endif
+#if STEP_NEED_FIXED
+    step_fixed_t fixed;
+#endif
+#if STEP_NEED_BLOCK
+    step_block_t block;
+#endif
+    uint32_t ref_steps;              // A/B reference count (STEP_DETECT_AB_COMPARE)
+} step_detector_t;
+
+// Build-flag defaults
+void step_detect_default_params(step_detect_params_t *p);
+
+// Reset all state for a sample rate, with the default params. The block
+// detector has filters for 104 Hz and 26 Hz; other rates use the nearest set.
+void step_detect_init(step_detector_t *d, uint16_t odr_hz);
+
+// Change the tuning; detector state is kept
+void step_detect_set_params(step_detector_t *d, const step_detect_params_t *p);
+
+// Change the sample rate. Cadence state is kept; the band-pass filters
+// restart when the rate needs a different filter set.
+void step_detect_set_odr(step_detector_t *d, uint16_t odr_hz);
+
+// Forget all signal history (after a gap in the data), keeping the rate
+// and ref_steps
+void step_detect_reset(step_detector_t *d);
+
+// Run n <= STEP_DETECT_MAX_BLOCK samples (interleaved X/Y/Z) through the
+// detector; sample i was taken at t0_ms + i periods. Writes one event per
+// step found to steps (room for n entries) and returns how many. The block
+// detector's peak is the band-passed one; the threshold detectors report
+// the level at the sample that crossed.
+size_t step_detect_block(step_detector_t *d, const int16_t *xyz, size_t n,
+                         uint32_t t0_ms, step_event_t *steps);
+
+// Timestamp of sample i in a block starting at t0_ms
+static inline uint32_t step_detect_sample_ms(const step_detector_t *d, uint32_t t0_ms, size_t i)
+{
+    return t0_ms + (uint32_t)((i * d->period_us) / 1000u);
+}
+
+#endif // STEP_DETECT_H
@@ -0,0 +1,375 @@
+#include "telemetry.h"
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/sync.h"
+#include "crc.h"
+#include <string.h>
+
+// Encoded bytes waiting for USB; power of two. At 104 Hz the accel stream
+// is ~700 B/s, so this covers several seconds of a stalled host.
+#define TELEMETRY_RING_SIZE      8192u
+#define TELEMETRY_RING_MASK      (TELEMETRY_RING_SIZE - 1u)
+
+// Bytes handed to USB per telemetry_service() call
+#define TELEMETRY_SERVICE_MAX    1024u
+
+// type + seq + payload + crc, and its COBS encoding (+1 per 254 bytes, +1
+// leading code byte, +1 delimiter)
+#define TELEMETRY_RAW_MAX        (3 + TELEMETRY_MAX_PAYLOAD + 2)
+#define TELEMETRY_ENC_MAX        (TELEMETRY_RAW_MAX + TELEMETRY_RAW_MAX / 254 + 2)
+
+// Host command bytes read per telemetry_service() call
+#define TELEMETRY_RX_MAX         64u
+
+// A command frame: type + seq + payload + crc, COBS-encoded
+#define TELEMETRY_RX_RAW_MAX     (3 + TELEMETRY_CMD_MAX_PAYLOAD + 2)
+#define TELEMETRY_RX_ENC_MAX     (TELEMETRY_RX_RAW_MAX + 2)
+
+static uint8_t s_ring[TELEMETRY_RING_SIZE];
+static volatile uint32_t s_head = 0;   // written by core 0
+static volatile uint32_t s_tail = 0;   // written by core 1
+static uint16_t s_seq = 0;
+static uint16_t s_log_seq = 0;         // core 1's own LOG frames
+static uint32_t s_drops = 0;
+
+// Command reception (core 1) and the one-deep mailbox to core 0
+static uint8_t s_rx[TELEMETRY_RX_ENC_MAX];
+static size_t s_rx_len = 0;
+static bool s_rx_overflow = false;
+static telemetry_cmd_t s_cmd;
+static volatile bool s_cmd_full = false;
+static uint32_t s_cmd_drops = 0;
+
+// ==============================
+//  Encoding
+// ==============================
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+// COBS: replace every zero with the distance to the next one, so 0x00 only
+// ever appears as the frame delimiter. Returns the encoded length.
+static size_t telemetry_cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_at = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    return o;
+}
+
+// Inverse of the above, without the delimiter. Returns the decoded length,
+// or 0 if the input isn't valid COBS.
+static size_t telemetry_cobs_decode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t o = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t code = in[i];
+        if (code == 0 || i + code > len) return 0;
+        for (uint8_t k = 1; k < code; k++) out[o++] = in[i + k];
+        i += code;
+        if (code < 0xFF && i < len) out[o++] = 0;
+    }
+    return o;
+}
+
+// Frame and COBS-encode one message into enc (TELEMETRY_ENC_MAX bytes),
+// delimiter included. Returns the encoded length.
+static size_t telemetry_encode(telemetry_frame_t type, uint16_t seq,
+                               const uint8_t *payload, size_t len, uint8_t *enc)
+{
+    uint8_t raw[TELEMETRY_RAW_MAX];
+
+    raw[0] = (uint8_t)type;
+    put_u16(&raw[1], seq);
+    memcpy(&raw[3], payload, len);
+    size_t raw_len = 3 + len;
+    put_u16(&raw[raw_len], crc16_ccitt(CRC16_INIT, raw, raw_len));
+    raw_len += 2;
+
+    size_t enc_len = telemetry_cobs_encode(raw, raw_len, enc);
+    enc[enc_len++] = 0x00;
+    return enc_len;
+}
+
+static void telemetry_send(telemetry_frame_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t enc[TELEMETRY_ENC_MAX];
+    // seq is counted even if the frame is dropped, so the host sees the gap
+    size_t enc_len = telemetry_encode(type, s_seq++, payload, len, enc);
+
+    uint32_t head = s_head;
+    if (TELEMETRY_RING_SIZE - (head - s_tail) < enc_len) {
+        s_drops++;
+        return;
+    }
+
+    uint32_t at = head & TELEMETRY_RING_MASK;
+    size_t first = TELEMETRY_RING_SIZE - at;
+    if (first > enc_len) first = enc_len;
+    memcpy(&s_ring[at], enc, first);
+    memcpy(&s_ring[0], enc + first, enc_len - first);
+
+    __dmb();   // bytes visible before the new head
+    s_head = head + (uint32_t)enc_len;
+}
+
+// ==============================
+//  Public API
+// ==============================
+
+void telemetry_init(void)
+{
+    s_head = 0;
+    s_tail = 0;
+    s_seq = 0;
+    s_drops = 0;
+}
+
+void telemetry_send_accel(uint32_t t0_ms, uint16_t odr_hz, const int16_t *xyz, size_t n)
+{
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    if (n > TELEMETRY_ACCEL_MAX_SAMPLES) n = TELEMETRY_ACCEL_MAX_SAMPLES;
+
+    uint8_t *p = put_u32(payload, t0_ms);
+    p = put_u16(p, odr_hz);
+    *p++ = (uint8_t)n;
+    *p++ = 0;   // reserved
+    for (size_t i = 0; i < 3 * n; i++) {
+        p = put_u16(p, (uint16_t)xyz[i]);
+    }
+    telemetry_send(TELEMETRY_FRAME_ACCEL, payload, (size_t)(p - payload));
+}
+
+void telemetry_send_step(uint32_t t_ms, uint32_t total, uint8_t count)
+{
+    uint8_t payload[9];
+    uint8_t *p = put_u32(payload, t_ms);
+    p = put_u32(p, total);
+    *p++ = count;
+    telemetry_send(TELEMETRY_FRAME_STEP, payload, (size_t)(p - payload));
+}
+
+void telemetry_send_state(const telemetry_state_t *st)
+{
+    uint8_t payload[40];
+    uint8_t *p = put_u32(payload, st->t_ms);
+    p = put_u32(p, st->steps);
+    p = put_u32(p, st->total_steps);
+    p = put_u32(p, st->calories);
+    p = put_u16(p, st->soc_x10);
+    *p++ = st->battery_percent;
+    *p++ = st->flags;
+    p = put_u16(p, st->odr_hz);
+    for (int i = 0; i < 3; i++) {
+        p = put_u16(p, (uint16_t)st->accel_raw[i]);
+    }
+    p = put_u32(p, st->fifo_overruns);
+    p = put_u32(p, st->i2c_errors);
+    p = put_u32(p, st->i2c_failures);
+    telemetry_send(TELEMETRY_FRAME_STATE, payload, (size_t)(p - payload));
+}
+
+void telemetry_send_prof(const telemetry_prof_t *prof)
+{
+    uint8_t payload[11 + TELEMETRY_PROF_MAX_ZONES * 20];
+    uint8_t n = prof->zone_count;
+    if (n > TELEMETRY_PROF_MAX_ZONES) n = TELEMETRY_PROF_MAX_ZONES;
+
+    uint8_t *p = put_u16(payload, prof->cycles_per_us);
+    p = put_u32(p, prof->deadline_misses);
+    p = put_u32(p, prof->worst_gap_ms);
+    *p++ = n;
+    for (uint8_t i = 0; i < n; i++) {
+        const telemetry_prof_zone_t *z = &prof->zones[i];
+        p = put_u32(p, z->count);
+        p = put_u32(p, z->min);
+        p = put_u32(p, z->max);
+        p = put_u32(p, z->mean);
+        p = put_u32(p, z->p99);
+    }
+    telemetry_send(TELEMETRY_FRAME_PROF, payload, (size_t)(p - payload));
+}
+
+void telemetry_send_config(const telemetry_config_t *config)
+{
+    uint8_t payload[5 + TELEMETRY_CONFIG_MAX_FIELDS * 2];
+    uint8_t n = config->count;
+    if (n > TELEMETRY_CONFIG_MAX_FIELDS) n = TELEMETRY_CONFIG_MAX_FIELDS;
+
+    uint8_t *p = payload;
+    *p++ = config->status;
+    *p++ = config->flags;
+    p = put_u16(p, config->version);
+    *p++ = n;
+    for (uint8_t i = 0; i < n; i++) {
+        p = put_u16(p, config->values[i]);
+    }
+    telemetry_send(TELEMETRY_FRAME_CONFIG, payload, (size_t)(p - payload));
+}
+
+void telemetry_send_power(const telemetry_power_t *power)
+{
+    uint8_t payload[2 + TELEMETRY_POWER_MAX_STATES * 8];
+    uint8_t n = power->count;
+    if (n > TELEMETRY_POWER_MAX_STATES) n = TELEMETRY_POWER_MAX_STATES;
+
+    uint8_t *p = payload;
+    *p++ = power->state;
+    *p++ = n;
+    for (uint8_t i = 0; i < n; i++) {
+        p = put_u32(p, power->ms[i]);
+        p = put_u32(p, power->entries[i]);
+    }
+    telemetry_send(TELEMETRY_FRAME_POWER, payload, (size_t)(p - payload));
+}
+
+// One complete command frame arrived (without its delimiter)
+static void telemetry_rx_frame(const uint8_t *enc, size_t len)
+{
+    uint8_t raw[TELEMETRY_RX_ENC_MAX];
+    size_t raw_len = telemetry_cobs_decode(enc, len, raw);
+    if (raw_len < 5 || raw_len > TELEMETRY_RX_RAW_MAX) {
+        s_cmd_drops++;
+        return;
+    }
+    uint16_t crc = (uint16_t)(raw[raw_len - 2] | (raw[raw_len - 1] << 8));
+    if (crc != crc16_ccitt(CRC16_INIT, raw, raw_len - 2)) {
+        s_cmd_drops++;
+        return;
+    }
+    s_cmd.type = raw[0];
+    s_cmd.len = (uint8_t)(raw_len - 5);
+    memcpy(s_cmd.payload, &raw[3], s_cmd.len);
+    __dmb();   // command visible before the flag
+    s_cmd_full = true;
+}
+
+static void telemetry_rx_service(void)
+{
+    for (uint32_t n = 0; n < TELEMETRY_RX_MAX; n++) {
+        // Leave the rest in the USB buffer until core 0 has taken the last one
+        if (s_cmd_full) return;
+        int c = getchar_timeout_us(0);
+        if (c == PICO_ERROR_TIMEOUT) return;
+        if (c != 0x00) {
+            if (s_rx_len < sizeof(s_rx)) {
+                s_rx[s_rx_len++] = (uint8_t)c;
+            } else {
+                s_rx_overflow = true;   // too long for a command: drop it whole
+            }
+            continue;
+        }
+        if (s_rx_overflow) {
+            s_cmd_drops++;
+        } else if (s_rx_len > 0) {
+            telemetry_rx_frame(s_rx, s_rx_len);
+        }
+        s_rx_len = 0;
+        s_rx_overflow = false;
+    }
+}
+
+bool telemetry_poll_command(telemetry_cmd_t *out)
+{
+    if (!s_cmd_full) return false;
+    __dmb();   // pairs with the barrier before the flag was set
+    *out = s_cmd;
+    __dmb();   // copied out before the slot is handed back
+    s_cmd_full = false;
+    return true;
+}
+
+uint32_t telemetry_get_cmd_drops(void)
+{
+    return s_cmd_drops;
+}
+
+void telemetry_service(void)
+{
+    uint32_t head = s_head;
+    __dmb();   // pairs with the producer's barrier before publishing head
+    uint32_t tail = s_tail;
+
+    if (!stdio_usb_connected()) {
+        // Nobody listening: drop the backlog rather than replay stale data
+        s_tail = head;
+        s_rx_len = 0;
+        return;
+    }
+    telemetry_rx_service();
+
+    // Only whole frames go out, so LOG frames can slot in between calls.
+    // head is always on a boundary; otherwise back up to the last delimiter.
+    uint32_t end = head;
+    if (end - tail > TELEMETRY_SERVICE_MAX) {
+        end = tail + TELEMETRY_SERVICE_MAX;
+        while (end != tail && s_ring[(end - 1) & TELEMETRY_RING_MASK] != 0x00) {
+            end--;
+        }
+    }
+
+    while (tail != end) {
+        uint32_t at = tail & TELEMETRY_RING_MASK;
+        uint32_t len = end - tail;
+        if (len > TELEMETRY_RING_SIZE - at) len = TELEMETRY_RING_SIZE - at;
+
+        // Raw bytes: no newline and no CR/LF translation
+        stdio_put_string((const char *)&s_ring[at], (int)len, false, false);
+        tail += len;
+    }
+
+    __dmb();   // done reading before the space is handed back
+    s_tail = tail;
+}
+
+void telemetry_send_log(uint8_t level, uint32_t t_us, const char *text, size_t len)
+{
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    uint8_t enc[TELEMETRY_ENC_MAX];
+
+    if (len > sizeof(payload) - 5) len = sizeof(payload) - 5;
+    uint8_t *p = put_u32(payload, t_us);
+    *p++ = level;
+    memcpy(p, text, len);
+
+    size_t enc_len = telemetry_encode(TELEMETRY_FRAME_LOG, s_log_seq++, payload, 5 + len, enc);
+    if (stdio_usb_connected()) {
+        stdio_put_string((const char *)enc, (int)enc_len, false, false);
+    }
+}
+
+uint32_t telemetry_get_drops(void)
+{
+    return s_drops;
+}
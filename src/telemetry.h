@@ -0,0 +1,158 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==============================
+//  Binary telemetry over USB CDC
+// ==============================
+//
+// Frames are [type u8][seq u16][payload][crc16 u16], little-endian, CRC-16/
+// CCITT-FALSE over everything before it, then COBS-encoded and terminated
+// with a 0x00. seq counts every frame produced, so a gap on the host side
+// means frames were dropped (ring full or no host reading).
+//
+// The host can send commands back the same way (TELEMETRY_CMD_*). Core 1
+// picks them up in telemetry_service() and core 0 collects them with
+// telemetry_poll_command().
+//
+// Producers (core 0 only) encode straight into a lock-free ring; core 1
+// drains it to USB in telemetry_service(), so a slow or absent host never
+// stalls sampling. LOG frames are the exception: core 1 writes them itself
+// and numbers them separately. tools/telemetry_decode.py is the host-side
+// decoder.
+//
+
+typedef enum {
+    TELEMETRY_FRAME_ACCEL = 0x01,   // raw accelerometer block
+    TELEMETRY_FRAME_STEP  = 0x02,   // one or more steps counted
+    TELEMETRY_FRAME_STATE = 0x03,   // periodic device state
+    TELEMETRY_FRAME_LOG   = 0x04,   // formatted log message (log.h)
+    TELEMETRY_FRAME_PROF  = 0x05,   // profiler window (prof.h)
+    TELEMETRY_FRAME_CONFIG = 0x06,  // config values (config.h), reply to every CONFIG command
+    TELEMETRY_FRAME_POWER  = 0x07,  // time spent in each power state (power.h)
+} telemetry_frame_t;
+
+// Host -> device
+typedef enum {
+    TELEMETRY_CMD_CONFIG_GET      = 0x80,   // no payload
+    TELEMETRY_CMD_CONFIG_SET      = 0x81,   // [field u8][value u16] ...
+    TELEMETRY_CMD_CONFIG_SAVE     = 0x82,   // write the current values to flash
+    TELEMETRY_CMD_CONFIG_DEFAULTS = 0x83,   // back to build defaults (not saved)
+} telemetry_cmd_type_t;
+
+#define TELEMETRY_CMD_MAX_PAYLOAD  48
+
+typedef struct {
+    uint8_t type;                   // telemetry_cmd_type_t
+    uint8_t len;
+    uint8_t payload[TELEMETRY_CMD_MAX_PAYLOAD];
+} telemetry_cmd_t;
+
+// Largest payload of a single frame (an accel block of 32 samples)
+#define TELEMETRY_ACCEL_MAX_SAMPLES  32
+#define TELEMETRY_MAX_PAYLOAD        (8 + TELEMETRY_ACCEL_MAX_SAMPLES * 6)
+
+// Periodic state, one TELEMETRY_FRAME_STATE
+typedef struct {
+    uint32_t t_ms;
+    uint32_t steps;            // workout steps
+    uint32_t total_steps;      // detector total
+    uint32_t calories;
+    uint16_t soc_x10;          // state of charge, 0.1 %
+    uint8_t  battery_percent;
+    uint8_t  flags;            // TELEMETRY_STATE_*
+    uint16_t odr_hz;
+    int16_t  accel_raw[3];
+    uint32_t fifo_overruns;
+    uint32_t i2c_errors;       // all devices
+    uint32_t i2c_failures;     // all devices, retries exhausted
+} telemetry_state_t;
+
+#define TELEMETRY_STATE_IMU_OK        (1u << 0)
+#define TELEMETRY_STATE_SHOW_CALORIES (1u << 1)
+#define TELEMETRY_STATE_PAUSED        (1u << 2)
+#define TELEMETRY_STATE_LOW_POWER     (1u << 3)
+#define TELEMETRY_STATE_HW_STEPS      (1u << 4)
+
+// Profiler window, one TELEMETRY_FRAME_PROF. Times are in counter ticks:
+// divide by cycles_per_us for microseconds.
+#define TELEMETRY_PROF_MAX_ZONES  8
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint32_t p99;
+} telemetry_prof_zone_t;
+
+typedef struct {
+    uint16_t cycles_per_us;
+    uint32_t deadline_misses;
+    uint32_t worst_gap_ms;     // longest gap between IMU service passes
+    uint8_t  zone_count;
+    telemetry_prof_zone_t zones[TELEMETRY_PROF_MAX_ZONES];
+} telemetry_prof_t;
+
+// Config values, one TELEMETRY_FRAME_CONFIG
+#define TELEMETRY_CONFIG_MAX_FIELDS  32
+
+#define TELEMETRY_CONFIG_FROM_FLASH  (1u << 0)   // loaded from / saved to flash
+#define TELEMETRY_CONFIG_DIRTY       (1u << 1)   // changed since then
+
+typedef struct {
+    uint8_t  status;           // config_status_t of the command
+    uint8_t  flags;            // TELEMETRY_CONFIG_*
+    uint16_t version;          // CONFIG_VERSION
+    uint8_t  count;
+    uint16_t values[TELEMETRY_CONFIG_MAX_FIELDS];   // by config_field_t
+} telemetry_config_t;
+
+// Power-state residency, one TELEMETRY_FRAME_POWER
+#define TELEMETRY_POWER_MAX_STATES  4
+
+typedef struct {
+    uint8_t  state;            // power_state_t right now
+    uint8_t  count;
+    uint32_t ms[TELEMETRY_POWER_MAX_STATES];       // time in each state since boot
+    uint32_t entries[TELEMETRY_POWER_MAX_STATES];  // times each state was entered
+} telemetry_power_t;
+
+void telemetry_init(void);
+
+// Raw samples, n <= TELEMETRY_ACCEL_MAX_SAMPLES, interleaved X/Y/Z (LSB);
+// sample i was taken at t0_ms + i / odr_hz
+void telemetry_send_accel(uint32_t t0_ms, uint16_t odr_hz, const int16_t *xyz, size_t n);
+
+// `count` steps detected at t_ms, bringing the detector total to `total`
+void telemetry_send_step(uint32_t t_ms, uint32_t total, uint8_t count);
+
+void telemetry_send_state(const telemetry_state_t *state);
+
+void telemetry_send_prof(const telemetry_prof_t *prof);
+
+void telemetry_send_config(const telemetry_config_t *config);
+
+void telemetry_send_power(const telemetry_power_t *power);
+
+// Core 0: take the oldest command the host sent, if any
+bool telemetry_poll_command(telemetry_cmd_t *out);
+
+// Host frames that weren't valid commands (bad COBS/CRC, too long)
+uint32_t telemetry_get_cmd_drops(void);
+
+// Core 1: push queued frames out over USB (never blocks on a missing host)
+// and take in host commands. Always stops on a frame boundary.
+void telemetry_service(void);
+
+// Core 1: send one log line (level from log.h, timestamp in us) straight
+// to USB, between telemetry_service() calls. Text is cut to fit a frame.
+void telemetry_send_log(uint8_t level, uint32_t t_us, const char *text, size_t len);
+
+// Frames lost because the ring was full
+uint32_t telemetry_get_drops(void);
+
+#endif // TELEMETRY_H
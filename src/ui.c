@@ -0,0 +1,367 @@
+#include "ui.h"
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/sync.h"
+
+#include "boot.h"
+#include "config.h"
+#include "oled.h"
+#include "log.h"
+#include "prof.h"
+#include "telemetry.h"
+#include "font5x7.h"
+#include "ui_state.h"
+#include "ws2812.h"
+#include "anim.h"
+
+// WS2812 configuration
+#define LED_PIN         8
+#define LED_FREQ_HZ     800000
+#define STEPS_PER_LED   25
+#define BREATH_PERIOD_MS 3000
+
+// UI cadences (ms); the display refresh, step flash and sleep are in config.h
+#define LED_FRAME_MS        20    // while anything on the LEDs or OLED is moving
+#define UI_IDLE_POLL_MS     250   // otherwise: USB receive poll between core 0 publishes
+#define BATTERY_ANIM_MS     2400  // battery icon breathes this long after a wake or change
+
+// What the OLED currently shows. The panel is only redrawn when this
+// changes, so a still display costs no I2C traffic at all.
+typedef struct {
+    uint32_t value;            // steps or calories
+    uint8_t  battery_percent;
+    bool     show_calories;
+    bool     paused;
+    bool     flash;            // step border
+    bool     battery_anim;     // breathing battery icon
+} oled_view_t;
+
+static bool oled_view_equal(const oled_view_t *a, const oled_view_t *b)
+{
+    return a->value == b->value && a->battery_percent == b->battery_percent &&
+           a->show_calories == b->show_calories && a->paused == b->paused &&
+           a->flash == b->flash && a->battery_anim == b->battery_anim;
+}
+
+// Written by core 1 only; core 0 reads it for the mode button
+static volatile bool s_display_awake = true;
+
+bool ui_display_awake(void)
+{
+    return s_display_awake;
+}
+
+// Park handshake with core 0
+static volatile bool s_park_request = false;
+static volatile bool s_parked = false;
+
+bool ui_park(void)
+{
+    s_park_request = true;
+    __sev();   // core 1 may be idling in WFE
+    absolute_time_t deadline = make_timeout_time_ms(UI_PARK_TIMEOUT_MS);
+    while (!s_parked) {
+        if (time_reached(deadline)) {
+            ui_unpark();
+            return false;
+        }
+        tight_loop_contents();
+    }
+    return true;
+}
+
+void ui_unpark(void)
+{
+    s_park_request = false;
+    __sev();
+    while (s_parked) {
+        tight_loop_contents();
+    }
+}
+
+// Core 1 side: a dark LED bar and a quiet bus, then wait to be released
+static void ui_park_wait(void)
+{
+    ws2812_fill(rgb_to_grb(0, 0, 0));
+    ws2812_flush();
+    while (ws2812_busy() || oled_display_busy()) {
+        tight_loop_contents();
+    }
+    s_parked = true;
+    while (s_park_request) {
+        __wfe();
+    }
+    s_parked = false;
+}
+
+// Breathing-blue phase for unlit/partial LEDs
+static anim_phase_t s_breath_phase;
+
+// Returns true while any LED is breathing, i.e. the bar isn't fully lit
+static bool update_led_bar(uint32_t steps, uint8_t battery_percent, uint32_t now_ms) {
+    const anim_rgb_t *c = anim_battery_color(battery_percent);
+
+    uint8_t breath = anim_gamma[anim_breath[anim_phase_advance(&s_breath_phase, now_ms)]];
+    uint8_t breath_level = anim_scale8(breath, 80); // cap breathing brightness
+    bool breathing = false;
+
+    for (uint8_t i = 0; i < NUM_LEDS; i++) {
+        int32_t steps_into_segment = (int32_t)steps - (int32_t)(i * STEPS_PER_LED);
+        if (steps_into_segment <= 0) {
+            ws2812_set(i, rgb_to_grb(0, 0, breath_level));
+            breathing = true;
+            continue;
+        }
+        if (steps_into_segment > STEPS_PER_LED) steps_into_segment = STEPS_PER_LED;
+        uint8_t scale = (uint8_t)((steps_into_segment * 255) / STEPS_PER_LED); // 0-255 brightness
+        uint8_t level = anim_gamma[scale];
+        uint8_t sr = anim_scale8(c->r, level);
+        uint8_t sg = anim_scale8(c->g, level);
+        uint8_t sb = anim_scale8(c->b, level);
+        if (scale < 255) {
+            // Add breathing blue when not fully lit
+            uint16_t boosted_b = sb + breath_level;
+            sb = (boosted_b > 255) ? 255 : (uint8_t)boosted_b;
+            breathing = true;
+        }
+        ws2812_set(i, rgb_to_grb(sr, sg, sb));
+    }
+    return breathing;
+}
+
+typedef struct {
+    uint16_t frame_idx;
+    uint16_t frames_per_travel;
+    uint8_t last_pos;
+} led_bounce_state_t;
+
+static void startup_led_bounce_step(void *ctx, int16_t x_unused) {
+    (void)x_unused;
+    led_bounce_state_t *state = (led_bounce_state_t *)ctx;
+    if (state->frames_per_travel == 0) state->frames_per_travel = 1;
+
+    if (NUM_LEDS == 0) return;
+    uint8_t end = NUM_LEDS - 1;
+    uint16_t travel = state->frame_idx / state->frames_per_travel;
+    uint16_t within = state->frame_idx % state->frames_per_travel;
+
+    bool forward = (travel & 0x1) == 0;
+
+    // Position along strip in 8.8 fixed point, for a smooth cross-fade between LEDs
+    uint32_t pos = 0;
+    if (state->frames_per_travel > 1) {
+        pos = ((uint32_t)within * end * 256u) / (state->frames_per_travel - 1);
+    }
+    if (!forward) pos = (uint32_t)end * 256u - pos;
+
+    uint8_t base = (uint8_t)(pos >> 8);
+    if (base > end) base = end;
+    uint32_t frac = pos & 0xFF; // 0..255 between base and next
+
+    uint8_t next_level = (uint8_t)((frac * 20u + 128u) >> 8);   // 0 -> 20
+    uint8_t head_level = (uint8_t)(80u + next_level);           // 80 -> 100
+    uint8_t neighbor = forward ? (uint8_t)(base + 1) : (base == 0 ? 0 : (uint8_t)(base - 1));
+    if (neighbor > end) neighbor = end;
+
+    for (uint8_t i = 0; i < NUM_LEDS; i++) {
+        uint8_t level = 0;
+        if (i == base) {
+            level = head_level;
+        } else if (i == neighbor && neighbor != base) {
+            level = next_level;
+        }
+        ws2812_set(i, rgb_to_grb(level, level, 0)); // warm yellow bounce with smooth cross-fade
+    }
+    ws2812_show();
+
+    state->last_pos = base;
+    state->frame_idx++;
+}
+
+// Returns false if the previous push was still on the bus, in which case
+// nothing was sent and the caller tries again next refresh
+static bool render_oled(const oled_view_t *view, uint32_t now_ms) {
+    uint32_t t = prof_begin();
+    oled_home();
+
+    oled_print(6, 4, view->show_calories ? "CAL" : "STEPS");
+    if (view->battery_anim) {
+        oled_show_battery_animated(view->battery_percent, now_ms);
+    } else {
+        oled_show_battery(view->battery_percent);
+    }
+    if (view->show_calories) {
+        oled_show_calories(view->value);
+    } else {
+        oled_show_steps(view->value);
+    }
+
+    if (view->paused) {
+        // Show "PAUSED" near the bottom of the 32px display
+        oled_print(32, 24, "PAUSED");
+    }
+
+    if (view->flash) {
+        // 1px border flash to indicate a new step
+        oled_draw_rect(0, 0, OLED_WIDTH, OLED_HEIGHT, 1);
+    }
+
+    prof_end(PROF_ZONE_RENDER_OLED, t);
+
+    // Queued behind any IMU/fuel-gauge traffic; returns straight away
+    t = prof_begin();
+    bool sent = oled_display_async();
+    prof_end(PROF_ZONE_OLED_DISPLAY, t);
+    return sent;
+}
+
+static void ui_startup_animation(void) {
+    const char *title = "Pico Activity Tracker";
+    size_t title_len = strlen(title);
+    uint16_t title_px = (uint16_t)(title_len * (FONT_WIDTH + 1));
+    if (title_px > 0) title_px -= 1;
+    int16_t target_x = (title_px < OLED_WIDTH) ? (int16_t)((OLED_WIDTH - title_px) / 2) : 0;
+    uint16_t slide_frames = (uint16_t)(((OLED_WIDTH - target_x) / 2) + 1); // matches oled_slide_in_text step of 2px
+    if (slide_frames < 2) slide_frames = 2;
+    uint16_t travel_frames = slide_frames / 2; // two end-to-end travels during the slide
+    if (travel_frames == 0) travel_frames = 1;
+
+    uint8_t title_y = (OLED_HEIGHT - 8) / 2; // center the 8px font vertically
+    led_bounce_state_t bounce = {.last_pos = 0, .frame_idx = 0, .frames_per_travel = travel_frames};
+    oled_slide_in_text_hook(title, title_y, 12,
+                            startup_led_bounce_step, &bounce);
+    // Clear LEDs before handing control to the normal update loop
+    ws2812_fill(rgb_to_grb(0, 0, 0));
+    ws2812_flush();
+    sleep_ms(400); // let the title sit briefly before normal UI resumes
+}
+
+void ui_core1_main(void) {
+    // Lets core 0 park this core while it writes the flash log
+    flash_safe_execute_core_init();
+    prof_init();   // this core's cycle counter
+    ws2812_init(LED_PIN, LED_FREQ_HZ); // starts with a dark strip
+    anim_phase_init(&s_breath_phase, BREATH_PERIOD_MS, to_ms_since_boot(get_absolute_time()));
+
+    bool oled_ok = oled_init();
+    if (!oled_ok) {
+        LOG_E("OLED init failed!");
+    } else if (boot_get_mode() == BOOT_COLD) {
+        // A warm reset goes straight back to the step count
+        ui_startup_animation();
+    }
+
+    ui_state_t st;
+    ui_state_read(&st);
+    uint32_t prev_steps = st.steps;
+    uint8_t prev_battery = st.battery_percent;
+    uint32_t prev_wake_count = st.wake_count;
+    uint32_t start_ms = to_ms_since_boot(get_absolute_time());
+    uint32_t last_display_ms = 0;
+    uint32_t last_wake_ms = start_ms;
+    uint32_t step_flash_until_ms = start_ms;     // border flash timer on step increment
+    uint32_t battery_anim_until_ms = start_ms + BATTERY_ANIM_MS;
+    oled_view_t shown = {0};
+    bool shown_valid = false;                    // false: redraw on the next refresh
+    absolute_time_t next_frame = get_absolute_time();
+    bool animating = true;                       // false: nothing moves until core 0 publishes
+
+    while (true) {
+        if (animating) {
+            next_frame = delayed_by_ms(next_frame, LED_FRAME_MS);
+            sleep_until(next_frame);
+        } else {
+            // A publish or park request from core 0 sends an event; the
+            // timeout only keeps host commands on the USB link answered
+            best_effort_wfe_or_timeout(make_timeout_time_ms(UI_IDLE_POLL_MS));
+            next_frame = get_absolute_time();
+        }
+
+        if (s_park_request) {
+            ui_park_wait();
+            // Time may have jumped by hours (dormant); pick up from now
+            next_frame = get_absolute_time();
+            shown_valid = false;
+        }
+
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        ui_state_read(&st);
+
+        if (st.steps != prev_steps) {
+            prev_steps = st.steps;
+            step_flash_until_ms = now_ms + config_value(CONFIG_STEP_FLASH_MS); // brief border flash
+        }
+        if (st.battery_percent != prev_battery) {
+            prev_battery = st.battery_percent;
+            battery_anim_until_ms = now_ms + BATTERY_ANIM_MS;
+        }
+
+        // Display power: a wake source (mode button, IMU wake-up) turns the
+        // panel back on; CONFIG_DISPLAY_SLEEP_S without one turns it off
+        if (st.wake_count != prev_wake_count) {
+            prev_wake_count = st.wake_count;
+            last_wake_ms = now_ms;
+            if (oled_ok && !s_display_awake) {
+                oled_set_power(true);
+                s_display_awake = true;
+                battery_anim_until_ms = now_ms + BATTERY_ANIM_MS;
+                shown_valid = false;
+            }
+        }
+        uint32_t sleep_s = config_value(CONFIG_DISPLAY_SLEEP_S);
+        if (oled_ok && s_display_awake && sleep_s != 0 &&
+            (now_ms - last_wake_ms) >= sleep_s * 1000u) {
+            oled_set_power(false);
+            s_display_awake = false;
+        }
+
+        // One LED frame per loop pass; skipped by the driver if unchanged.
+        // The bar goes dark with the display, so its breathing stops too.
+        bool led_breathing = false;
+        uint32_t t = prof_begin();
+        if (s_display_awake) {
+            led_breathing = update_led_bar(st.steps, st.battery_percent, now_ms);
+        } else {
+            ws2812_fill(rgb_to_grb(0, 0, 0));
+        }
+        ws2812_show();
+        prof_end(PROF_ZONE_LED_BAR, t);
+
+        bool redraw_pending = false;
+        if (oled_ok && s_display_awake) {
+            oled_view_t view = {
+                .value = st.show_calories ? st.calories : st.steps,
+                .battery_percent = st.battery_percent,
+                .show_calories = st.show_calories,
+                .paused = st.paused,
+                .flash = (int32_t)(step_flash_until_ms - now_ms) > 0,
+                .battery_anim = (int32_t)(battery_anim_until_ms - now_ms) > 0,
+            };
+            // The breathing icon is redrawn every refresh while it lasts
+            bool changed = !shown_valid || view.battery_anim ||
+                           !oled_view_equal(&view, &shown);
+            if (changed && (!shown_valid ||
+                            (now_ms - last_display_ms) >= config_value(CONFIG_DISPLAY_REFRESH_MS))) {
+                last_display_ms = now_ms;
+                if (render_oled(&view, now_ms)) {
+                    shown = view;
+                    shown_valid = true;
+                }
+            }
+            // A flash ends and the icon breathes on their own timers, and a
+            // change inside the refresh interval is still to be drawn
+            redraw_pending = !shown_valid || view.flash || view.battery_anim ||
+                             !oled_view_equal(&view, &shown);
+        }
+        animating = led_breathing || redraw_pending;
+
+        // Core 0 queues telemetry frames and log entries; this is the USB side
+        t = prof_begin();
+        telemetry_service();
+        log_service();
+        prof_end(PROF_ZONE_USB, t);
+    }
+}
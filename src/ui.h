@@ -0,0 +1,34 @@
+#ifndef UI_H
+#define UI_H
+
+#include <stdbool.h>
+
+// ==============================
+//  UI core (core 1)
+// ==============================
+//
+// Owns the OLED, the WS2812 LED bar and the serial diagnostics. Everything
+// it shows comes from the ui_state snapshot published by core 0. Frames run
+// every 20 ms only while something moves (breathing LEDs, the step flash,
+// the battery icon) or a redraw is waiting; otherwise core 1 sleeps in WFE
+// until core 0 publishes. The LED bar goes dark while the display sleeps.
+//
+
+// Core 1 entry point: initialises the display and LEDs, plays the startup
+// animation, then runs the UI loop forever. Launch with multicore_launch_core1().
+void ui_core1_main(void);
+
+// False while the display is asleep (CONFIG_DISPLAY_SLEEP_S without a wake).
+// Core 0 uses it so the press that wakes the panel doesn't also toggle the
+// mode.
+bool ui_display_awake(void);
+
+// Park core 1 for a low-power state (core 0, power.c). Core 1 blanks the
+// LEDs, lets its OLED push finish and waits in WFE, leaving the I2C bus
+// idle. ui_park() returns false if core 1 didn't get there within
+// UI_PARK_TIMEOUT_MS; ui_unpark() lets it carry on.
+#define UI_PARK_TIMEOUT_MS  100
+bool ui_park(void);
+void ui_unpark(void);
+
+#endif // UI_H
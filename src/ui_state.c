@@ -0,0 +1,31 @@
+#include "ui_state.h"
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+// Odd while the writer is mid-update
+static volatile uint32_t s_seq = 0;
+static ui_state_t s_state;
+
+void ui_state_publish(const ui_state_t *state)
+{
+    s_seq = s_seq + 1;
+    __dmb();
+    s_state = *state;
+    __dmb();
+    s_seq = s_seq + 1;
+    __sev();   // core 1 idles in WFE until something changes
+}
+
+uint32_t ui_state_read(ui_state_t *out)
+{
+    uint32_t seq;
+    do {
+        seq = s_seq;
+        if (seq & 1u) continue;  // writer active, try again
+        __dmb();
+        *out = s_state;
+        __dmb();
+    } while ((seq & 1u) || seq != s_seq);
+    return seq >> 1;
+}
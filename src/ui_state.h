@@ -0,0 +1,38 @@
+#ifndef UI_STATE_H
+#define UI_STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  Core 0 -> core 1 UI snapshot
+// ==============================
+//
+// Core 0 (sensors, step detection) publishes a snapshot; core 1 (OLED,
+// LEDs, diagnostics) reads it. Single producer, single consumer, no locks:
+// a sequence counter lets the reader detect a torn copy and retry.
+//
+
+typedef struct {
+    uint32_t steps;            // steps in the current workout
+    uint32_t calories;         // calorie estimate for those steps
+    float    soc;              // fuel-gauge state of charge (%)
+    uint8_t  battery_percent;  // soc rounded/clamped to 0-100
+    bool     show_calories;    // mode button: calories instead of steps
+    bool     paused;           // workout paused
+    bool     imu_ok;           // IMU initialised and sampling
+    int16_t  accel_raw[3];     // last accelerometer sample (LSB)
+    float    accel_g[3];       // same sample in g
+    uint16_t imu_odr_hz;       // accelerometer rate for the current power mode
+    uint32_t wake_count;       // bumped on each display wake source (mode button, IMU wake-up)
+} ui_state_t;
+
+// Publish a new snapshot (core 0 only). Sends an event (SEV), so a core 1
+// waiting in WFE wakes up to read it.
+void ui_state_publish(const ui_state_t *state);
+
+// Copy out the latest consistent snapshot (core 1 only).
+// Returns a version number that changes on every publish.
+uint32_t ui_state_read(ui_state_t *out);
+
+#endif // UI_STATE_H
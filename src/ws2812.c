@@ -1,28 +1,97 @@
+#include "ws2812.h"
 #include "ws2812.pio.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
+#include <string.h>
 
-#define NUM_LEDS 4
+#define WS2812_PIO  pio0
+#define WS2812_SM   0
+
+// Frame being built, and the copy the DMA reads from (already shifted into
+// the top 24 bits the PIO program shifts out)
+static uint32_t s_pixels[NUM_LEDS];
+static uint32_t s_dma_pixels[NUM_LEDS];
+static bool s_pending = false;
+
+static int s_dma_chan = -1;
+static uint32_t s_last_start_us = 0;
 
 
 uint32_t rgb_to_grb(uint8_t r, uint8_t g, uint8_t b) {
-    return (g << 16) | (r << 8) | b;
+    return ((uint32_t)g << 16) | ((uint32_t)r << 8) | b;
+}
+
+void ws2812_init(uint32_t pin, float freq_hz) {
+    uint offset = pio_add_program(WS2812_PIO, &ws2812_program);
+    ws2812_program_init(WS2812_PIO, WS2812_SM, offset, pin, freq_hz, false);
+
+    s_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(s_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(WS2812_PIO, WS2812_SM, true));
+    dma_channel_configure(s_dma_chan, &c, &WS2812_PIO->txf[WS2812_SM],
+                          s_dma_pixels, NUM_LEDS, false);
+
+    // First frame always goes out, so the strip starts dark
+    memset(s_pixels, 0, sizeof(s_pixels));
+    s_pending = true;
+    s_last_start_us = time_us_32() - WS2812_FRAME_US;
+    ws2812_flush();
+}
+
+void ws2812_set(uint8_t index, uint32_t pixel_grb) {
+    if (index >= NUM_LEDS || s_pixels[index] == pixel_grb) return;
+    s_pixels[index] = pixel_grb;
+    s_pending = true;
+}
+
+void ws2812_fill(uint32_t pixel_grb) {
+    for (uint8_t i = 0; i < NUM_LEDS; i++) {
+        ws2812_set(i, pixel_grb);
+    }
 }
 
-void put_pixel(uint32_t pixel_grb) {
-    pio_sm_put_blocking(pio0, 0, pixel_grb << 8u);
+static bool ws2812_in_flight(void) {
+    return dma_channel_is_busy(s_dma_chan) ||
+           (time_us_32() - s_last_start_us) < WS2812_FRAME_US;
+}
+
+bool ws2812_show(void) {
+    if (s_dma_chan < 0) return false;
+    if (!s_pending) return true;
+    if (ws2812_in_flight()) return false;
+
+    for (uint8_t i = 0; i < NUM_LEDS; i++) {
+        s_dma_pixels[i] = s_pixels[i] << 8u;
+    }
+    s_pending = false;
+    s_last_start_us = time_us_32();
+    dma_channel_transfer_from_buffer_now(s_dma_chan, s_dma_pixels, NUM_LEDS);
+    return true;
+}
+
+void ws2812_flush(void) {
+    if (s_dma_chan < 0) return;
+    while (!ws2812_show()) {
+        tight_loop_contents();
+    }
+}
+
+bool ws2812_busy(void) {
+    return s_dma_chan >= 0 && ws2812_in_flight();
 }
 
 void show_one_led(int active, uint8_t r[], uint8_t g[], uint8_t b[], bool off) {
     for (int i = 0; i < NUM_LEDS; i++) {
-        if (i == active) {
-            if (off)
-                put_pixel(rgb_to_grb(0,0,0));   // blink OFF
-            else
-                put_pixel(rgb_to_grb(r[i], g[i], b[i])); // blink ON using fade color
+        if (i == active && !off) {
+            ws2812_set((uint8_t)i, rgb_to_grb(r[i], g[i], b[i])); // blink ON using fade color
         } else {
-            put_pixel(rgb_to_grb(0,0,0)); // all others OFF
+            ws2812_set((uint8_t)i, rgb_to_grb(0,0,0)); // blink OFF / all others OFF
         }
     }
-}
\ No newline at end of file
+    ws2812_show();
+}
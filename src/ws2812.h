@@ -0,0 +1,47 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==============================
+//  WS2812 LED strip (PIO + DMA)
+// ==============================
+//
+// Callers edit a NUM_LEDS GRB frame buffer and call ws2812_show() once per
+// LED frame. A changed frame is handed to a DMA channel that feeds the PIO
+// state machine, so no CPU time is spent waiting on the 800 kHz bit stream;
+// an unchanged frame costs nothing.
+//
+
+#define NUM_LEDS 4
+
+// Time to clock out one frame plus the >280 us reset/latch gap newer
+// WS2812B parts need before the next frame
+#define WS2812_FRAME_US  (NUM_LEDS * 30 + 300)
+
+// Load the PIO program on pio0/sm0, claim a DMA channel and blank the strip
+void ws2812_init(uint32_t pin, float freq_hz);
+
+uint32_t rgb_to_grb(uint8_t r, uint8_t g, uint8_t b);
+
+// Frame buffer edits (take effect on the next ws2812_show())
+void ws2812_set(uint8_t index, uint32_t pixel_grb);
+void ws2812_fill(uint32_t pixel_grb);
+
+// Start sending the frame if it changed since the last one sent.
+// Returns false if the previous frame is still going out (or latching);
+// the new frame stays pending and goes out on a later call.
+bool ws2812_show(void);
+
+// Like ws2812_show(), but waits out a frame still in flight
+void ws2812_flush(void);
+
+// True while a frame is going out or latching
+bool ws2812_busy(void);
+
+// Light LED `active` with its entry of r/g/b (or nothing if `off`), all
+// others dark
+void show_one_led(int active, uint8_t r[], uint8_t g[], uint8_t b[], bool off);
+
+#endif // WS2812_H
@@ -0,0 +1,443 @@
+#!/usr/bin/env python3
+"""Export the calorie model (calorie_model/model.ipynb) for the firmware.
+
+The notebook's model is a 300-tree random forest, far too big for the
+device. This distils it into a small MLP (5 -> HIDDEN ReLU -> 1) and
+quantises that to int8 weights with int16 activations, writing
+src/calorie_model_weights.h for src/calorie_model.c.
+
+Features are the notebook's, computed on the device for the day so far:
+    steps, duration_min (active minutes), distance_km, steps_per_min, speed_kmh
+
+Usage:
+    export_calorie_model.py --model calorie_predictor_kaggle_rf.joblib \\
+        --data "Steps Export_ 3-17-21to9-23-22.csv"
+    export_calorie_model.py                 # no model: MET reference teacher
+
+With --model the forest is the teacher: it labels the notebook rows (--data)
+plus jittered copies of them. Without it, the teacher is the same MET
+speed-band model as CALORIES_MODE_MET in src/calories.c, over a synthetic
+grid of days. That is a stand-in, not the notebook's model: the header says
+so, and it only exists so that the pipeline can be checked end to end
+before the forest and its data are at hand.
+
+The device runs the model on the day so far, so the samples reach down to
+the first active minute, and the header carries the range they span: the
+device clamps its inputs to it rather than extrapolate. The student's
+weights are kept non-negative, so it can't predict fewer calories for more
+activity. Before writing, the quantised model is also checked over the
+day-so-far sweep that calorie_model_self_test() repeats on the device (more
+active minutes at the same cadence, or a faster cadence for the same
+minutes, never gives fewer calories); a seed that fails is retrained with
+the next one.
+
+The trainer is plain Python, so the script runs without numpy. pandas and
+joblib are only needed for --model/--data.
+"""
+
+import argparse
+import math
+import random
+import sys
+
+FEATURES = ["steps", "duration_min", "distance_km", "steps_per_min", "speed_kmh"]
+
+# Device units for each feature (see calorie_model_features_t): raw = value * scale
+DEVICE_SCALE = [1, 1, 1000, 10, 100]   # steps, min, m, spm x10, km/h x100
+
+Z_FRAC = 12        # normalised inputs and hidden activations: Q12 int16
+MUL_SHIFT = 24     # requantisation multipliers
+OUT_FRAC = 4       # output: kcal x16
+
+# MET teacher samples: active minutes from 1 to this, and cadence range
+SAMPLE_MAX_MIN = 600
+SAMPLE_MIN_SPM = 20     # CALORIE_MODEL_ACTIVE_STEPS: the slowest active minute
+SAMPLE_MAX_SPM = 170
+
+# Monotonicity sweep (mirrored in calorie_model_self_test())
+CHECK_SPM = [30, 60, 90, 120, 150]
+CHECK_MAX_MIN = SAMPLE_MAX_MIN
+
+# Same bands as s_met_bands in src/calories.c: (mph, MET)
+MET_BANDS = [(0.0, 2.0), (2.0, 2.8), (2.5, 3.0), (2.8, 3.5), (3.5, 4.3),
+             (4.0, 5.0), (4.5, 7.0), (5.0, 8.3), (6.0, 9.8)]
+
+
+def features(steps, duration_min, distance_km):
+    return [steps, duration_min, distance_km, steps / duration_min,
+            distance_km / (duration_min / 60.0)]
+
+
+# ==============================
+#  Teachers
+# ==============================
+
+def met_teacher(weight_lbs):
+    kg = weight_lbs * 0.45359237
+
+    def predict(rows):
+        out = []
+        for _, duration, _, _, speed_kmh in rows:
+            mph = speed_kmh / 1.609344
+            met = [m for s, m in MET_BANDS if mph >= s][-1]
+            out.append(met * 3.5 * kg / 200.0 * duration)
+        return out
+    return predict
+
+
+def met_samples(n, stride_m, rng):
+    rows = []
+    for _ in range(n):
+        # Log-uniform, so the first minutes of a day are as well covered as
+        # the rest of it
+        duration = math.exp(rng.uniform(0.0, math.log(SAMPLE_MAX_MIN)))
+        spm = rng.uniform(SAMPLE_MIN_SPM, SAMPLE_MAX_SPM)
+        steps = spm * duration
+        # longer strides at higher cadence, as in real walking
+        stride = stride_m * (0.8 + 0.4 * (spm - 40) / 130) * rng.uniform(0.9, 1.1)
+        rows.append(features(steps, duration, steps * stride / 1000.0))
+    return rows
+
+
+def rf_teacher(path):
+    import joblib
+    import pandas as pd
+
+    pipe = joblib.load(path)
+
+    def predict(rows):
+        return [float(v) for v in pipe.predict(pd.DataFrame(rows, columns=FEATURES))]
+    return predict
+
+
+def csv_samples(path, n, rng):
+    # Same cleaning as the notebook
+    import pandas as pd
+
+    df = pd.read_csv(path).rename(columns={
+        "Steps": "steps", "Distance": "distance_km", "Minutes Active": "duration_min", "Calories": "calories",
+    })
+    df = df.dropna(subset=["steps", "duration_min", "distance_km", "calories"])
+    df = df[(df["duration_min"] > 0) & (df["steps"] >= 0) & (df["calories"] > 0)]
+    base = [(r.steps, r.duration_min, r.distance_km) for r in df.itertuples()]
+    rows = [features(*b) for b in base]
+    while len(rows) < n:
+        steps, duration, dist = rng.choice(base)
+        k = rng.uniform(0.7, 1.3)
+        rows.append(features(steps * k, max(1.0, duration * k * rng.uniform(0.9, 1.1)),
+                             dist * k * rng.uniform(0.95, 1.05)))
+    return rows
+
+
+# ==============================
+#  Student: 5 -> H (ReLU) -> 1
+# ==============================
+
+# With monotonic set, the weights of both layers are kept >= 0 (projected
+# after every step). ReLU is non-decreasing, so the model then is too, in
+# every input, and so is its quantised form: more steps, minutes, distance,
+# cadence or speed never predict fewer calories.
+def train(x, y, hidden, epochs, rng, monotonic):
+    n_in = len(x[0])
+    sign = abs if monotonic else (lambda v: v)
+    w1 = [[sign(rng.gauss(0, math.sqrt(2.0 / n_in))) for _ in range(n_in)] for _ in range(hidden)]
+    b1 = [0.0] * hidden
+    w2 = [sign(rng.gauss(0, math.sqrt(1.0 / hidden))) for _ in range(hidden)]
+    b2 = 0.0
+    # Adam moments, keyed by parameter
+    m = {}
+    v = {}
+    lr, beta1, beta2, eps = 0.01, 0.9, 0.999, 1e-8
+    step = 0
+    batch = 32
+    idx = list(range(len(x)))
+
+    for epoch in range(epochs):
+        rng.shuffle(idx)
+        for start in range(0, len(idx), batch):
+            chunk = idx[start:start + batch]
+            gw1 = [[0.0] * n_in for _ in range(hidden)]
+            gb1 = [0.0] * hidden
+            gw2 = [0.0] * hidden
+            gb2 = 0.0
+            for k in chunk:
+                xi = x[k]
+                pre = [sum(w * xv for w, xv in zip(w1[j], xi)) + b1[j] for j in range(hidden)]
+                h = [p if p > 0 else 0.0 for p in pre]
+                out = sum(w * hv for w, hv in zip(w2, h)) + b2
+                err = 2.0 * (out - y[k]) / len(chunk)
+                gb2 += err
+                for j in range(hidden):
+                    gw2[j] += err * h[j]
+                    if pre[j] > 0:
+                        g = err * w2[j]
+                        gb1[j] += g
+                        row = gw1[j]
+                        for i in range(n_in):
+                            row[i] += g * xi[i]
+            step += 1
+            corr1 = 1 - beta1 ** step
+            corr2 = 1 - beta2 ** step
+
+            def adam(key, p, g):
+                mk = m.get(key, 0.0) * beta1 + (1 - beta1) * g
+                vk = v.get(key, 0.0) * beta2 + (1 - beta2) * g * g
+                m[key], v[key] = mk, vk
+                return p - lr * (mk / corr1) / (math.sqrt(vk / corr2) + eps)
+
+            for j in range(hidden):
+                for i in range(n_in):
+                    w1[j][i] = adam(("w1", j, i), w1[j][i], gw1[j][i])
+                b1[j] = adam(("b1", j), b1[j], gb1[j])
+                w2[j] = adam(("w2", j), w2[j], gw2[j])
+                if monotonic:
+                    w1[j] = [max(0.0, w) for w in w1[j]]
+                    w2[j] = max(0.0, w2[j])
+            b2 = adam("b2", b2, gb2)
+        if epoch == epochs * 2 // 3:
+            lr *= 0.3
+    return w1, b1, w2, b2
+
+
+def predict_float(model, xi):
+    w1, b1, w2, b2 = model
+    h = [max(0.0, sum(w * xv for w, xv in zip(w1[j], xi)) + b1[j]) for j in range(len(w1))]
+    return sum(w * hv for w, hv in zip(w2, h)) + b2
+
+
+# ==============================
+#  Quantisation (mirrors calorie_model_infer_x16() in src/calorie_model.c)
+# ==============================
+
+def sat16(v):
+    return max(-32768, min(32767, v))
+
+
+def quantise(model, mean, std, y_mean, y_std, rows):
+    w1, b1, w2, b2 = model
+    q = {}
+    raws = [device_inputs(r) for r in rows]
+    q["in_min"] = [min(r[i] for r in raws) for i in range(len(FEATURES))]
+    q["in_max"] = [max(r[i] for r in raws) for i in range(len(FEATURES))]
+    dev_mean = [int(round(mu * s)) for mu, s in zip(mean, DEVICE_SCALE)]
+    dev_std = [sd * s for sd, s in zip(std, DEVICE_SCALE)]
+    q["in_mean"] = dev_mean
+    q["in_mul"] = [int(round((1 << Z_FRAC) * 65536 / sd)) for sd in dev_std]
+
+    s1 = max(abs(w) for row in w1 for w in row) / 127.0
+    q["w1"] = [[int(round(w / s1)) for w in row] for row in w1]
+    q["b1"] = [int(round(b / s1 * (1 << Z_FRAC))) for b in b1]
+    q["m1"] = int(round(s1 * (1 << MUL_SHIFT)))
+
+    s2 = max(abs(w) for w in w2) / 127.0
+    q["w2"] = [int(round(w / s2)) for w in w2]
+    q["b2"] = int(round(b2 / s2 * (1 << Z_FRAC)))
+    q["m2"] = int(round(s2 * y_std * (1 << OUT_FRAC) / (1 << Z_FRAC) * (1 << MUL_SHIFT)))
+    q["out_bias"] = int(round(y_mean * (1 << OUT_FRAC)))
+    return q
+
+
+def device_inputs(row):
+    return [int(round(v * s)) for v, s in zip(row, DEVICE_SCALE)]
+
+
+def device_features(steps, active_min, stride_mm):
+    # calorie_model_features() in src/calorie_model.c, integer for integer
+    active_min = max(active_min, 1)
+    distance_m = (steps * stride_mm + 500) // 1000
+    return [steps, active_min, distance_m,
+            (steps * 10 + active_min // 2) // active_min,
+            (distance_m * 6 + active_min // 2) // active_min]
+
+
+def shr(v, n):
+    # arithmetic shift right, as on the device
+    return v >> n
+
+
+def predict_q(q, raw):
+    raw = [min(max(r, lo), hi) for r, lo, hi in zip(raw, q["in_min"], q["in_max"])]
+    z = [sat16(shr((r - mu) * mul, 16)) for r, mu, mul in zip(raw, q["in_mean"], q["in_mul"])]
+    h = []
+    for row, b in zip(q["w1"], q["b1"]):
+        acc = b + sum(w * zv for w, zv in zip(row, z))
+        h.append(sat16(shr(max(acc, 0) * q["m1"], MUL_SHIFT)))
+    acc = q["b2"] + sum(w * hv for w, hv in zip(q["w2"], h))
+    return shr(acc * q["m2"], MUL_SHIFT) + q["out_bias"]
+
+
+def monotonic_failures(q, stride_mm):
+    # Same walk and comparisons as calorie_model_self_test()
+    bad = 0
+    prev_row = None
+    for spm in CHECK_SPM:
+        row = [predict_q(q, device_features(spm * m, m, stride_mm)) for m in range(1, CHECK_MAX_MIN + 1)]
+        bad += sum(1 for a, b in zip(row, row[1:]) if b < a)
+        if prev_row:
+            bad += sum(1 for a, b in zip(prev_row, row) if b < a)
+        prev_row = row
+    return bad
+
+
+# ==============================
+#  Header
+# ==============================
+
+def c_array(values):
+    return ", ".join("%d" % v for v in values)
+
+
+def write_header(path, q, hidden, info, vectors, stride_mm):
+    lines = [
+        "#ifndef CALORIE_MODEL_WEIGHTS_H",
+        "#define CALORIE_MODEL_WEIGHTS_H",
+        "",
+        "// Generated by tools/export_calorie_model.py; do not edit.",
+        "//",
+    ]
+    lines += ["// " + s for s in info]
+    lines += [
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define CALORIE_MODEL_INPUTS     %d" % len(FEATURES),
+        "#define CALORIE_MODEL_HIDDEN     %d" % hidden,
+        "#define CALORIE_MODEL_Z_FRAC     %d" % Z_FRAC,
+        "#define CALORIE_MODEL_MUL_SHIFT  %d" % MUL_SHIFT,
+        "#define CALORIE_MODEL_OUT_FRAC   %d" % OUT_FRAC,
+        "",
+        "// Training range, in device units: the device clamps its inputs to it",
+        "static const int32_t calorie_model_in_min[CALORIE_MODEL_INPUTS] = { %s };" % c_array(q["in_min"]),
+        "static const int32_t calorie_model_in_max[CALORIE_MODEL_INPUTS] = { %s };" % c_array(q["in_max"]),
+        "",
+        "// Input normalisation: z = ((raw - mean) * mul) >> 16, Q%d" % Z_FRAC,
+        "static const int32_t calorie_model_in_mean[CALORIE_MODEL_INPUTS] = { %s };" % c_array(q["in_mean"]),
+        "static const int32_t calorie_model_in_mul[CALORIE_MODEL_INPUTS] = { %s };" % c_array(q["in_mul"]),
+        "",
+        "// Hidden layer: ReLU(w1 . z + b1) * m1 >> MUL_SHIFT, Q%d" % Z_FRAC,
+        "static const int8_t calorie_model_w1[CALORIE_MODEL_HIDDEN][CALORIE_MODEL_INPUTS] = {",
+    ]
+    lines += ["    { %s }," % c_array(row) for row in q["w1"]]
+    lines += [
+        "};",
+        "static const int32_t calorie_model_b1[CALORIE_MODEL_HIDDEN] = { %s };" % c_array(q["b1"]),
+        "#define CALORIE_MODEL_M1         %d" % q["m1"],
+        "",
+        "// Output: (w2 . h + b2) * m2 >> MUL_SHIFT + out_bias, kcal x%d" % (1 << OUT_FRAC),
+        "static const int8_t calorie_model_w2[CALORIE_MODEL_HIDDEN] = { %s };" % c_array(q["w2"]),
+        "#define CALORIE_MODEL_B2         %d" % q["b2"],
+        "#define CALORIE_MODEL_M2         %d" % q["m2"],
+        "#define CALORIE_MODEL_OUT_BIAS   %d" % q["out_bias"],
+        "",
+        "// Reference vectors: device inputs and the exact expected output",
+        "#define CALORIE_MODEL_TEST_VECTORS %d" % len(vectors),
+        "static const int32_t calorie_model_test_in[CALORIE_MODEL_TEST_VECTORS][CALORIE_MODEL_INPUTS] = {",
+    ]
+    lines += ["    { %s }," % c_array(raw) for raw, _ in vectors]
+    lines += [
+        "};",
+        "static const int32_t calorie_model_test_out[CALORIE_MODEL_TEST_VECTORS] = { %s };"
+        % c_array(out for _, out in vectors),
+        "",
+        "// Monotonicity sweep: each cadence (steps per active minute) over 1..MAX_MIN",
+        "// active minutes at this stride",
+        "#define CALORIE_MODEL_CHECK_CADENCES  %d" % len(CHECK_SPM),
+        "#define CALORIE_MODEL_CHECK_MAX_MIN   %d" % CHECK_MAX_MIN,
+        "#define CALORIE_MODEL_CHECK_STRIDE_MM %d" % stride_mm,
+        "static const uint16_t calorie_model_check_spm[CALORIE_MODEL_CHECK_CADENCES] = { %s };" % c_array(CHECK_SPM),
+        "",
+        "#endif // CALORIE_MODEL_WEIGHTS_H",
+        "",
+    ]
+    with open(path, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--model", help="trained pipeline from the notebook (.joblib)")
+    ap.add_argument("--data", help="the notebook's CSV, to sample features from")
+    ap.add_argument("--out", default="src/calorie_model_weights.h")
+    ap.add_argument("--hidden", type=int, default=16)
+    ap.add_argument("--samples", type=int, default=1200)
+    ap.add_argument("--epochs", type=int, default=400)
+    ap.add_argument("--weight", type=float, default=160, help="MET teacher: body weight, lb")
+    ap.add_argument("--stride", type=float, default=1609.344 / 2200, help="MET teacher: stride, m")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--unconstrained", action="store_true",
+                    help="allow negative weights (then the sweep check rarely passes)")
+    ap.add_argument("--tries", type=int, default=5, help="seeds to try for a model that passes the sweep")
+    args = ap.parse_args()
+    stride_mm = int(round(args.stride * 1000))
+    for seed in range(args.seed, args.seed + args.tries):
+        if export(args, seed, stride_mm):
+            return
+    sys.exit("no monotonic model in %d tries; try more --samples or --epochs" % args.tries)
+
+
+def export(args, seed, stride_mm):
+    rng = random.Random(seed)
+
+    if args.model:
+        if not args.data:
+            ap.error("--model needs --data to sample features from")
+        teacher, source = rf_teacher(args.model), "teacher: %s" % args.model
+        rows = csv_samples(args.data, args.samples, rng)
+    else:
+        teacher = met_teacher(args.weight)
+        source = ("STAND-IN, not the notebook's model: MET speed-band teacher, %.0f lb, %.3f m stride"
+                  % (args.weight, args.stride))
+        rows = met_samples(args.samples, args.stride, rng)
+    labels = teacher(rows)
+
+    n = len(rows)
+    mean = [sum(r[i] for r in rows) / n for i in range(len(FEATURES))]
+    std = [math.sqrt(sum((r[i] - mean[i]) ** 2 for r in rows) / n) or 1.0 for i in range(len(FEATURES))]
+    y_mean = sum(labels) / n
+    y_std = math.sqrt(sum((v - y_mean) ** 2 for v in labels) / n) or 1.0
+    x = [[(r[i] - mean[i]) / std[i] for i in range(len(FEATURES))] for r in rows]
+    y = [(v - y_mean) / y_std for v in labels]
+
+    # Hold out a fifth, as the notebook does
+    split = n * 4 // 5
+    order = list(range(n))
+    rng.shuffle(order)
+    train_idx, test_idx = order[:split], order[split:]
+    model = train([x[k] for k in train_idx], [y[k] for k in train_idx], args.hidden, args.epochs, rng,
+                  not args.unconstrained)
+    q = quantise(model, mean, std, y_mean, y_std, rows)
+    bad = monotonic_failures(q, stride_mm)
+    if bad:
+        print("seed %d: %d non-monotonic steps in the sweep; retrying" % (seed, bad), file=sys.stderr)
+        return False
+
+    mae_f = mae_q = 0.0
+    for k in test_idx:
+        pf = predict_float(model, x[k]) * y_std + y_mean
+        pq = predict_q(q, device_inputs(rows[k])) / float(1 << OUT_FRAC)
+        mae_f += abs(pf - labels[k])
+        mae_q += abs(pq - labels[k])
+    mae_f /= len(test_idx)
+    mae_q /= len(test_idx)
+    early = [k for k in test_idx if rows[k][1] <= 30]
+    mae_early = sum(abs(predict_q(q, device_inputs(rows[k])) / float(1 << OUT_FRAC) - labels[k])
+                    for k in early) / max(1, len(early))
+
+    vectors = [(device_inputs(rows[k]), predict_q(q, device_inputs(rows[k]))) for k in test_idx[:8]]
+    info = [
+        source,
+        "%d samples (%d held out), %d hidden units, %d epochs, seed %d"
+        % (n, len(test_idx), args.hidden, args.epochs, seed),
+        "held-out MAE vs teacher: float %.2f kcal, quantised %.2f kcal (teacher mean %.0f kcal)"
+        % (mae_f, mae_q, y_mean),
+        "quantised MAE up to 30 active min: %.2f kcal (%d samples)" % (mae_early, len(early)),
+    ]
+    write_header(args.out, q, args.hidden, info, vectors, stride_mm)
+    for s in info:
+        print(s)
+    print("wrote", args.out, file=sys.stderr)
+    return True
+
+
+if __name__ == "__main__":
+    main()
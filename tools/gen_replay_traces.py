@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""Generate synthetic accelerometer traces for the host replay (src/host/replay.c).
+
+Each trace is a steady gait: one step per cycle of a sine at the cadence,
+a second harmonic for the heel strike, and Gaussian noise, projected onto
+a fixed wrist orientation and quantised to the IMU's +/-2 g raw LSB (so
+hard sprints clip, as they do on the device). Output is deterministic for
+a given --seed.
+
+CSV traces use the telemetry_decode.py --csv layout (t_ms,odr_hz,ax,ay,az)
+with a "# steps=N" header giving the true count. --capture also writes
+that trace as a raw telemetry capture (COBS ACCEL frames, see
+src/telemetry.h); pass the true count on the replay command line.
+
+Usage:
+    gen_replay_traces.py --out /tmp/traces --capture
+    replay /tmp/traces/*.csv /tmp/traces/walk26.bin=216
+"""
+
+import argparse
+import math
+import os
+import random
+import struct
+
+from telemetry_decode import FRAME_ACCEL, crc16_ccitt
+
+ACCEL_LSB_G = 0.000061           # LSM6DSO at +/-2 g
+ACCEL_MAX_SAMPLES = 32           # TELEMETRY_ACCEL_MAX_SAMPLES
+WRIST = (0.2, 0.3, 0.9327)       # unit gravity direction in the sensor frame
+
+# name: (odr_hz, cadence_hz, amplitude_g, harmonic, noise_g, seconds)
+TRACES = {
+    "slowwalk104": (104, 0.9, 0.10, 0.2, 0.02, 120),
+    "walk104":     (104, 1.8, 0.35, 0.3, 0.04, 120),
+    "sprint104":   (104, 3.3, 1.30, 0.8, 0.15, 120),
+    "still104":    (104, 0.0, 0.00, 0.0, 0.02, 120),
+    "walk26":      (26,  1.8, 0.35, 0.3, 0.04, 120),
+}
+
+
+def gait(rng, odr_hz, cadence_hz, amp_g, harmonic, noise_g, seconds):
+    """Return (rows, true_steps); rows are (t_ms, odr_hz, ax, ay, az)."""
+    rows = []
+    lim = 32767
+    for i in range(int(seconds * odr_hz)):
+        t = i / odr_hz
+        w = 2 * math.pi * cadence_hz * t
+        g = 1.0 + amp_g * (math.sin(w) + harmonic * math.sin(2 * w + 0.7)) + rng.gauss(0, noise_g)
+        xyz = [max(-lim, min(lim, int(round(c * g / ACCEL_LSB_G)))) for c in WRIST]
+        rows.append((t * 1000.0, odr_hz, *xyz))
+    return rows, int(cadence_hz * seconds)
+
+
+def write_csv(path, rows, steps):
+    with open(path, "w") as fh:
+        fh.write("# steps=%d\nt_ms,odr_hz,ax,ay,az\n" % steps)
+        for r in rows:
+            fh.write("%.1f,%d,%d,%d,%d\n" % r)
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+            continue
+        block.append(b)
+        if len(block) == 254:
+            out.append(255)
+            out += block
+            block = bytearray()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def write_capture(path, rows):
+    # ACCEL payload: t0_ms u32, odr_hz u16, n u8, flags u8, then n * (x,y,z) i16
+    cap = bytearray(b"boot banner printed before the first frame\n\0")
+    for seq, j in enumerate(range(0, len(rows), ACCEL_MAX_SAMPLES)):
+        chunk = rows[j:j + ACCEL_MAX_SAMPLES]
+        body = struct.pack("<BHIHBB", FRAME_ACCEL, seq & 0xFFFF, int(chunk[0][0]),
+                           chunk[0][1], len(chunk), 0)
+        body += b"".join(struct.pack("<3h", *r[2:]) for r in chunk)
+        cap += cobs_encode(body + struct.pack("<H", crc16_ccitt(body))) + b"\0"
+    with open(path, "wb") as fh:
+        fh.write(cap)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--out", default=".", help="output directory")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--only", action="append", choices=sorted(TRACES), help="trace to write (repeatable)")
+    ap.add_argument("--capture", action="store_true", help="also write each trace as a raw .bin capture")
+    args = ap.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    for name in args.only or TRACES:
+        rng = random.Random("%s/%d" % (name, args.seed))
+        rows, steps = gait(rng, *TRACES[name])
+        write_csv(os.path.join(args.out, name + ".csv"), rows, steps)
+        if args.capture:
+            write_capture(os.path.join(args.out, name + ".bin"), rows)
+        print("%-12s %6d samples  steps=%d" % (name, len(rows), steps))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+"""Decode the tracker's binary USB telemetry (see src/telemetry.h).
+
+Frames are COBS-encoded and 0x00-terminated:
+    [type u8][seq u16][payload][crc16 u16]   (little-endian, CRC-16/CCITT-FALSE)
+
+Usage:
+    telemetry_decode.py /dev/ttyACM0             # live, needs pyserial
+    telemetry_decode.py capture.bin              # replay a raw capture
+    telemetry_decode.py /dev/ttyACM0 --raw out.bin --csv accel.csv --steps steps.csv
+
+Config (src/config.h) over the same link, then keep decoding:
+    telemetry_decode.py /dev/ttyACM0 --config            # print the values
+    telemetry_decode.py /dev/ttyACM0 --set weight_lbs=180 --set step_threshold_mg=300 --save
+    telemetry_decode.py /dev/ttyACM0 --defaults --save
+
+LOG frames (src/log.h) are printed as they arrive. Anything that isn't a
+valid frame (e.g. stray printf text) is echoed as text.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+FRAME_ACCEL = 0x01
+FRAME_STEP = 0x02
+FRAME_STATE = 0x03
+FRAME_LOG = 0x04
+FRAME_PROF = 0x05
+FRAME_CONFIG = 0x06
+FRAME_POWER = 0x07
+
+CMD_CONFIG_GET = 0x80
+CMD_CONFIG_SET = 0x81
+CMD_CONFIG_SAVE = 0x82
+CMD_CONFIG_DEFAULTS = 0x83
+
+# Same order as config_field_t in src/config.h
+CONFIG_FIELDS = ["weight_lbs", "height", "calories_mode", "step_threshold_mg",
+                 "step_min_interval_ms", "step_block_min_peak_mg", "step_block_min_interval_ms",
+                 "step_goal_per_hour", "idle_to_low_s", "display_refresh_ms", "step_flash_ms",
+                 "display_sleep_s", "power_sleep_s"]
+CONFIG_STATUS = ["ok", "no such field", "clamped to range", "flash write failed", "bad command"]
+CONFIG_FLAGS = ["from_flash", "dirty"]
+
+# Same order as prof_zone_t in src/prof.h
+PROF_ZONES = ["imu_update", "battery", "flash_log", "core0_pass",
+              "led_bar", "render_oled", "oled_display", "usb"]
+
+# Same order as power_state_t in src/power.h
+POWER_STATES = ["active", "idle", "dormant"]
+
+LOG_LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+
+STATE_FLAGS = ["imu_ok", "show_calories", "paused", "low_power", "hw_steps"]
+STATE_FMT = "<IIIIHBBH3hIII"
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def build_frame(ftype, seq, payload=b""):
+    body = struct.pack("<BH", ftype, seq & 0xFFFF) + payload
+    return cobs_encode(body + struct.pack("<H", crc16_ccitt(body))) + b"\0"
+
+
+def config_commands(args):
+    """Command frames for the --config/--set/--defaults/--save options, in that order."""
+    frames = []
+    if args.defaults:
+        frames.append((CMD_CONFIG_DEFAULTS, b""))
+    if args.set:
+        payload = b""
+        for item in args.set:
+            name, _, value = item.partition("=")
+            if name not in CONFIG_FIELDS or not value:
+                raise SystemExit("--set wants NAME=VALUE with NAME one of: " + ", ".join(CONFIG_FIELDS))
+            payload += struct.pack("<BH", CONFIG_FIELDS.index(name), int(value, 0))
+        frames.append((CMD_CONFIG_SET, payload))
+    if args.save:
+        frames.append((CMD_CONFIG_SAVE, b""))
+    if args.config and not frames:
+        frames.append((CMD_CONFIG_GET, b""))
+    return [build_frame(t, i, p) for i, (t, p) in enumerate(frames)]
+
+
+def parse_frame(chunk):
+    raw = cobs_decode(chunk)
+    if raw is None or len(raw) < 5:
+        return None
+    body, crc = raw[:-2], struct.unpack("<H", raw[-2:])[0]
+    if crc16_ccitt(body) != crc:
+        return None
+    ftype, seq = body[0], struct.unpack("<H", body[1:3])[0]
+    return ftype, seq, body[3:]
+
+
+class Decoder:
+    def __init__(self, accel_csv=None, steps_csv=None, quiet=False):
+        self.buf = bytearray()
+        self.last_seq = {}
+        self.frames = 0
+        self.lost = 0
+        self.bad = 0
+        self.quiet = quiet
+        self.accel = csv.writer(accel_csv) if accel_csv else None
+        self.steps = csv.writer(steps_csv) if steps_csv else None
+        if self.accel:
+            self.accel.writerow(["t_ms", "odr_hz", "ax", "ay", "az"])
+        if self.steps:
+            self.steps.writerow(["t_ms", "total", "count"])
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            end = self.buf.find(0)
+            if end < 0:
+                return
+            chunk, self.buf = bytes(self.buf[:end]), self.buf[end + 1:]
+            if chunk:
+                self.chunk(chunk)
+
+    def chunk(self, chunk):
+        frame = parse_frame(chunk)
+        if frame is None:
+            # printf text has no 0x00 of its own, so it arrives glued to the
+            # front of the next frame: peel it off line by line
+            nl = chunk.find(b"\n")
+            while nl >= 0 and frame is None:
+                frame = parse_frame(chunk[nl + 1:])
+                if frame is None:
+                    nl = chunk.find(b"\n", nl + 1)
+            text = (chunk[:nl + 1] if frame else chunk).decode("ascii", "replace").strip()
+            if text and all(c.isprintable() or c in "\r\n\t" for c in text):
+                print(text)
+            elif frame is None:
+                self.bad += 1
+            if frame is None:
+                return
+
+        ftype, seq, payload = frame
+        # LOG frames come from core 1 and are numbered on their own
+        stream = ftype == FRAME_LOG
+        if stream in self.last_seq:
+            self.lost += (seq - self.last_seq[stream] - 1) & 0xFFFF
+        self.last_seq[stream] = seq
+        self.frames += 1
+
+        if ftype == FRAME_ACCEL:
+            t0, odr, n, _ = struct.unpack("<IHBB", payload[:8])
+            samples = struct.unpack("<%dh" % (3 * n), payload[8:8 + 6 * n])
+            if self.accel:
+                for i in range(n):
+                    t = t0 + (i * 1000.0) / odr
+                    self.accel.writerow(["%.1f" % t, odr] + list(samples[3 * i:3 * i + 3]))
+        elif ftype == FRAME_STEP:
+            t, total, count = struct.unpack("<IIB", payload)
+            if self.steps:
+                self.steps.writerow([t, total, count])
+            if not self.quiet:
+                print("STEP t=%dms total=%d (+%d)" % (t, total, count))
+        elif ftype == FRAME_STATE:
+            (t, steps, total, cal, soc_x10, batt, flags, odr,
+             ax, ay, az, overruns, i2c_err, i2c_fail) = struct.unpack(STATE_FMT, payload)
+            names = [n for i, n in enumerate(STATE_FLAGS) if flags & (1 << i)]
+            if not self.quiet:
+                print("state t=%dms steps=%d total=%d cal=%d soc=%.1f%% batt=%d%% odr=%dHz "
+                      "raw=(%d,%d,%d) ovr=%d i2c_err=%d i2c_fail=%d lost=%d [%s]"
+                      % (t, steps, total, cal, soc_x10 / 10.0, batt, odr, ax, ay, az,
+                         overruns, i2c_err, i2c_fail, self.lost, ",".join(names)))
+        elif ftype == FRAME_LOG:
+            t_us, level = struct.unpack("<IB", payload[:5])
+            text = payload[5:].decode("utf-8", "replace")
+            print("[%10.3f] %s %s" % (t_us / 1e6, LOG_LEVELS.get(level, "?"), text))
+        elif ftype == FRAME_PROF:
+            cyc, misses, gap, n = struct.unpack("<HIIB", payload[:11])
+            if not self.quiet:
+                print("prof deadline_misses=%d worst_gap=%dms (us: count min/mean/p99/max)" % (misses, gap))
+                for i in range(n):
+                    count, mn, mx, mean, p99 = struct.unpack("<5I", payload[11 + 20 * i:31 + 20 * i])
+                    if count == 0:
+                        continue
+                    name = PROF_ZONES[i] if i < len(PROF_ZONES) else "zone%d" % i
+                    print("  %-12s %6d  %8.1f %8.1f %8.1f %8.1f"
+                          % (name, count, mn / cyc, mean / cyc, p99 / cyc, mx / cyc))
+        elif ftype == FRAME_CONFIG:
+            status, flags, version, n = struct.unpack("<BBHB", payload[:5])
+            values = struct.unpack("<%dH" % n, payload[5:5 + 2 * n])
+            names = [f for i, f in enumerate(CONFIG_FLAGS) if flags & (1 << i)]
+            print("config v%d: %s [%s]" % (version, CONFIG_STATUS[status] if status < len(CONFIG_STATUS)
+                                          else "status %d" % status, ",".join(names)))
+            for i, v in enumerate(values):
+                name = CONFIG_FIELDS[i] if i < len(CONFIG_FIELDS) else "field%d" % i
+                print("  %-28s %d" % (name, v))
+        elif ftype == FRAME_POWER:
+            state, n = struct.unpack("<BB", payload[:2])
+            if not self.quiet:
+                names = POWER_STATES + ["state%d" % i for i in range(len(POWER_STATES), n)]
+                total = sum(struct.unpack("<I", payload[2 + 8 * i:6 + 8 * i])[0] for i in range(n)) or 1
+                parts = []
+                for i in range(n):
+                    ms, entries = struct.unpack("<II", payload[2 + 8 * i:10 + 8 * i])
+                    parts.append("%s=%.1fs (%.1f%%, %dx)" % (names[i], ms / 1000.0, 100.0 * ms / total, entries))
+                print("power now=%s %s" % (names[state] if state < len(names) else state, " ".join(parts)))
+        elif not self.quiet:
+            print("unknown frame type 0x%02x seq=%d len=%d" % (ftype, seq, len(payload)))
+
+
+def open_source(path, baud):
+    """(read, write) for a serial port or a capture file (write is None)."""
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial  # pyserial
+
+        port = serial.Serial(path, baud, timeout=0.1)
+        return (lambda: port.read(4096)), port.write
+    f = open(path, "rb")
+    return (lambda: f.read(4096) or None), None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="serial port or raw capture file")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--raw", type=argparse.FileType("wb"), help="also save the raw byte stream")
+    ap.add_argument("--csv", type=argparse.FileType("w"), help="write accel samples as CSV")
+    ap.add_argument("--steps", type=argparse.FileType("w"), help="write step events as CSV")
+    ap.add_argument("-q", "--quiet", action="store_true", help="don't print state/step lines")
+    ap.add_argument("--config", action="store_true", help="ask for the config values")
+    ap.add_argument("--set", action="append", metavar="NAME=VALUE", help="change a config value (RAM)")
+    ap.add_argument("--save", action="store_true", help="write the config to flash")
+    ap.add_argument("--defaults", action="store_true", help="reset the config to build defaults (RAM)")
+    args = ap.parse_args()
+
+    read, write = open_source(args.source, args.baud)
+    commands = config_commands(args)
+    if commands:
+        if write is None:
+            raise SystemExit("config commands need a serial port")
+        for frame in commands:
+            write(frame)
+    dec = Decoder(args.csv, args.steps, args.quiet)
+    try:
+        while True:
+            data = read()
+            if data is None:
+                break
+            if args.raw:
+                args.raw.write(data)
+            dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    print("%d frames, %d lost, %d corrupt" % (dec.frames, dec.lost, dec.bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()